@@ -28,15 +28,46 @@ FCapsuleProxy::FCapsuleProxy(const FVector& InStart, const FVector& InEnd, const
 {
 }
 
-FCapsuleProxy::FCapsuleProxy(const FKSphylElem& InCapsuleElement, const FTransform& InTransform) 
+/**
+ * Creates a capsule from an element in a component's local space
+ * Radius and length are scaled by the transform's smallest absolute scale, as spheres are
+ * @param InCapsuleElement The capsule element in the component's local space
+ * @param InTransform The component's world transform
+ */
+FCapsuleProxy::FCapsuleProxy(const FKSphylElem& InCapsuleElement, const FTransform& InTransform)
 {
-	Radius = InCapsuleElement.Radius;
+	const double Scale = InTransform.GetScale3D().GetAbsMin();
+
+	Radius = InCapsuleElement.Radius * Scale;
 	
 	const FVector CapsuleCenter = InTransform.TransformPosition(InCapsuleElement.Center);
-	const double CapsuleHalfHeight = InCapsuleElement.Length / 2;
+	const double CapsuleHalfHeight = InCapsuleElement.Length * Scale / 2;
+
+	// The element's axis is rotated into the component first, then into the world, and mirrored for both end points
+	const FVector Axis = InTransform.TransformVectorNoScale(InCapsuleElement.Rotation.RotateVector(FVector::UpVector));
+	const FVector HalfAxis = Axis * CapsuleHalfHeight;
+
+	Start = CapsuleCenter + HalfAxis;
+	End = CapsuleCenter - HalfAxis;
+}
+
+/**
+ * Get the capsules for an array of capsule elements sharing the same transform
+ * @param CapsuleElements The capsule elements in the component's local space
+ * @param InTransform The component's world transform
+ * @return The capsules, one per element
+ */
+TArray<FCapsuleProxy> FCapsuleProxy::GetCapsules(const TArray<FKSphylElem>& CapsuleElements, const FTransform& InTransform)
+{
+	TArray<FCapsuleProxy> Capsules;
+	Capsules.Reserve(CapsuleElements.Num());
+
+	for(const FKSphylElem& CapsuleElement : CapsuleElements)
+	{
+		Capsules.Add(FCapsuleProxy(CapsuleElement, InTransform));
+	}
 
-	Start = CapsuleCenter + (InCapsuleElement.Rotation.RotateVector(InTransform.GetRotation().GetUpVector()) * CapsuleHalfHeight);
-	End = CapsuleCenter - (InCapsuleElement.Rotation.RotateVector(InTransform.GetRotation().GetUpVector()) * CapsuleHalfHeight);
+	return Capsules;
 }
 
 bool FCapsuleProxy::Intersects(const FBox& Other) const
@@ -44,6 +44,51 @@ FOOBBoxProxy::FOOBBoxProxy(const FBox& LocalBounds, const FTransform& InstanceTr
 	Extents = LocalBounds.GetExtent() * Scale3D;
 
 	bSlerpRotation = InSlerpRotation;
+
+	UpdateAxes();
+}
+
+/**
+ * Creates an OBB from a box collision element
+ * @param BoxElement The box element in the component's local space
+ * @param InstanceTransform The component's world transform
+ */
+FOOBBoxProxy::FOOBBoxProxy(const FKBoxElem& BoxElement, const FTransform& InstanceTransform)
+	: FOOBBoxProxy(FBox::BuildAABB(FVector::ZeroVector, FVector(BoxElement.X, BoxElement.Y, BoxElement.Z) * 0.5),
+		BoxElement.GetTransform() * InstanceTransform)
+{
+}
+
+/**
+ * Get the OBBs for an array of box elements sharing the same instance transform
+ * @param BoxElements The box elements in the component's local space
+ * @param InstanceTransform The component's world transform
+ * @return The OBBs, one per element
+ */
+TArray<FOOBBoxProxy> FOOBBoxProxy::GetBoxes(const TArray<FKBoxElem>& BoxElements, const FTransform& InstanceTransform)
+{
+	TArray<FOOBBoxProxy> Boxes;
+	Boxes.Reserve(BoxElements.Num());
+
+	for(const FKBoxElem& BoxElement : BoxElements)
+	{
+		Boxes.Emplace(BoxElement, InstanceTransform);
+	}
+
+	return Boxes;
+}
+
+/**
+ * Rebuild the cached axes from the orientation
+ * One quaternion to matrix conversion instead of a quaternion rotation per axis per query
+ */
+void FOOBBoxProxy::UpdateAxes()
+{
+	const FMatrix RotationMatrix = Orientation.ToMatrix();
+	
+	Axes[0] = RotationMatrix.GetScaledAxis(EAxis::X);
+	Axes[1] = RotationMatrix.GetScaledAxis(EAxis::Y);
+	Axes[2] = RotationMatrix.GetScaledAxis(EAxis::Z);
 }
 
 /**
@@ -54,9 +99,9 @@ FOOBBoxProxy::FOOBBoxProxy(const FBox& LocalBounds, const FTransform& InstanceTr
  */
 void FOOBBoxProxy::GetAxis(FVector& OutAxisX, FVector& OutAxisY, FVector& OutAxisZ) const
 {
-	OutAxisX = Orientation.GetAxisX();
-	OutAxisY = Orientation.GetAxisY();
-	OutAxisZ = Orientation.GetAxisZ();
+	OutAxisX = Axes[0];
+	OutAxisY = Axes[1];
+	OutAxisZ = Axes[2];
 }
 
 /**
@@ -98,17 +143,15 @@ FOOBBoxProxy& FOOBBoxProxy::operator+=(const FOOBBoxProxy& Other)
 	TArray<FVector> OtherCorners;
 	Other.GetCorners(OtherCorners);
 
-	// Inverse rotation to transform into local space
-	const FQuat InverseOrientation = Orientation.Inverse();
-
 	// Store min and max extents in local space
 	FVector MinExtents = -Extents;
 	FVector MaxExtents = Extents;
 
 	for (const FVector& Corner : OtherCorners)
 	{
-		// Vector from this OBB's center to the corner
-		FVector LocalVec = InverseOrientation.RotateVector(Corner - Center);
+		// Vector from this OBB's center to the corner, projected onto the axes (inverse rotation)
+		const FVector Offset = Corner - Center;
+		const FVector LocalVec(Offset.Dot(Axes[0]), Offset.Dot(Axes[1]), Offset.Dot(Axes[2]));
 
 		// Update min and max extents
 		MinExtents = MinExtents.ComponentMin(LocalVec);
@@ -123,7 +166,7 @@ FOOBBoxProxy& FOOBBoxProxy::operator+=(const FOOBBoxProxy& Other)
 	const FVector LocalCenterOffset = (MaxExtents + MinExtents) * 0.5f;
 
 	// Update the center in world space
-	Center = Center + Orientation.RotateVector(LocalCenterOffset);
+	Center = Center + Axes[0] * LocalCenterOffset.X + Axes[1] * LocalCenterOffset.Y + Axes[2] * LocalCenterOffset.Z;
 
 	// Update extents
 	Extents = NewExtents;
@@ -133,6 +176,7 @@ FOOBBoxProxy& FOOBBoxProxy::operator+=(const FOOBBoxProxy& Other)
 	{
 		const FQuat CombinedQuat = FQuat::Slerp(this->Orientation, Other.Orientation, 0.5f);
 		Orientation = CombinedQuat;
+		UpdateAxes();
 	}
 
 	return *this;
@@ -146,7 +190,8 @@ FOOBBoxProxy& FOOBBoxProxy::operator+=(const FOOBBoxProxy& Other)
 bool FOOBBoxProxy::IsInsideOrOn(const FVector& Point) const
 {
 	// Transform the point to the OBB's local space
-	const FVector LocalPoint = Orientation.UnrotateVector(Point - Center);
+	const FVector Offset = Point - Center;
+	const FVector LocalPoint(Offset.Dot(Axes[0]), Offset.Dot(Axes[1]), Offset.Dot(Axes[2]));
 
 	// Check if the point lies within the extents
 	return FMath::Abs(LocalPoint.X) <= Extents.X &&
@@ -197,12 +242,9 @@ bool FOOBBoxProxy::IsInsideOrOn(const FBox& Other) const
 bool FOOBBoxProxy::Intersect(const FOOBBoxProxy& Other) const
 {
 	// Use the Separating Axis Theorem (SAT)
-	// Step 1: Get the axes of both OBBs
-	FVector AxesA[3];
-	this->GetAxis(AxesA[0], AxesA[1], AxesA[2]);
-
-	FVector AxesB[3];
-	Other.GetAxis(AxesB[0], AxesB[1], AxesB[2]);
+	// Step 1: Get the cached axes of both OBBs
+	const FVector* AxesA = this->Axes;
+	const FVector* AxesB = Other.Axes;
 
 	// Step 2: Compute the rotation matrix expressing Other in A's coordinate frame
 	float R[3][3];
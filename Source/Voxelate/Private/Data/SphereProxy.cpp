@@ -32,6 +32,38 @@ FSphereProxy::FSphereProxy(const FKSphereElem& SphereElement) : Center(SphereEle
 {
 }
 
+/**
+ * Creates a sphere from an element in a component's local space
+ * The radius is scaled by the transform's smallest absolute scale so the sphere never grows past a non-uniformly scaled element
+ * @param SphereElement The sphere element in the component's local space
+ * @param InTransform The component's world transform
+ */
+FSphereProxy::FSphereProxy(const FKSphereElem& SphereElement, const FTransform& InTransform)
+	: Center(InTransform.TransformPosition(SphereElement.Center)), Radius(SphereElement.Radius * InTransform.GetScale3D().GetAbsMin())
+{
+}
+
+/**
+ * Get the spheres for an array of sphere elements sharing the same transform
+ * @param SphereElements The sphere elements in the component's local space
+ * @param InTransform The component's world transform
+ * @return The spheres, one per element
+ */
+TArray<FSphereProxy> FSphereProxy::GetSpheres(const TArray<FKSphereElem>& SphereElements, const FTransform& InTransform)
+{
+	const double RadiusScale = InTransform.GetScale3D().GetAbsMin();
+	
+	TArray<FSphereProxy> Spheres;
+	Spheres.Reserve(SphereElements.Num());
+
+	for(const FKSphereElem& SphereElement : SphereElements)
+	{
+		Spheres.Add(FSphereProxy(InTransform.TransformPosition(SphereElement.Center), SphereElement.Radius * RadiusScale));
+	}
+
+	return Spheres;
+}
+
 bool FSphereProxy::Intersects(const FBox& Other) const
 {
 	return FMath::SphereAABBIntersection(Center, FMath::Square(Radius), Other);
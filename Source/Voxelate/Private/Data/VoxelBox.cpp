@@ -0,0 +1,187 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Data/VoxelBox.h"
+
+/**
+ * Struct constructor
+ * @param InMin The first coordinate in the box (inclusive)
+ * @param InMax The last coordinate in the box (exclusive)
+ */
+FVoxelBox::FVoxelBox(const FIntVector& InMin, const FIntVector& InMax) : Min(InMin), Max(InMax)
+{
+}
+
+/**
+ * Creates a box holding a single voxel
+ * @param InCoordinate The voxel coordinate
+ * @return The box
+ */
+FVoxelBox FVoxelBox::FromCoordinate(const FIntVector& InCoordinate)
+{
+	return FVoxelBox(InCoordinate, InCoordinate + FIntVector(1));
+}
+
+/**
+ * Checks if the box holds no voxels
+ * @return true if the box is empty
+ */
+bool FVoxelBox::IsEmpty() const
+{
+	return Max.X <= Min.X || Max.Y <= Min.Y || Max.Z <= Min.Z;
+}
+
+/**
+ * Gets the number of voxels in each dimension
+ * @return The size, zero for every axis if the box is empty
+ */
+FIntVector FVoxelBox::GetSize() const
+{
+	return IsEmpty() ? FIntVector::ZeroValue : Max - Min;
+}
+
+/**
+ * Gets the total number of voxels in the box
+ * @return The number of voxels
+ */
+int32 FVoxelBox::Num() const
+{
+	const FIntVector Size = GetSize();
+
+	return Size.X * Size.Y * Size.Z;
+}
+
+/**
+ * Checks if a coordinate is inside the box
+ * @param InCoordinate The coordinate to check
+ * @return true if the coordinate is inside
+ */
+bool FVoxelBox::Contains(const FIntVector& InCoordinate) const
+{
+	return InCoordinate.X >= Min.X && InCoordinate.X < Max.X &&
+		InCoordinate.Y >= Min.Y && InCoordinate.Y < Max.Y &&
+		InCoordinate.Z >= Min.Z && InCoordinate.Z < Max.Z;
+}
+
+/**
+ * Checks if another box is entirely inside this box
+ * @param Other The box to check
+ * @return true if every voxel of the other box is inside, always true for an empty box
+ */
+bool FVoxelBox::Contains(const FVoxelBox& Other) const
+{
+	return Other.IsEmpty() || (Other.Min.X >= Min.X && Other.Max.X <= Max.X &&
+		Other.Min.Y >= Min.Y && Other.Max.Y <= Max.Y &&
+		Other.Min.Z >= Min.Z && Other.Max.Z <= Max.Z);
+}
+
+/**
+ * Checks if two boxes share any voxel
+ * @param Other The box to check
+ * @return true if the boxes overlap
+ */
+bool FVoxelBox::Intersects(const FVoxelBox& Other) const
+{
+	return !Intersect(Other).IsEmpty();
+}
+
+/**
+ * Gets the voxels shared by both boxes
+ * @param Other The other box
+ * @return The overlap, empty if the boxes are disjoint
+ */
+FVoxelBox FVoxelBox::Intersect(const FVoxelBox& Other) const
+{
+	return FVoxelBox(
+		FIntVector(FMath::Max(Min.X, Other.Min.X), FMath::Max(Min.Y, Other.Min.Y), FMath::Max(Min.Z, Other.Min.Z)),
+		FIntVector(FMath::Min(Max.X, Other.Max.X), FMath::Min(Max.Y, Other.Max.Y), FMath::Min(Max.Z, Other.Max.Z)));
+}
+
+/**
+ * Gets the smallest box holding both boxes
+ * @param Other The other box
+ * @return The union, empty boxes are ignored
+ */
+FVoxelBox FVoxelBox::Union(const FVoxelBox& Other) const
+{
+	if(IsEmpty())
+	{
+		return Other;
+	}
+
+	if(Other.IsEmpty())
+	{
+		return *this;
+	}
+
+	return FVoxelBox(
+		FIntVector(FMath::Min(Min.X, Other.Min.X), FMath::Min(Min.Y, Other.Min.Y), FMath::Min(Min.Z, Other.Min.Z)),
+		FIntVector(FMath::Max(Max.X, Other.Max.X), FMath::Max(Max.Y, Other.Max.Y), FMath::Max(Max.Z, Other.Max.Z)));
+}
+
+/**
+ * Grows the box by the same amount on every side
+ * @param InAmount The number of voxels to add on each side, negative to shrink
+ * @return The expanded box
+ */
+FVoxelBox FVoxelBox::Expand(const int32 InAmount) const
+{
+	return Expand(FIntVector(InAmount));
+}
+
+/**
+ * Grows the box by a per axis amount on both sides
+ * @param InAmount The number of voxels to add on each side, negative to shrink
+ * @return The expanded box
+ */
+FVoxelBox FVoxelBox::Expand(const FIntVector& InAmount) const
+{
+	return FVoxelBox(Min - InAmount, Max + InAmount);
+}
+
+/**
+ * Moves the box
+ * @param InOffset The offset to move by
+ * @return The moved box
+ */
+FVoxelBox FVoxelBox::Translate(const FIntVector& InOffset) const
+{
+	return FVoxelBox(Min + InOffset, Max + InOffset);
+}
+
+bool FVoxelBox::operator==(const FVoxelBox& Other) const
+{
+	return Min == Other.Min && Max == Other.Max;
+}
+
+bool FVoxelBox::operator!=(const FVoxelBox& Other) const
+{
+	return !(*this == Other);
+}
+
+FString FVoxelBox::ToString() const
+{
+	return FString::Printf(TEXT("Min=(%s) Max=(%s)"), *Min.ToString(), *Max.ToString());
+}
@@ -0,0 +1,569 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Data/VoxelChunkStore.h"
+
+#include "Async/ParallelFor.h"
+
+/**
+ * Checks if every voxel of the chunk is empty
+ * @return true if the chunk is empty
+ */
+bool FVoxelChunk::IsEmpty() const
+{
+	for(const uint64 Word : Words)
+	{
+		if(Word != 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Class constructor, every chunk starts empty
+ * @param InGrid The grid the chunks cover
+ */
+FVoxelChunkMap::FVoxelChunkMap(const FVoxelGrid& InGrid) : Grid(InGrid)
+{
+	const FIntVector Count = Grid.GetVectorVoxelCount();
+
+	ChunkCount = FIntVector(
+		FMath::DivideAndRoundUp(Count.X, FVoxelChunk::ChunkSize),
+		FMath::DivideAndRoundUp(Count.Y, FVoxelChunk::ChunkSize),
+		FMath::DivideAndRoundUp(Count.Z, FVoxelChunk::ChunkSize));
+
+	Chunks.SetNum(GetNumChunks());
+	OwnedChunks.SetNumZeroed(GetNumChunks());
+}
+
+const FVoxelGrid& FVoxelChunkMap::GetGrid() const
+{
+	return Grid;
+}
+
+/**
+ * Gets the version of the map, unique within its store
+ * @return The version, 0 for an edit that hasn't been committed yet
+ */
+int64 FVoxelChunkMap::GetVersion() const
+{
+	return Version;
+}
+
+/**
+ * Gets the version an edit started from
+ * @return The base version, null once the edit is published or for a map that isn't an edit
+ */
+const TSharedPtr<const FVoxelChunkMap, ESPMode::ThreadSafe>& FVoxelChunkMap::GetBaseVersion() const
+{
+	return BaseVersion;
+}
+
+FIntVector FVoxelChunkMap::GetChunkCount() const
+{
+	return ChunkCount;
+}
+
+int32 FVoxelChunkMap::GetNumChunks() const
+{
+	return ChunkCount.X * ChunkCount.Y * ChunkCount.Z;
+}
+
+int32 FVoxelChunkMap::GetChunkIndex(const FIntVector& InChunkCoordinate) const
+{
+	checkf(InChunkCoordinate.X >= 0 && InChunkCoordinate.X < ChunkCount.X &&
+		InChunkCoordinate.Y >= 0 && InChunkCoordinate.Y < ChunkCount.Y &&
+		InChunkCoordinate.Z >= 0 && InChunkCoordinate.Z < ChunkCount.Z, TEXT("Invalid chunk coordinate %s"), *InChunkCoordinate.ToString());
+
+	return InChunkCoordinate.X + (InChunkCoordinate.Y + InChunkCoordinate.Z * ChunkCount.Y) * ChunkCount.X;
+}
+
+FIntVector FVoxelChunkMap::GetChunkCoordinate(const int32 InChunkIndex) const
+{
+	checkf(InChunkIndex >= 0 && InChunkIndex < GetNumChunks(), TEXT("Invalid chunk index %d"), InChunkIndex);
+
+	return FIntVector(InChunkIndex % ChunkCount.X, (InChunkIndex / ChunkCount.X) % ChunkCount.Y, InChunkIndex / (ChunkCount.X * ChunkCount.Y));
+}
+
+/**
+ * Gets the box of voxels covered by a chunk, clamped to the grid
+ * @param InChunkCoordinate The chunk coordinate
+ * @return The voxel box
+ */
+FVoxelBox FVoxelChunkMap::GetChunkBox(const FIntVector& InChunkCoordinate) const
+{
+	const FIntVector Min = InChunkCoordinate * FVoxelChunk::ChunkSize;
+
+	return FVoxelBox(Min, Min + FIntVector(FVoxelChunk::ChunkSize)).Intersect(Grid.GetVoxelBox());
+}
+
+/**
+ * Gets a chunk for reading
+ * @param InChunkCoordinate The chunk coordinate
+ * @return The chunk, null if the chunk is empty
+ */
+const FVoxelChunk* FVoxelChunkMap::GetChunk(const FIntVector& InChunkCoordinate) const
+{
+	return Chunks[GetChunkIndex(InChunkCoordinate)].Get();
+}
+
+/**
+ * Gets a chunk for writing, cloning it the first time this map writes to it
+ * Different chunks may be written from different threads
+ * @param InChunkCoordinate The chunk coordinate
+ * @return The chunk, owned by this map only
+ */
+FVoxelChunk& FVoxelChunkMap::GetMutableChunk(const FIntVector& InChunkCoordinate)
+{
+	checkf(!bPublished, TEXT("Published chunk maps are immutable, begin a new edit instead"));
+
+	const int32 ChunkIndex = GetChunkIndex(InChunkCoordinate);
+
+	if(!OwnedChunks[ChunkIndex])
+	{
+		const FChunkPtr& Shared = Chunks[ChunkIndex];
+		Chunks[ChunkIndex] = Shared ? MakeShared<FVoxelChunk, ESPMode::ThreadSafe>(*Shared) : MakeShared<FVoxelChunk, ESPMode::ThreadSafe>();
+		OwnedChunks[ChunkIndex] = true;
+	}
+
+	return *Chunks[ChunkIndex];
+}
+
+/**
+ * Empties a chunk without cloning it
+ * @param InChunkCoordinate The chunk coordinate
+ */
+void FVoxelChunkMap::ClearChunk(const FIntVector& InChunkCoordinate)
+{
+	checkf(!bPublished, TEXT("Published chunk maps are immutable, begin a new edit instead"));
+
+	const int32 ChunkIndex = GetChunkIndex(InChunkCoordinate);
+
+	Chunks[ChunkIndex].Reset();
+	OwnedChunks[ChunkIndex] = false;
+}
+
+/**
+ * Checks if a voxel is occupied, the coordinate must be valid
+ * @param InCoordinate The voxel coordinate
+ * @return true if the voxel is occupied
+ */
+bool FVoxelChunkMap::IsOccupied(const FIntVector& InCoordinate) const
+{
+	checkSlow(Grid.IsVoxelCoordinateValid(InCoordinate));
+
+	const FIntVector ChunkCoordinate = InCoordinate / FVoxelChunk::ChunkSize;
+	const FVoxelChunk* Chunk = GetChunk(ChunkCoordinate);
+
+	return Chunk && Chunk->IsOccupied(InCoordinate - ChunkCoordinate * FVoxelChunk::ChunkSize);
+}
+
+/**
+ * Sets or clears the occupancy of a voxel, the coordinate must be valid
+ * Clearing a voxel of an empty chunk doesn't allocate the chunk
+ * @param InCoordinate The voxel coordinate
+ * @param bOccupied The new occupancy
+ */
+void FVoxelChunkMap::SetOccupied(const FIntVector& InCoordinate, const bool bOccupied)
+{
+	checkSlow(Grid.IsVoxelCoordinateValid(InCoordinate));
+
+	const FIntVector ChunkCoordinate = InCoordinate / FVoxelChunk::ChunkSize;
+
+	if(!bOccupied && !GetChunk(ChunkCoordinate))
+	{
+		return;
+	}
+
+	GetMutableChunk(ChunkCoordinate).SetOccupied(InCoordinate - ChunkCoordinate * FVoxelChunk::ChunkSize, bOccupied);
+}
+
+/**
+ * Counts the occupied voxels in a box, empty chunks are skipped and rows are masked and counted a word at a time
+ * @param InVoxelBox The voxel box, the part outside the grid counts as empty
+ * @return The number of occupied voxels
+ */
+int32 FVoxelChunkMap::CountOccupied(const FVoxelBox& InVoxelBox) const
+{
+	const FVoxelBox Box = InVoxelBox.Intersect(Grid.GetVoxelBox());
+
+	if(Box.IsEmpty())
+	{
+		return 0;
+	}
+
+	const FIntVector FirstChunk = Box.Min / FVoxelChunk::ChunkSize;
+	const FIntVector LastChunk = (Box.Max - FIntVector(1)) / FVoxelChunk::ChunkSize;
+
+	int32 Count = 0;
+
+	for(int32 ChunkZ = FirstChunk.Z; ChunkZ <= LastChunk.Z; ChunkZ++)
+	{
+		for(int32 ChunkY = FirstChunk.Y; ChunkY <= LastChunk.Y; ChunkY++)
+		{
+			for(int32 ChunkX = FirstChunk.X; ChunkX <= LastChunk.X; ChunkX++)
+			{
+				const FIntVector ChunkCoordinate(ChunkX, ChunkY, ChunkZ);
+				const FVoxelChunk* Chunk = GetChunk(ChunkCoordinate);
+
+				if(!Chunk)
+				{
+					continue;
+				}
+
+				const FIntVector ChunkMin = ChunkCoordinate * FVoxelChunk::ChunkSize;
+				const FVoxelBox Local = Box.Intersect(GetChunkBox(ChunkCoordinate)).Translate(-ChunkMin);
+				const uint64 Mask = (~uint64(0) << Local.Min.X) & (~uint64(0) >> (FVoxelChunk::ChunkSize - Local.Max.X));
+
+				for(int32 Z = Local.Min.Z; Z < Local.Max.Z; Z++)
+				{
+					for(int32 Y = Local.Min.Y; Y < Local.Max.Y; Y++)
+					{
+						Count += FMath::CountBits(Chunk->Words[Y + Z * FVoxelChunk::ChunkSize] & Mask);
+					}
+				}
+			}
+		}
+	}
+
+	return Count;
+}
+
+/**
+ * Replaces every chunk with the chunks of an occupancy on the same grid, chunks are copied in parallel
+ * @param InOccupancy The occupancy to copy
+ */
+void FVoxelChunkMap::CopyFrom(const FVoxelOccupancy& InOccupancy)
+{
+	checkf(!bPublished, TEXT("Published chunk maps are immutable, begin a new edit instead"));
+	checkf(InOccupancy.GetGrid() == Grid, TEXT("Occupancy doesn't match the chunk map's grid"));
+
+	const uint64* Words = InOccupancy.GetWords().GetData();
+
+	ParallelFor(GetNumChunks(), [this, &InOccupancy, Words](const int32 ChunkIndex)
+	{
+		const FIntVector ChunkCoordinate = GetChunkCoordinate(ChunkIndex);
+
+		if(InOccupancy.IsChunkEmpty(ChunkCoordinate))
+		{
+			Chunks[ChunkIndex].Reset();
+			OwnedChunks[ChunkIndex] = false;
+			return;
+		}
+
+		FVoxelChunk& Chunk = GetMutableChunk(ChunkCoordinate);
+		const FVoxelBox ChunkBox = GetChunkBox(ChunkCoordinate);
+
+		for(int32 Z = ChunkBox.Min.Z; Z < ChunkBox.Max.Z; Z++)
+		{
+			for(int32 Y = ChunkBox.Min.Y; Y < ChunkBox.Max.Y; Y++)
+			{
+				Chunk.Words[(Y - ChunkBox.Min.Y) + (Z - ChunkBox.Min.Z) * FVoxelChunk::ChunkSize] =
+					Words[InOccupancy.GetRowWordIndex(Y, Z) + ChunkCoordinate.X];
+			}
+		}
+	});
+}
+
+/**
+ * Copies every chunk into a dense occupancy, chunks are copied in parallel
+ * @return The occupancy
+ */
+FVoxelOccupancy FVoxelChunkMap::ToOccupancy() const
+{
+	FVoxelOccupancy Occupancy(Grid);
+
+	ParallelFor(GetNumChunks(), [this, &Occupancy](const int32 ChunkIndex)
+	{
+		if(Chunks[ChunkIndex])
+		{
+			CopyChunkTo(GetChunkCoordinate(ChunkIndex), Occupancy);
+		}
+	});
+
+	return Occupancy;
+}
+
+/**
+ * Overwrites a chunk of a dense occupancy with this map's chunk
+ * Different chunks may be copied from different threads
+ * @param InChunkCoordinate The chunk coordinate
+ * @param OutOccupancy The occupancy to write to, must share the map's grid
+ */
+void FVoxelChunkMap::CopyChunkTo(const FIntVector& InChunkCoordinate, FVoxelOccupancy& OutOccupancy) const
+{
+	checkf(OutOccupancy.GetGrid() == Grid, TEXT("Occupancy doesn't match the chunk map's grid"));
+
+	const FVoxelChunk* Chunk = GetChunk(InChunkCoordinate);
+	const FVoxelBox ChunkBox = GetChunkBox(InChunkCoordinate);
+	uint64* Words = OutOccupancy.GetWords().GetData();
+
+	for(int32 Z = ChunkBox.Min.Z; Z < ChunkBox.Max.Z; Z++)
+	{
+		for(int32 Y = ChunkBox.Min.Y; Y < ChunkBox.Max.Y; Y++)
+		{
+			Words[OutOccupancy.GetRowWordIndex(Y, Z) + InChunkCoordinate.X] =
+				Chunk ? Chunk->Words[(Y - ChunkBox.Min.Y) + (Z - ChunkBox.Min.Z) * FVoxelChunk::ChunkSize] : 0;
+		}
+	}
+}
+
+/**
+ * Gets the chunks that differ from another version of the same store
+ * Chunks are compared by pointer, so this is cheap but may report a chunk that was cloned and left unchanged
+ * @param Other The other version
+ * @return The coordinates of the chunks that differ
+ */
+TArray<FIntVector> FVoxelChunkMap::GetChangedChunks(const FVoxelChunkMap& Other) const
+{
+	checkf(Other.Grid == Grid, TEXT("Chunk maps don't share a grid"));
+
+	TArray<FIntVector> Changed;
+
+	for(int32 ChunkIndex = 0; ChunkIndex < Chunks.Num(); ChunkIndex++)
+	{
+		if(Chunks[ChunkIndex] != Other.Chunks[ChunkIndex])
+		{
+			Changed.Add(GetChunkCoordinate(ChunkIndex));
+		}
+	}
+
+	return Changed;
+}
+
+/**
+ * Class constructor, the store starts with a single empty version
+ * @param InGrid The grid the store covers
+ * @param InMaxHistory Number of replaced versions kept for undo
+ */
+FVoxelChunkStore::FVoxelChunkStore(const FVoxelGrid& InGrid, const int32 InMaxHistory) : MaxHistory(FMath::Max(InMaxHistory, 0))
+{
+	const TSharedRef<FVoxelChunkMap, ESPMode::ThreadSafe> Map = MakeShared<FVoxelChunkMap, ESPMode::ThreadSafe>(InGrid);
+	Map->Version = NextVersion++;
+	Map->bPublished = true;
+
+	Current = Map;
+	CurrentMap.store(&Map.Get());
+}
+
+/**
+ * Class constructor, the store starts with a copy of an occupancy
+ * @param InOccupancy The occupancy to copy
+ * @param InMaxHistory Number of replaced versions kept for undo
+ */
+FVoxelChunkStore::FVoxelChunkStore(const FVoxelOccupancy& InOccupancy, const int32 InMaxHistory) : MaxHistory(FMath::Max(InMaxHistory, 0))
+{
+	const TSharedRef<FVoxelChunkMap, ESPMode::ThreadSafe> Map = MakeShared<FVoxelChunkMap, ESPMode::ThreadSafe>(InOccupancy.GetGrid());
+	Map->CopyFrom(InOccupancy);
+	Map->Version = NextVersion++;
+	Map->bPublished = true;
+
+	Current = Map;
+	CurrentMap.store(&Map.Get());
+}
+
+/**
+ * Gets the current version, it never changes so it can be read without any lock for as long as it is held
+ * Prefer a read scope for short reads, taking a snapshot locks the store briefly and adds a reference
+ * @return The current version
+ */
+FVoxelChunkStore::FMapPtr FVoxelChunkStore::GetSnapshot() const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	return Current;
+}
+
+int64 FVoxelChunkStore::GetVersion() const
+{
+	return GetSnapshot()->GetVersion();
+}
+
+/**
+ * Begins an edit on top of the current version
+ * The edit shares every chunk with the current version until it writes to it
+ * @return The edit, commit it to publish it
+ */
+FVoxelChunkStore::FEditPtr FVoxelChunkStore::BeginEdit() const
+{
+	const FMapPtr Base = GetSnapshot();
+
+	const FEditPtr Edit = MakeShared<FVoxelChunkMap, ESPMode::ThreadSafe>(Base->Grid);
+	Edit->Chunks = Base->Chunks;
+	Edit->BaseVersion = Base;
+
+	return Edit;
+}
+
+/**
+ * Publishes an edit as the current version, the replaced version goes to the undo history
+ * Fails if another edit was committed, or an undo or redo happened, after the edit began
+ * The edit must not be written to after it was committed
+ * @param InEdit The edit
+ * @return true if the edit was published
+ */
+bool FVoxelChunkStore::Commit(const FEditPtr& InEdit)
+{
+	checkf(!InEdit->bPublished, TEXT("Chunk map was already committed"));
+
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if(InEdit->BaseVersion != Current)
+		{
+			return false;
+		}
+
+		InEdit->Version = NextVersion++;
+		InEdit->bPublished = true;
+		InEdit->BaseVersion.Reset();
+
+		// Free the bookkeeping, nothing writes to a published map
+		InEdit->OwnedChunks.Empty();
+
+		UndoHistory.Add(Current);
+		RedoHistory.Reset();
+
+		Publish(InEdit);
+	}
+
+	Reclaim();
+
+	return true;
+}
+
+/**
+ * Makes the version before the current one current again
+ * @return true if there was a version to go back to
+ */
+bool FVoxelChunkStore::Undo()
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if(UndoHistory.Num() == 0)
+		{
+			return false;
+		}
+
+		RedoHistory.Add(Current);
+		Publish(UndoHistory.Pop());
+	}
+
+	Reclaim();
+
+	return true;
+}
+
+/**
+ * Makes the version that was last undone current again
+ * @return true if there was a version to go forward to
+ */
+bool FVoxelChunkStore::Redo()
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		if(RedoHistory.Num() == 0)
+		{
+			return false;
+		}
+
+		UndoHistory.Add(Current);
+		Publish(RedoHistory.Pop());
+	}
+
+	Reclaim();
+
+	return true;
+}
+
+int32 FVoxelChunkStore::GetNumUndo() const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	return UndoHistory.Num();
+}
+
+int32 FVoxelChunkStore::GetNumRedo() const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	return RedoHistory.Num();
+}
+
+/**
+ * Frees the replaced versions no read scope can still be using
+ * Commit, Undo and Redo already do this, call it when readers may have held scopes across those
+ * @return The number of versions released, a version still in the history stays alive
+ */
+int32 FVoxelChunkStore::Reclaim()
+{
+	return Epochs.Reclaim();
+}
+
+/**
+ * Makes a version current and trims the undo history, the lock must be held
+ * The replaced version is retired, read scopes may still be reading it through the raw pointer
+ * @param InMap The version to publish
+ */
+void FVoxelChunkStore::Publish(const FMapPtr& InMap)
+{
+	FMapPtr Replaced = MoveTemp(Current);
+
+	Current = InMap;
+	CurrentMap.store(Current.Get());
+
+	Epochs.Retire([Replaced = MoveTemp(Replaced)]() mutable
+	{
+		Replaced.Reset();
+	});
+
+	if(UndoHistory.Num() > MaxHistory)
+	{
+		UndoHistory.RemoveAt(0, UndoHistory.Num() - MaxHistory);
+	}
+}
+
+/**
+ * Class constructor, pins an epoch and then reads the current version
+ * @param InStore The store to read
+ */
+FVoxelChunkStore::FReadScope::FReadScope(const FVoxelChunkStore& InStore) : Pin(InStore.Epochs.Pin()), Map(InStore.CurrentMap.load())
+{
+}
+
+const FVoxelChunkMap& FVoxelChunkStore::FReadScope::Get() const
+{
+	return *Map;
+}
+
+const FVoxelChunkMap* FVoxelChunkStore::FReadScope::operator->() const
+{
+	return Map;
+}
@@ -0,0 +1,175 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Data/VoxelEpochManager.h"
+
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTLS.h"
+
+FVoxelEpochManager::FPin::FPin(FVoxelEpochManager* InManager, const int32 InSlot) : Manager(InManager), Slot(InSlot)
+{
+}
+
+FVoxelEpochManager::FPin::FPin(FPin&& Other) : Manager(Other.Manager), Slot(Other.Slot)
+{
+	Other.Manager = nullptr;
+	Other.Slot = INDEX_NONE;
+}
+
+FVoxelEpochManager::FPin::~FPin()
+{
+	Release();
+}
+
+/**
+ * Unpins the epoch early, anything read under the pin must not be used afterwards
+ */
+void FVoxelEpochManager::FPin::Release()
+{
+	if(Manager)
+	{
+		Manager->Slots[Slot].Epoch.store(0, std::memory_order_release);
+		Manager = nullptr;
+		Slot = INDEX_NONE;
+	}
+}
+
+/**
+ * Reclaims everything that is still retired, no reader may be pinned anymore
+ */
+FVoxelEpochManager::~FVoxelEpochManager()
+{
+	for(const FSlot& Slot : Slots)
+	{
+		checkf(Slot.Epoch.load() == 0, TEXT("Epoch manager destroyed while a reader is still pinned"));
+	}
+
+	for(FRetired& Entry : Retired)
+	{
+		Entry.Reclaim();
+	}
+}
+
+/**
+ * Pins the current epoch, data loaded while the pin is alive stays valid until it is released
+ * The search for a free slot starts at a slot picked from the thread, so threads rarely touch the same slots
+ * @return The pin
+ */
+FVoxelEpochManager::FPin FVoxelEpochManager::Pin()
+{
+	const int32 FirstSlot = static_cast<int32>(FPlatformTLS::GetCurrentThreadId() % MaxReaders);
+
+	for(;;)
+	{
+		for(int32 Attempt = 0; Attempt < MaxReaders; Attempt++)
+		{
+			const int32 Slot = (FirstSlot + Attempt) % MaxReaders;
+
+			// A slightly stale epoch only keeps retired data alive a little longer
+			uint64 Expected = 0;
+
+			if(Slots[Slot].Epoch.load(std::memory_order_relaxed) == 0 &&
+				Slots[Slot].Epoch.compare_exchange_strong(Expected, GlobalEpoch.load()))
+			{
+				return FPin(this, Slot);
+			}
+		}
+
+		FPlatformProcess::Yield();
+	}
+}
+
+/**
+ * Retires data that was just unpublished, it is reclaimed once no reader can still be using it
+ * The data must already be unreachable for new readers, the epoch is advanced past it
+ * @param InReclaim Called once to free the data
+ */
+void FVoxelEpochManager::Retire(TFunction<void()>&& InReclaim)
+{
+	FScopeLock ScopeLock(&RetiredLock);
+
+	Retired.Add({GlobalEpoch.fetch_add(1), MoveTemp(InReclaim)});
+}
+
+/**
+ * Reclaims every retired entry no pinned reader can still see
+ * Called by writers, readers never have to
+ * @return The number of entries reclaimed
+ */
+int32 FVoxelEpochManager::Reclaim()
+{
+	TArray<FRetired> Reclaimable;
+
+	{
+		FScopeLock ScopeLock(&RetiredLock);
+
+		const uint64 MinPinnedEpoch = GetMinPinnedEpoch();
+
+		for(int32 Index = Retired.Num() - 1; Index >= 0; Index--)
+		{
+			if(Retired[Index].Epoch < MinPinnedEpoch)
+			{
+				Reclaimable.Add(MoveTemp(Retired[Index]));
+				Retired.RemoveAtSwap(Index);
+			}
+		}
+	}
+
+	// Free outside the lock, reclaiming can be expensive
+	for(FRetired& Entry : Reclaimable)
+	{
+		Entry.Reclaim();
+	}
+
+	return Reclaimable.Num();
+}
+
+int32 FVoxelEpochManager::GetNumRetired()
+{
+	FScopeLock ScopeLock(&RetiredLock);
+
+	return Retired.Num();
+}
+
+/**
+ * Gets the oldest epoch any reader has pinned
+ * @return The epoch, past every retired entry if no reader is pinned
+ */
+uint64 FVoxelEpochManager::GetMinPinnedEpoch() const
+{
+	uint64 MinEpoch = TNumericLimits<uint64>::Max();
+
+	for(const FSlot& Slot : Slots)
+	{
+		const uint64 Epoch = Slot.Epoch.load();
+
+		if(Epoch != 0)
+		{
+			MinEpoch = FMath::Min(MinEpoch, Epoch);
+		}
+	}
+
+	return MinEpoch;
+}
@@ -25,6 +25,8 @@
 
 #include "Data/VoxelGrid.h"
 
+#include "Data/VoxelCustomVersion.h"
+
 /**
  * Struct constructor
  * @param InVoxelSize The size of each voxel in world space
@@ -35,6 +37,17 @@ FVoxelGrid::FVoxelGrid(const FVector& InVoxelSize, const FBox& InBounds)
 	Init(InVoxelSize, InBounds);
 }
 
+/**
+ * Struct constructor
+ * @param InVoxelSize The size of each voxel in world space
+ * @param InLatticeOrigin The lattice coordinate of the first voxel
+ * @param InVoxelCount The number of voxels in each dimension
+ */
+FVoxelGrid::FVoxelGrid(const FVector& InVoxelSize, const FIntVector& InLatticeOrigin, const FIntVector& InVoxelCount)
+{
+	Init(InVoxelSize, InLatticeOrigin, InVoxelCount);
+}
+
 /**
  * Initializes the voxel grid
  * @param InVoxelSize The size of each voxel in world space
@@ -43,24 +56,31 @@ FVoxelGrid::FVoxelGrid(const FVector& InVoxelSize, const FBox& InBounds)
 void FVoxelGrid::Init(const FVector& InVoxelSize, const FBox& InBounds)
 {
 	VoxelSize = InVoxelSize;
-	// Round bounds up to the nearest voxel size inclusive (so anything partial gets included)
-	FVector BoundsMin = InBounds.Min;
-	BoundsMin.X = FMath::FloorToFloat(BoundsMin.X / VoxelSize.X) * VoxelSize.X;
-	BoundsMin.Y = FMath::FloorToFloat(BoundsMin.Y / VoxelSize.Y) * VoxelSize.Y;
-	BoundsMin.Z = FMath::FloorToFloat(BoundsMin.Z / VoxelSize.Z) * VoxelSize.Z;
-	
-	FVector BoundsMax = InBounds.Max;
-	BoundsMax.X = FMath::CeilToFloat(BoundsMax.X / VoxelSize.X) * VoxelSize.X;
-	BoundsMax.Y = FMath::CeilToFloat(BoundsMax.Y / VoxelSize.Y) * VoxelSize.Y;
-	BoundsMax.Z = FMath::CeilToFloat(BoundsMax.Z / VoxelSize.Z) * VoxelSize.Z;
 	
-	Bounds = FBox(BoundsMin, BoundsMax);
+	// Round bounds up to the nearest voxel size inclusive (so anything partial gets included)
+	// This is the only place the bounds get rounded, everything after works on lattice coordinates
+	const FIntVector Min = GetLatticeCoordinate(InBounds.Min);
+	const FIntVector Max(
+		FMath::CeilToInt(InBounds.Max.X / VoxelSize.X),
+		FMath::CeilToInt(InBounds.Max.Y / VoxelSize.Y),
+		FMath::CeilToInt(InBounds.Max.Z / VoxelSize.Z));
 
-	// Calculate the number of voxels in each dimension
-	VoxelCount = FIntVector(
-		FMath::CeilToInt(Bounds.GetSize().X / VoxelSize.X),
-		FMath::CeilToInt(Bounds.GetSize().Y / VoxelSize.Y),
-		FMath::CeilToInt(Bounds.GetSize().Z / VoxelSize.Z));
+	Init(InVoxelSize, Min, Max - Min);
+}
+
+/**
+ * Initializes the voxel grid directly on the lattice
+ * @param InVoxelSize The size of each voxel in world space
+ * @param InLatticeOrigin The lattice coordinate of the first voxel
+ * @param InVoxelCount The number of voxels in each dimension
+ */
+void FVoxelGrid::Init(const FVector& InVoxelSize, const FIntVector& InLatticeOrigin, const FIntVector& InVoxelCount)
+{
+	VoxelSize = InVoxelSize;
+	LatticeOrigin = InLatticeOrigin;
+	VoxelCount = InVoxelCount;
+
+	Bounds = FBox(FVector(LatticeOrigin) * VoxelSize, FVector(LatticeOrigin + VoxelCount) * VoxelSize);
 }
 
 /**
@@ -72,6 +92,38 @@ FBox FVoxelGrid::GetBounds() const
 	return Bounds;
 }
 
+/**
+ * Gets the size of each voxel in world space
+ * @return The size of each voxel
+ */
+FVector FVoxelGrid::GetVoxelSize() const
+{
+	return VoxelSize;
+}
+
+/**
+ * Gets the lattice coordinate of the first voxel of the grid
+ * @return The lattice coordinate, in voxels from the world origin
+ */
+FIntVector FVoxelGrid::GetLatticeOrigin() const
+{
+	return LatticeOrigin;
+}
+
+/**
+ * Gets the lattice coordinate of the voxel containing a location
+ * Unlike voxel coordinates this isn't relative to the grid and works for any location
+ * @param InLocation The location in world space
+ * @return The lattice coordinate, in voxels from the world origin
+ */
+FIntVector FVoxelGrid::GetLatticeCoordinate(const FVector& InLocation) const
+{
+	return FIntVector(
+		FMath::FloorToInt(InLocation.X / VoxelSize.X),
+		FMath::FloorToInt(InLocation.Y / VoxelSize.Y),
+		FMath::FloorToInt(InLocation.Z / VoxelSize.Z));
+}
+
 /**
  * Gets the total number of voxels in the grid
  * @return The total number of voxels in the grid
@@ -132,15 +184,9 @@ int32 FVoxelGrid::GetVoxelIndex(const FVector& InLocation) const
 {
 	checkf(IsLocationInBounds(InLocation), TEXT("Location is not in bounds"));
 	
-	const FVector LocalLocation = InLocation + (Bounds.Min * -1);
+	const FIntVector Coordinate = GetLatticeCoordinate(InLocation) - LatticeOrigin;
 	
-	const int32 X = FMath::FloorToInt(LocalLocation.X / VoxelSize.X);
-	const int32 Y = FMath::FloorToInt(LocalLocation.Y / VoxelSize.Y);
-	const int32 Z = FMath::FloorToInt(LocalLocation.Z / VoxelSize.Z);
-	
-	const int32 Index = X +
-		Y * FMath::CeilToInt(Bounds.GetSize().X / VoxelSize.X) +
-		Z * FMath::CeilToInt(Bounds.GetSize().X / VoxelSize.X) * FMath::CeilToInt(Bounds.GetSize().Y / VoxelSize.Y);
+	const int32 Index = Coordinate.X + Coordinate.Y * VoxelCount.X + Coordinate.Z * VoxelCount.X * VoxelCount.Y;
 		
 	return Index;
 }
@@ -171,13 +217,7 @@ FIntVector FVoxelGrid::GetVoxelCoordinate(const FVector& InLocation) const
 {
 	checkf(IsLocationInBounds(InLocation), TEXT("Location is not in bounds"));
 	
-	const FVector LocalLocation = InLocation + (Bounds.Min * -1);
-	
-	const int32 X = FMath::FloorToInt(LocalLocation.X / VoxelSize.X);
-	const int32 Y = FMath::FloorToInt(LocalLocation.Y / VoxelSize.Y);
-	const int32 Z = FMath::FloorToInt(LocalLocation.Z / VoxelSize.Z);
-	
-	return FIntVector(X, Y, Z);
+	return GetLatticeCoordinate(InLocation) - LatticeOrigin;
 }
 
 /**
@@ -242,47 +282,64 @@ FBox FVoxelGrid::GetVoxelBounds(const FVector& InLocation) const
 	return GetVoxelBounds(GetVoxelIndex(InLocation));
 }
 
+/**
+ * Gets the box of every voxel in the grid
+ * @return The voxel box covering the whole grid
+ */
+FVoxelBox FVoxelGrid::GetVoxelBox() const
+{
+	return FVoxelBox(FIntVector::ZeroValue, VoxelCount);
+}
+
+/**
+ * Gets the box of voxels that overlap the bounds, clamped to the grid
+ * The bounds are rounded up to the nearest voxel size inclusive and don't need to be inside the grid
+ * @param InBounds The bounds in world space
+ * @return The voxel box, empty if the bounds don't overlap the grid
+ */
+FVoxelBox FVoxelGrid::GetVoxelBox(const FBox& InBounds) const
+{
+	const FIntVector Min = GetLatticeCoordinate(InBounds.Min) - LatticeOrigin;
+	const FIntVector Max = FIntVector(
+		FMath::CeilToInt(InBounds.Max.X / VoxelSize.X),
+		FMath::CeilToInt(InBounds.Max.Y / VoxelSize.Y),
+		FMath::CeilToInt(InBounds.Max.Z / VoxelSize.Z)) - LatticeOrigin;
+
+	return FVoxelBox(Min, Max).Intersect(GetVoxelBox());
+}
+
+/**
+ * Gets the world space bounds of a voxel box
+ * @param InVoxelBox The voxel box
+ * @return The bounds covering every voxel in the box
+ */
+FBox FVoxelGrid::GetBounds(const FVoxelBox& InVoxelBox) const
+{
+	return FBox(FVector(LatticeOrigin + InVoxelBox.Min) * VoxelSize, FVector(LatticeOrigin + InVoxelBox.Max) * VoxelSize);
+}
+
 /**
  * Gets the indices of all voxels that are within the bounds (inclusive)
+ * Voxels outside the grid are skipped
  * @param InBounds The bounds to get the voxel indices for
  * @return The indices of all voxels within the bounds
  */
 TArray<int32> FVoxelGrid::GetVoxelIndicesFromBounds(const FBox& InBounds) const
 {
-	// Round bounds up to the nearest voxel size inclusive (so anything partial gets included)
-	FVector BoundsMin = InBounds.Min;
-	BoundsMin.X = FMath::FloorToFloat(BoundsMin.X / VoxelSize.X) * VoxelSize.X;
-	BoundsMin.Y = FMath::FloorToFloat(BoundsMin.Y / VoxelSize.Y) * VoxelSize.Y;
-	BoundsMin.Z = FMath::FloorToFloat(BoundsMin.Z / VoxelSize.Z) * VoxelSize.Z;
-	
-	FVector BoundsMax = InBounds.Max;
-	BoundsMax.X = FMath::CeilToFloat(BoundsMax.X / VoxelSize.X) * VoxelSize.X;
-	BoundsMax.Y = FMath::CeilToFloat(BoundsMax.Y / VoxelSize.Y) * VoxelSize.Y;
-	BoundsMax.Z = FMath::CeilToFloat(BoundsMax.Z / VoxelSize.Z) * VoxelSize.Z;
-	
-	const FVector BoundsSize = BoundsMax - BoundsMin;
-	
-	const int32 NumVoxelsX = FMath::CeilToInt(BoundsSize.X / VoxelSize.X);
-	const int32 NumVoxelsY = FMath::CeilToInt(BoundsSize.Y / VoxelSize.Y);
-	const int32 NumVoxelsZ = FMath::CeilToInt(BoundsSize.Z / VoxelSize.Z);
-	const int32 NumVoxels = NumVoxelsX * NumVoxelsY * NumVoxelsZ;
+	const FVoxelBox VoxelBox = GetVoxelBox(InBounds);
 	
 	TArray<int32> Result;
-	Result.Reserve(NumVoxels);
+	Result.Reserve(VoxelBox.Num());
 	
-	const int32 IndexMin = GetVoxelIndex(BoundsMin);
-	
-	for(int32 Z = 0; Z < NumVoxelsZ; Z++)
+	for(int32 Z = VoxelBox.Min.Z; Z < VoxelBox.Max.Z; Z++)
 	{
-		for(int32 Y = 0; Y < NumVoxelsY; Y++)
+		for(int32 Y = VoxelBox.Min.Y; Y < VoxelBox.Max.Y; Y++)
 		{
-			for(int32 X = 0; X < NumVoxelsX; X++)
-			{
-				const int32 Index = IndexMin + X + Y * VoxelCount.X + Z * VoxelCount.X * VoxelCount.Y;
-			
-				checkf(IsVoxelIndexValid(Index), TEXT("Invalid voxel index %d"), Index);
+			const int32 RowIndex = Y * VoxelCount.X + Z * VoxelCount.X * VoxelCount.Y;
 			
-				Result.Add(Index);
+			for(int32 X = VoxelBox.Min.X; X < VoxelBox.Max.X; X++)
+			{
+				Result.Add(RowIndex + X);
 			}
 		}
 	}
@@ -292,44 +349,21 @@ TArray<int32> FVoxelGrid::GetVoxelIndicesFromBounds(const FBox& InBounds) const
 
 /**
  * Gets the coordinates of all voxels that are within the bounds (inclusive)
+ * Voxels outside the grid are skipped
  * @param InBounds The bounds to get the voxel coordinates for
  * @return The coordinates of all voxels within the bounds
  */
 TArray<FIntVector> FVoxelGrid::GetVoxelCoordinatesFromBounds(const FBox& InBounds) const
 {
-	// Round bounds up to the nearest voxel size inclusive (so anything partial gets included)
-	FVector BoundsMin = InBounds.Min;
-	BoundsMin.X = FMath::FloorToFloat(BoundsMin.X / VoxelSize.X) * VoxelSize.X;
-	BoundsMin.Y = FMath::FloorToFloat(BoundsMin.Y / VoxelSize.Y) * VoxelSize.Y;
-	BoundsMin.Z = FMath::FloorToFloat(BoundsMin.Z / VoxelSize.Z) * VoxelSize.Z;
-	
-	FVector BoundsMax = InBounds.Max;
-	BoundsMax.X = FMath::CeilToFloat(BoundsMax.X / VoxelSize.X) * VoxelSize.X;
-	BoundsMax.Y = FMath::CeilToFloat(BoundsMax.Y / VoxelSize.Y) * VoxelSize.Y;
-	BoundsMax.Z = FMath::CeilToFloat(BoundsMax.Z / VoxelSize.Z) * VoxelSize.Z;
-	
-	const FVector BoundsSize = BoundsMax - BoundsMin;
-	
-	const int32 NumVoxelsX = FMath::CeilToInt(BoundsSize.X / VoxelSize.X);
-	const int32 NumVoxelsY = FMath::CeilToInt(BoundsSize.Y / VoxelSize.Y);
-	const int32 NumVoxelsZ = FMath::CeilToInt(BoundsSize.Z / VoxelSize.Z);
-	const int32 NumVoxels = NumVoxelsX * NumVoxelsY * NumVoxelsZ;
+	const FVoxelBox VoxelBox = GetVoxelBox(InBounds);
 	
 	TArray<FIntVector> Result;
-	Result.Reserve(NumVoxels);
-	
-	const FIntVector CoordinateMin = GetVoxelCoordinate(BoundsMin);
+	Result.Reserve(VoxelBox.Num());
 	
-	for(int32 Z = 0; Z < NumVoxelsZ; Z++)
+	VoxelBox.ForEach([&Result](const FIntVector& Coordinate)
 	{
-		for(int32 Y = 0; Y < NumVoxelsY; Y++)
-		{
-			for(int32 X = 0; X < NumVoxelsX; X++)
-			{
-				Result.Add(CoordinateMin + FIntVector(X, Y, Z));
-			}
-		}
-	}
+		Result.Add(Coordinate);
+	});
 		
 	return Result;
 }
@@ -342,16 +376,53 @@ TArray<FIntVector> FVoxelGrid::GetVoxelCoordinatesFromBounds(const FBox& InBound
  */
 FVoxelGrid FVoxelGrid::GetSubGrid(const FBox& InBounds) const
 {
-	// Round bounds up to the nearest voxel size inclusive (so anything partial gets included)
-	FVector BoundsMin = InBounds.Min;
-	BoundsMin.X = FMath::FloorToFloat(BoundsMin.X / VoxelSize.X) * VoxelSize.X;
-	BoundsMin.Y = FMath::FloorToFloat(BoundsMin.Y / VoxelSize.Y) * VoxelSize.Y;
-	BoundsMin.Z = FMath::FloorToFloat(BoundsMin.Z / VoxelSize.Z) * VoxelSize.Z;
-	
-	FVector BoundsMax = InBounds.Max;
-	BoundsMax.X = FMath::CeilToFloat(BoundsMax.X / VoxelSize.X) * VoxelSize.X;
-	BoundsMax.Y = FMath::CeilToFloat(BoundsMax.Y / VoxelSize.Y) * VoxelSize.Y;
-	BoundsMax.Z = FMath::CeilToFloat(BoundsMax.Z / VoxelSize.Z) * VoxelSize.Z;
+	return FVoxelGrid(VoxelSize, InBounds);
+}
+
+/**
+ * Gets a sub grid from the current grid on the same lattice
+ * No rounding is involved so the sub grid's voxels are exactly the parent's voxels
+ * @param InOffset The coordinate of the sub grid's first voxel in this grid
+ * @param InVoxelCount The number of voxels of the sub grid in each dimension
+ * @return The sub grid
+ */
+FVoxelGrid FVoxelGrid::GetSubGrid(const FIntVector& InOffset, const FIntVector& InVoxelCount) const
+{
+	return FVoxelGrid(VoxelSize, LatticeOrigin + InOffset, InVoxelCount);
+}
+
+/**
+ * Checks if two grids cover the same voxels of the same lattice
+ * @param Other The grid to compare with
+ * @return true if the grids are the same
+ */
+bool FVoxelGrid::operator==(const FVoxelGrid& Other) const
+{
+	return VoxelSize == Other.VoxelSize && LatticeOrigin == Other.LatticeOrigin && VoxelCount == Other.VoxelCount;
+}
+
+bool FVoxelGrid::operator!=(const FVoxelGrid& Other) const
+{
+	return !(*this == Other);
+}
+
+/**
+ * Serializes the grid in binary, the bounds are rebuilt from the lattice when loading
+ * @param Ar The archive to serialize with
+ * @return true, the grid always handles its own serialization
+ */
+bool FVoxelGrid::Serialize(FArchive& Ar)
+{
+	Ar.UsingCustomVersion(FVoxelCustomVersion::GUID);
+
+	Ar << VoxelSize;
+	Ar << LatticeOrigin;
+	Ar << VoxelCount;
+
+	if(Ar.IsLoading())
+	{
+		Init(VoxelSize, LatticeOrigin, VoxelCount);
+	}
 
-	return FVoxelGrid(VoxelSize, FBox(BoundsMin, BoundsMax));
+	return true;
 }
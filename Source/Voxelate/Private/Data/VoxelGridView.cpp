@@ -0,0 +1,124 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Data/VoxelGridView.h"
+
+/**
+ * Struct constructor, the view must fit inside the parent grid
+ * @param InParentGrid The grid the view looks into
+ * @param InOffset The coordinate of the view's first voxel in the parent grid
+ * @param InVoxelCount The number of voxels of the view in each dimension
+ */
+FVoxelGridView::FVoxelGridView(const FVoxelGrid& InParentGrid, const FIntVector& InOffset, const FIntVector& InVoxelCount)
+	: ParentGrid(InParentGrid), Offset(InOffset), VoxelCount(InVoxelCount)
+{
+	const FIntVector ParentCount = ParentGrid.GetVectorVoxelCount();
+
+	checkf(Offset.X >= 0 && Offset.Y >= 0 && Offset.Z >= 0 &&
+		Offset.X + VoxelCount.X <= ParentCount.X &&
+		Offset.Y + VoxelCount.Y <= ParentCount.Y &&
+		Offset.Z + VoxelCount.Z <= ParentCount.Z, TEXT("View %s + %s does not fit in grid %s"),
+		*Offset.ToString(), *VoxelCount.ToString(), *ParentCount.ToString());
+
+	ParentStrideY = ParentCount.X;
+	ParentStrideZ = ParentCount.X * ParentCount.Y;
+}
+
+/**
+ * Gets the grid the view looks into
+ * @return The parent grid
+ */
+const FVoxelGrid& FVoxelGridView::GetParentGrid() const
+{
+	return ParentGrid;
+}
+
+/**
+ * Gets the view as a standalone grid on the parent's lattice
+ * @return The sub grid covered by the view
+ */
+FVoxelGrid FVoxelGridView::GetGrid() const
+{
+	return ParentGrid.GetSubGrid(Offset, VoxelCount);
+}
+
+/**
+ * Gets the coordinate of the view's first voxel in the parent grid
+ * @return The offset
+ */
+FIntVector FVoxelGridView::GetOffset() const
+{
+	return Offset;
+}
+
+/**
+ * Gets the number of voxels of the view in each dimension
+ * @return The number of voxels in each dimension
+ */
+FIntVector FVoxelGridView::GetVectorVoxelCount() const
+{
+	return VoxelCount;
+}
+
+/**
+ * Gets the total number of voxels in the view
+ * @return The total number of voxels
+ */
+int32 FVoxelGridView::GetVoxelCount() const
+{
+	return VoxelCount.X * VoxelCount.Y * VoxelCount.Z;
+}
+
+/**
+ * Checks if a local coordinate is inside the view
+ * @param InCoordinate The coordinate in the view
+ * @return true if the coordinate is valid
+ */
+bool FVoxelGridView::IsVoxelCoordinateValid(const FIntVector& InCoordinate) const
+{
+	return InCoordinate.X >= 0 && InCoordinate.X < VoxelCount.X &&
+		InCoordinate.Y >= 0 && InCoordinate.Y < VoxelCount.Y &&
+		InCoordinate.Z >= 0 && InCoordinate.Z < VoxelCount.Z;
+}
+
+/**
+ * Checks if a coordinate of the parent grid is covered by the view
+ * @param InParentCoordinate The coordinate in the parent grid
+ * @return true if the view covers the coordinate
+ */
+bool FVoxelGridView::ContainsParentCoordinate(const FIntVector& InParentCoordinate) const
+{
+	return IsVoxelCoordinateValid(GetLocalCoordinate(InParentCoordinate));
+}
+
+/**
+ * Maps a coordinate of the parent grid to the view
+ * @param InParentCoordinate The coordinate in the parent grid
+ * @return The coordinate in the view, not necessarily valid
+ */
+FIntVector FVoxelGridView::GetLocalCoordinate(const FIntVector& InParentCoordinate) const
+{
+	return InParentCoordinate - Offset;
+}
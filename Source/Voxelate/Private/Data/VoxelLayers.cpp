@@ -0,0 +1,109 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Data/VoxelLayers.h"
+
+#include "Async/ParallelFor.h"
+
+/**
+ * Struct constructor, every voxel starts empty in every layer
+ * @param InGrid The voxel grid the layers cover
+ * @param InLayerNames The name of each layer, at most MaxLayers
+ */
+FVoxelLayers::FVoxelLayers(const FVoxelGrid& InGrid, const TArray<FName>& InLayerNames)
+	: TVoxelAttribute<uint16>(InGrid, 0), LayerNames(InLayerNames)
+{
+	checkf(LayerNames.Num() <= MaxLayers, TEXT("%d layers requested, at most %d are supported"), LayerNames.Num(), MaxLayers);
+}
+
+int32 FVoxelLayers::NumLayers() const
+{
+	return LayerNames.Num();
+}
+
+const TArray<FName>& FVoxelLayers::GetLayerNames() const
+{
+	return LayerNames;
+}
+
+/**
+ * Finds a layer by name
+ * @param InLayerName The layer's name
+ * @return The layer, INDEX_NONE if there is no such layer
+ */
+int32 FVoxelLayers::FindLayer(const FName InLayerName) const
+{
+	return LayerNames.IndexOfByKey(InLayerName);
+}
+
+/**
+ * Counts the occupied voxels of a layer
+ * @param InLayer The layer
+ * @return The number of occupied voxels
+ */
+int32 FVoxelLayers::CountOccupied(const int32 InLayer) const
+{
+	checkf(InLayer >= 0 && InLayer < LayerNames.Num(), TEXT("Invalid layer %d"), InLayer);
+
+	int32 Count = 0;
+
+	for(const uint16 Mask : Values)
+	{
+		Count += (Mask >> InLayer) & 1;
+	}
+
+	return Count;
+}
+
+/**
+ * Extracts a layer as bit packed occupancy, Z slices are packed in parallel
+ * @param InLayer The layer
+ * @return The layer's occupancy
+ */
+FVoxelOccupancy FVoxelLayers::GetLayer(const int32 InLayer) const
+{
+	checkf(InLayer >= 0 && InLayer < LayerNames.Num(), TEXT("Invalid layer %d"), InLayer);
+
+	FVoxelOccupancy Occupancy(Grid);
+
+	const FIntVector Count = Grid.GetVectorVoxelCount();
+	uint64* Words = Occupancy.GetWords().GetData();
+
+	ParallelFor(Count.Z, [this, &Occupancy, &Count, Words, InLayer](const int32 Z)
+	{
+		for(int32 Y = 0; Y < Count.Y; Y++)
+		{
+			uint64* Row = Words + Occupancy.GetRowWordIndex(Y, Z);
+			const uint16* RowMasks = Values.GetData() + (Y + Z * Count.Y) * Count.X;
+
+			for(int32 X = 0; X < Count.X; X++)
+			{
+				Row[X >> 6] |= uint64((RowMasks[X] >> InLayer) & 1) << (X & 63);
+			}
+		}
+	});
+
+	return Occupancy;
+}
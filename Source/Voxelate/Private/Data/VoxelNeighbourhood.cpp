@@ -0,0 +1,198 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Data/VoxelNeighbourhood.h"
+
+/**
+ * Struct constructor, precomputes the offsets for the grid
+ * @param InGrid The voxel grid the neighbours are looked up in
+ * @param InConnectivity Which neighbours to visit
+ */
+FVoxelNeighbourhood::FVoxelNeighbourhood(const FVoxelGrid& InGrid, const EVoxelConnectivity InConnectivity)
+	: VoxelCount(InGrid.GetVectorVoxelCount())
+{
+	const uint32 ConnectivityMask = GetConnectivityMask(InConnectivity);
+
+	for(int32 Z = -1; Z <= 1; Z++)
+	{
+		for(int32 Y = -1; Y <= 1; Y++)
+		{
+			for(int32 X = -1; X <= 1; X++)
+			{
+				const FIntVector Offset(X, Y, Z);
+
+				if(ConnectivityMask & (1u << GetMaskBit(Offset)))
+				{
+					Offsets.Add(Offset);
+					IndexOffsets.Add(X + Y * VoxelCount.X + Z * VoxelCount.X * VoxelCount.Y);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Gets the number of neighbours visited
+ * @return 6, 18 or 26
+ */
+int32 FVoxelNeighbourhood::Num() const
+{
+	return Offsets.Num();
+}
+
+/**
+ * Gets the coordinate offset of a neighbour
+ * @param InNeighbour The neighbour, between 0 and Num
+ * @return The coordinate offset
+ */
+const FIntVector& FVoxelNeighbourhood::GetOffset(const int32 InNeighbour) const
+{
+	return Offsets[InNeighbour];
+}
+
+/**
+ * Gets the voxel index offset of a neighbour
+ * @param InNeighbour The neighbour, between 0 and Num
+ * @return The index offset
+ */
+int32 FVoxelNeighbourhood::GetIndexOffset(const int32 InNeighbour) const
+{
+	return IndexOffsets[InNeighbour];
+}
+
+/**
+ * Gets the bit of a neighbourhood mask for an offset
+ * @param InOffset The offset, each component between -1 and 1
+ * @return The bit index, between 0 and 26
+ */
+int32 FVoxelNeighbourhood::GetMaskBit(const FIntVector& InOffset)
+{
+	return (InOffset.X + 1) + (InOffset.Y + 1) * 3 + (InOffset.Z + 1) * 9;
+}
+
+/**
+ * Gets the neighbourhood mask bits of a connectivity
+ * @param InConnectivity The connectivity
+ * @return The mask bits, the center bit is never included
+ */
+uint32 FVoxelNeighbourhood::GetConnectivityMask(const EVoxelConnectivity InConnectivity)
+{
+	switch(InConnectivity)
+	{
+	case EVoxelConnectivity::Face:
+		return FaceMask;
+	case EVoxelConnectivity::Edge:
+		return EdgeMask;
+	default:
+		return VertexMask;
+	}
+}
+
+/**
+ * Gathers the 3x3x3 neighbourhood mask of every voxel in a row along X
+ * @param InOccupancy The occupancy to read
+ * @param Y The row's Y coordinate
+ * @param Z The row's Z coordinate
+ * @param OutMasks One mask per voxel in the row
+ * @param bOutsideIsOccupied Whether voxels outside the grid count as occupied
+ */
+void FVoxelNeighbourhood::GatherRow(const FVoxelOccupancy& InOccupancy, const int32 Y, const int32 Z, TArray<uint32>& OutMasks,
+	const bool bOutsideIsOccupied)
+{
+	OutMasks.SetNumUninitialized(InOccupancy.GetGrid().GetVectorVoxelCount().X);
+
+	for(int32 Word = 0; Word < InOccupancy.GetWordsPerRow(); Word++)
+	{
+		GatherWord(InOccupancy, Word, Y, Z, OutMasks.GetData() + Word * 64, bOutsideIsOccupied);
+	}
+}
+
+/**
+ * Gathers the 3x3x3 neighbourhood mask of the (up to) 64 voxels stored in one word of a row
+ * The 27 shifted words around the word are built once and each voxel's mask is read out of them,
+ * so there are no per-neighbour bounds checks. A word of a row is also a chunk row
+ * @param InOccupancy The occupancy to read
+ * @param Word The word in the row, which is also the chunk's X coordinate
+ * @param Y The row's Y coordinate
+ * @param Z The row's Z coordinate
+ * @param OutMasks Receives one mask per voxel in the word, voxels past the end of the row are skipped
+ * @param bOutsideIsOccupied Whether voxels outside the grid count as occupied
+ */
+void FVoxelNeighbourhood::GatherWord(const FVoxelOccupancy& InOccupancy, const int32 Word, const int32 Y, const int32 Z,
+	uint32* OutMasks, const bool bOutsideIsOccupied)
+{
+	const FIntVector Count = InOccupancy.GetGrid().GetVectorVoxelCount();
+	const int32 WordsPerRow = InOccupancy.GetWordsPerRow();
+	const uint64* Words = InOccupancy.GetWords().GetData();
+	const uint64 OutsideWord = bOutsideIsOccupied ? ~uint64(0) : 0;
+
+	// Padding bits past the end of the row are zero in storage and need to read as outside
+	const int32 LastWordBits = Count.X - (WordsPerRow - 1) * 64;
+	const uint64 LastWordPadding = LastWordBits >= 64 ? 0 : ~((uint64(1) << LastWordBits) - 1);
+
+	auto GetWord = [&](const int32 RowY, const int32 RowZ, const int32 RowWord) -> uint64
+	{
+		if(RowY < 0 || RowY >= Count.Y || RowZ < 0 || RowZ >= Count.Z || RowWord < 0 || RowWord >= WordsPerRow)
+		{
+			return OutsideWord;
+		}
+
+		const uint64 Value = Words[InOccupancy.GetRowWordIndex(RowY, RowZ) + RowWord];
+
+		return RowWord == WordsPerRow - 1 ? Value | (LastWordPadding & OutsideWord) : Value;
+	};
+
+	// Plane K holds, for every voxel of the word, the occupancy of its neighbour at mask bit K
+	uint64 Planes[27];
+
+	for(int32 OffsetZ = -1; OffsetZ <= 1; OffsetZ++)
+	{
+		for(int32 OffsetY = -1; OffsetY <= 1; OffsetY++)
+		{
+			const uint64 Previous = GetWord(Y + OffsetY, Z + OffsetZ, Word - 1);
+			const uint64 Current = GetWord(Y + OffsetY, Z + OffsetZ, Word);
+			const uint64 Next = GetWord(Y + OffsetY, Z + OffsetZ, Word + 1);
+
+			const int32 Plane = (OffsetY + 1) * 3 + (OffsetZ + 1) * 9;
+			Planes[Plane] = (Current << 1) | (Previous >> 63);
+			Planes[Plane + 1] = Current;
+			Planes[Plane + 2] = (Current >> 1) | (Next << 63);
+		}
+	}
+
+	const int32 NumBits = FMath::Min(64, Count.X - Word * 64);
+
+	for(int32 Bit = 0; Bit < NumBits; Bit++)
+	{
+		uint32 Mask = 0;
+
+		for(int32 Plane = 0; Plane < 27; Plane++)
+		{
+			Mask |= static_cast<uint32>((Planes[Plane] >> Bit) & 1) << Plane;
+		}
+
+		OutMasks[Bit] = Mask;
+	}
+}
@@ -0,0 +1,813 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Data/VoxelOccupancy.h"
+
+#include "Async/ParallelFor.h"
+#include "Data/VoxelCustomVersion.h"
+#include "Misc/Compression.h"
+
+namespace
+{
+	// Leading byte of a serialized chunk block
+	enum class EChunkBlock : uint8
+	{
+		// Every word of the chunk is zero, there is no payload
+		Empty,
+		// The chunk's words as they are
+		Raw,
+		// The chunk's words compressed with the stream's compression format
+		Compressed
+	};
+
+	/**
+	 * Checks a loaded grid before anything is allocated for it, its counts come straight from the archive
+	 * @param Ar The archive being loaded from
+	 * @param InGrid The loaded grid
+	 * @param bIsCompressed Whether the words are stored as chunk blocks
+	 * @return true if the grid is sane and the rest of the archive is large enough to hold its words
+	 */
+	bool IsLoadedGridValid(FArchive& Ar, const FVoxelGrid& InGrid, const bool bIsCompressed)
+	{
+		if(!FVoxelOccupancy::IsGridValid(InGrid))
+		{
+			return false;
+		}
+
+		const FIntVector Count = InGrid.GetVectorVoxelCount();
+		const int64 NumWords = int64(FMath::DivideAndRoundUp(Count.X, 64)) * Count.Y * Count.Z;
+
+		// A chunk block holds at least its array count and its leading byte, a bulk copy its array count and every word
+		const int64 NumChunks = int64(FMath::DivideAndRoundUp(Count.X, FVoxelOccupancy::ChunkSize)) *
+			FMath::DivideAndRoundUp(Count.Y, FVoxelOccupancy::ChunkSize) * FMath::DivideAndRoundUp(Count.Z, FVoxelOccupancy::ChunkSize);
+		const int64 MinSize = bIsCompressed ? NumChunks * (sizeof(int32) + 1) : sizeof(int32) + NumWords * sizeof(uint64);
+
+		// Archives that don't know their size only get the count checks
+		const int64 TotalSize = Ar.TotalSize();
+
+		return TotalSize < 0 || MinSize <= TotalSize - Ar.Tell();
+	}
+
+	/**
+	 * Reads up to 64 consecutive bits of a row
+	 * @param Row The row's words
+	 * @param Start The first bit
+	 * @param Count The number of bits, all of them inside the row
+	 * @return The bits, bit 0 is the first one
+	 */
+	uint64 ReadRowBits(const uint64* Row, const int32 Start, const int32 Count)
+	{
+		const int32 Word = Start >> 6;
+		const int32 Shift = Start & 63;
+
+		uint64 Bits = Row[Word] >> Shift;
+
+		if(Shift != 0 && Shift + Count > 64)
+		{
+			Bits |= Row[Word + 1] << (64 - Shift);
+		}
+
+		return Count < 64 ? Bits & ((uint64(1) << Count) - 1) : Bits;
+	}
+
+	/**
+	 * Overwrites up to 64 consecutive bits of a row, the other bits are kept
+	 * @param Row The row's words
+	 * @param Start The first bit
+	 * @param Count The number of bits, all of them inside the row
+	 * @param Bits The new bits, bit 0 is the first one
+	 */
+	void WriteRowBits(uint64* Row, const int32 Start, const int32 Count, uint64 Bits)
+	{
+		const int32 Word = Start >> 6;
+		const int32 Shift = Start & 63;
+		const uint64 Mask = Count < 64 ? (uint64(1) << Count) - 1 : ~uint64(0);
+
+		Bits &= Mask;
+		Row[Word] = (Row[Word] & ~(Mask << Shift)) | (Bits << Shift);
+
+		if(Shift != 0 && Shift + Count > 64)
+		{
+			Row[Word + 1] = (Row[Word + 1] & ~(Mask >> (64 - Shift))) | (Bits >> (64 - Shift));
+		}
+	}
+}
+
+/**
+ * Checks a grid read from untrusted data before anything is allocated for it
+ * @param InGrid The grid
+ * @return true if its voxel size is positive, its counts aren't negative and its words fit in an array
+ */
+bool FVoxelOccupancy::IsGridValid(const FVoxelGrid& InGrid)
+{
+	const FVector VoxelSize = InGrid.GetVoxelSize();
+	const FIntVector Count = InGrid.GetVectorVoxelCount();
+
+	if(!(VoxelSize.X > 0.0 && VoxelSize.Y > 0.0 && VoxelSize.Z > 0.0) || Count.X < 0 || Count.Y < 0 || Count.Z < 0)
+	{
+		return false;
+	}
+
+	return int64(FMath::DivideAndRoundUp(Count.X, 64)) * Count.Y * Count.Z <= MAX_int32;
+}
+
+/**
+ * Struct constructor, all voxels start empty
+ * @param InGrid The voxel grid the occupancy covers
+ */
+FVoxelOccupancy::FVoxelOccupancy(const FVoxelGrid& InGrid)
+{
+	Init(InGrid);
+}
+
+/**
+ * Struct constructor, packs one bool per voxel as produced by FVoxelator
+ * @param InGrid The voxel grid the occupancy covers
+ * @param InVoxels The occupancy of every voxel, in voxel index order
+ */
+FVoxelOccupancy::FVoxelOccupancy(const FVoxelGrid& InGrid, const TArray<bool>& InVoxels)
+{
+	Init(InGrid);
+
+	checkf(InVoxels.Num() == Grid.GetVoxelCount(), TEXT("Expected %d voxels, got %d"), Grid.GetVoxelCount(), InVoxels.Num());
+
+	const FIntVector Count = Grid.GetVectorVoxelCount();
+	int32 Index = 0;
+
+	for(int32 Z = 0; Z < Count.Z; Z++)
+	{
+		for(int32 Y = 0; Y < Count.Y; Y++)
+		{
+			uint64* Row = Words.GetData() + GetRowWordIndex(Y, Z);
+
+			for(int32 X = 0; X < Count.X; X++, Index++)
+			{
+				Row[X >> 6] |= uint64(InVoxels[Index]) << (X & 63);
+			}
+		}
+	}
+}
+
+/**
+ * Initializes the occupancy for a grid, all voxels start empty
+ * @param InGrid The voxel grid the occupancy covers
+ */
+void FVoxelOccupancy::Init(const FVoxelGrid& InGrid)
+{
+	Grid = InGrid;
+	WordsPerRow = FMath::DivideAndRoundUp(Grid.GetVectorVoxelCount().X, 64);
+
+	Words.Reset();
+	Words.SetNumZeroed(WordsPerRow * GetNumRows());
+}
+
+/**
+ * Gets the voxel grid the occupancy covers
+ * @return The voxel grid
+ */
+const FVoxelGrid& FVoxelOccupancy::GetGrid() const
+{
+	return Grid;
+}
+
+/**
+ * Gets the number of words used to store a single row along X
+ * @return The number of words per row
+ */
+int32 FVoxelOccupancy::GetWordsPerRow() const
+{
+	return WordsPerRow;
+}
+
+/**
+ * Gets the number of rows along X, one per Y and Z coordinate
+ * @return The number of rows
+ */
+int32 FVoxelOccupancy::GetNumRows() const
+{
+	return Grid.GetVectorVoxelCount().Y * Grid.GetVectorVoxelCount().Z;
+}
+
+/**
+ * Gets the raw words, rows are laid out Y then Z
+ * @return The words
+ */
+TArray<uint64>& FVoxelOccupancy::GetWords()
+{
+	return Words;
+}
+
+/**
+ * Gets the raw words, rows are laid out Y then Z
+ * @return The words
+ */
+const TArray<uint64>& FVoxelOccupancy::GetWords() const
+{
+	return Words;
+}
+
+/**
+ * Counts the occupied voxels
+ * @return The number of occupied voxels
+ */
+int32 FVoxelOccupancy::CountOccupied() const
+{
+	int32 Count = 0;
+
+	for(const uint64 Word : Words)
+	{
+		Count += FMath::CountBits(Word);
+	}
+
+	return Count;
+}
+
+/**
+ * Counts the occupied voxels in a box, whole words are masked and counted at once
+ * @param InVoxelBox The voxel box, the part outside the grid counts as empty
+ * @return The number of occupied voxels
+ */
+int32 FVoxelOccupancy::CountOccupied(const FVoxelBox& InVoxelBox) const
+{
+	const FVoxelBox Box = InVoxelBox.Intersect(Grid.GetVoxelBox());
+
+	if(Box.IsEmpty())
+	{
+		return 0;
+	}
+
+	const int32 FirstWord = Box.Min.X >> 6;
+	const int32 LastWord = (Box.Max.X - 1) >> 6;
+	const uint64 FirstMask = ~uint64(0) << (Box.Min.X & 63);
+	const uint64 LastMask = ~uint64(0) >> (63 - ((Box.Max.X - 1) & 63));
+
+	int32 Count = 0;
+
+	for(int32 Z = Box.Min.Z; Z < Box.Max.Z; Z++)
+	{
+		for(int32 Y = Box.Min.Y; Y < Box.Max.Y; Y++)
+		{
+			const uint64* Row = Words.GetData() + GetRowWordIndex(Y, Z);
+
+			for(int32 Word = FirstWord; Word <= LastWord; Word++)
+			{
+				uint64 Mask = ~uint64(0);
+				Mask &= Word == FirstWord ? FirstMask : Mask;
+				Mask &= Word == LastWord ? LastMask : Mask;
+
+				Count += FMath::CountBits(Row[Word] & Mask);
+			}
+		}
+	}
+
+	return Count;
+}
+
+/**
+ * Copies a box of voxels into an occupancy of its own, on a sub grid of this occupancy's grid
+ * @param InVoxelBox The voxels to copy, must be inside the grid
+ * @return The copy, its first voxel is the box's first voxel
+ */
+FVoxelOccupancy FVoxelOccupancy::GetSubOccupancy(const FVoxelBox& InVoxelBox) const
+{
+	FVoxelOccupancy Result(Grid.GetSubGrid(InVoxelBox.Min, InVoxelBox.GetSize()));
+	Result.CopyVoxels(*this, InVoxelBox.Min, FVoxelBox(FIntVector::ZeroValue, InVoxelBox.GetSize()));
+
+	return Result;
+}
+
+/**
+ * Overwrites a box of voxels with the voxels of another occupancy, 64 voxels of a row at a time
+ * The occupancies don't need to share a grid
+ * @param InSource The occupancy to copy from, must not be this occupancy
+ * @param InSourceMin The source's voxel copied to the box's first voxel
+ * @param InVoxelBox The voxels to overwrite, must be inside the grid, the matching source box must be inside the source's grid
+ */
+void FVoxelOccupancy::CopyVoxels(const FVoxelOccupancy& InSource, const FIntVector& InSourceMin, const FVoxelBox& InVoxelBox)
+{
+	checkf(&InSource != this, TEXT("Can't copy voxels from an occupancy into itself"));
+	checkf(Grid.GetVoxelBox().Contains(InVoxelBox), TEXT("Box %s is outside the grid"), *InVoxelBox.ToString());
+	checkf(InSource.Grid.GetVoxelBox().Contains(InVoxelBox.Translate(InSourceMin - InVoxelBox.Min)),
+		TEXT("Source box at %s is outside the source grid"), *InSourceMin.ToString());
+
+	if(InVoxelBox.IsEmpty())
+	{
+		return;
+	}
+
+	const FIntVector Offset = InSourceMin - InVoxelBox.Min;
+
+	for(int32 Z = InVoxelBox.Min.Z; Z < InVoxelBox.Max.Z; Z++)
+	{
+		for(int32 Y = InVoxelBox.Min.Y; Y < InVoxelBox.Max.Y; Y++)
+		{
+			const uint64* SourceRow = InSource.Words.GetData() + InSource.GetRowWordIndex(Y + Offset.Y, Z + Offset.Z);
+			uint64* Row = Words.GetData() + GetRowWordIndex(Y, Z);
+
+			for(int32 X = InVoxelBox.Min.X; X < InVoxelBox.Max.X; X += 64)
+			{
+				const int32 Count = FMath::Min(InVoxelBox.Max.X - X, 64);
+
+				WriteRowBits(Row, X, Count, ReadRowBits(SourceRow, X + Offset.X, Count));
+			}
+		}
+	}
+}
+
+/**
+ * Unpacks the occupancy to one bool per voxel
+ * @return The occupancy of every voxel, in voxel index order
+ */
+TArray<bool> FVoxelOccupancy::ToArray() const
+{
+	const FIntVector Count = Grid.GetVectorVoxelCount();
+
+	TArray<bool> Result;
+	Result.Reserve(Grid.GetVoxelCount());
+
+	for(int32 Z = 0; Z < Count.Z; Z++)
+	{
+		for(int32 Y = 0; Y < Count.Y; Y++)
+		{
+			const uint64* Row = Words.GetData() + GetRowWordIndex(Y, Z);
+
+			for(int32 X = 0; X < Count.X; X++)
+			{
+				Result.Add((Row[X >> 6] >> (X & 63)) & 1);
+			}
+		}
+	}
+
+	return Result;
+}
+
+/**
+ * Gets the number of chunks in each dimension, partial chunks at the far edges are included
+ * @return The number of chunks in each dimension
+ */
+FIntVector FVoxelOccupancy::GetChunkCount() const
+{
+	const FIntVector Count = Grid.GetVectorVoxelCount();
+
+	return FIntVector(
+		FMath::DivideAndRoundUp(Count.X, ChunkSize),
+		FMath::DivideAndRoundUp(Count.Y, ChunkSize),
+		FMath::DivideAndRoundUp(Count.Z, ChunkSize));
+}
+
+/**
+ * Gets the total number of chunks
+ * @return The total number of chunks
+ */
+int32 FVoxelOccupancy::GetNumChunks() const
+{
+	const FIntVector ChunkCount = GetChunkCount();
+
+	return ChunkCount.X * ChunkCount.Y * ChunkCount.Z;
+}
+
+/**
+ * Gets the index of a chunk from its coordinate
+ * @param InChunkCoordinate The chunk coordinate
+ * @return The chunk index
+ */
+int32 FVoxelOccupancy::GetChunkIndex(const FIntVector& InChunkCoordinate) const
+{
+	const FIntVector ChunkCount = GetChunkCount();
+
+	checkf(InChunkCoordinate.X >= 0 && InChunkCoordinate.X < ChunkCount.X &&
+		InChunkCoordinate.Y >= 0 && InChunkCoordinate.Y < ChunkCount.Y &&
+		InChunkCoordinate.Z >= 0 && InChunkCoordinate.Z < ChunkCount.Z, TEXT("Invalid chunk coordinate %s"), *InChunkCoordinate.ToString());
+
+	return InChunkCoordinate.X + InChunkCoordinate.Y * ChunkCount.X + InChunkCoordinate.Z * ChunkCount.X * ChunkCount.Y;
+}
+
+/**
+ * Gets the coordinate of a chunk from its index
+ * @param InChunkIndex The chunk index
+ * @return The chunk coordinate
+ */
+FIntVector FVoxelOccupancy::GetChunkCoordinate(const int32 InChunkIndex) const
+{
+	checkf(InChunkIndex >= 0 && InChunkIndex < GetNumChunks(), TEXT("Invalid chunk index %d"), InChunkIndex);
+
+	const FIntVector ChunkCount = GetChunkCount();
+	const int32 Z = InChunkIndex / (ChunkCount.X * ChunkCount.Y);
+	const int32 Y = (InChunkIndex - Z * ChunkCount.X * ChunkCount.Y) / ChunkCount.X;
+	const int32 X = InChunkIndex - Z * ChunkCount.X * ChunkCount.Y - Y * ChunkCount.X;
+
+	return FIntVector(X, Y, Z);
+}
+
+/**
+ * Gets the voxel coordinates covered by a chunk, clamped to the grid
+ * @param InChunkCoordinate The chunk coordinate
+ * @param OutMin The first voxel coordinate in the chunk (inclusive)
+ * @param OutMax The last voxel coordinate in the chunk (exclusive)
+ */
+void FVoxelOccupancy::GetChunkVoxelRange(const FIntVector& InChunkCoordinate, FIntVector& OutMin, FIntVector& OutMax) const
+{
+	const FIntVector Count = Grid.GetVectorVoxelCount();
+
+	OutMin = InChunkCoordinate * ChunkSize;
+	OutMax = FIntVector(
+		FMath::Min(OutMin.X + ChunkSize, Count.X),
+		FMath::Min(OutMin.Y + ChunkSize, Count.Y),
+		FMath::Min(OutMin.Z + ChunkSize, Count.Z));
+}
+
+/**
+ * Gets the box of voxels covered by a chunk, clamped to the grid
+ * @param InChunkCoordinate The chunk coordinate
+ * @return The voxel box
+ */
+FVoxelBox FVoxelOccupancy::GetChunkBox(const FIntVector& InChunkCoordinate) const
+{
+	FIntVector Min, Max;
+	GetChunkVoxelRange(InChunkCoordinate, Min, Max);
+
+	return FVoxelBox(Min, Max);
+}
+
+/**
+ * Gets the box of chunk coordinates touched by a box of voxels
+ * @param InVoxelBox The voxel box, clamped to the grid
+ * @return The chunk box, empty if the voxel box is empty
+ */
+FVoxelBox FVoxelOccupancy::GetChunkBox(const FVoxelBox& InVoxelBox) const
+{
+	const FVoxelBox ClampedBox = InVoxelBox.Intersect(Grid.GetVoxelBox());
+
+	if(ClampedBox.IsEmpty())
+	{
+		return FVoxelBox();
+	}
+
+	return FVoxelBox(ClampedBox.Min / ChunkSize, (ClampedBox.Max - FIntVector(1)) / ChunkSize + FIntVector(1));
+}
+
+/**
+ * Checks if a chunk has no occupied voxels
+ * A chunk row is a single word so this is one comparison per row
+ * @param InChunkCoordinate The chunk coordinate
+ * @return true if no voxel in the chunk is occupied
+ */
+bool FVoxelOccupancy::IsChunkEmpty(const FIntVector& InChunkCoordinate) const
+{
+	FIntVector Min, Max;
+	GetChunkVoxelRange(InChunkCoordinate, Min, Max);
+
+	for(int32 Z = Min.Z; Z < Max.Z; Z++)
+	{
+		for(int32 Y = Min.Y; Y < Max.Y; Y++)
+		{
+			if(Words[GetRowWordIndex(Y, Z) + InChunkCoordinate.X] != 0)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Copies the words of a chunk, one word per chunk row laid out Y then Z
+ * @param InChunkCoordinate The chunk coordinate
+ * @param OutWords The chunk's words, resized to the number of chunk rows
+ */
+void FVoxelOccupancy::GetChunkWords(const FIntVector& InChunkCoordinate, TArray<uint64>& OutWords) const
+{
+	FIntVector Min, Max;
+	GetChunkVoxelRange(InChunkCoordinate, Min, Max);
+
+	OutWords.Reset((Max.Y - Min.Y) * (Max.Z - Min.Z));
+
+	for(int32 Z = Min.Z; Z < Max.Z; Z++)
+	{
+		for(int32 Y = Min.Y; Y < Max.Y; Y++)
+		{
+			OutWords.Add(Words[GetRowWordIndex(Y, Z) + InChunkCoordinate.X]);
+		}
+	}
+}
+
+/**
+ * Overwrites the words of a chunk, the inverse of GetChunkWords
+ * @param InChunkCoordinate The chunk coordinate
+ * @param InWords The chunk's words, one word per chunk row laid out Y then Z
+ */
+void FVoxelOccupancy::SetChunkWords(const FIntVector& InChunkCoordinate, TConstArrayView<uint64> InWords)
+{
+	FIntVector Min, Max;
+	GetChunkVoxelRange(InChunkCoordinate, Min, Max);
+
+	checkf(InWords.Num() == (Max.Y - Min.Y) * (Max.Z - Min.Z), TEXT("Expected %d words for chunk %s, got %d"),
+		(Max.Y - Min.Y) * (Max.Z - Min.Z), *InChunkCoordinate.ToString(), InWords.Num());
+
+	// Padding bits past the end of the grid must stay zero
+	const int32 ValidBits = Max.X - Min.X;
+	const uint64 ValidMask = ValidBits < 64 ? (uint64(1) << ValidBits) - 1 : ~uint64(0);
+
+	int32 Index = 0;
+
+	for(int32 Z = Min.Z; Z < Max.Z; Z++)
+	{
+		for(int32 Y = Min.Y; Y < Max.Y; Y++, Index++)
+		{
+			Words[GetRowWordIndex(Y, Z) + InChunkCoordinate.X] = InWords[Index] & ValidMask;
+		}
+	}
+}
+
+/**
+ * Packs a chunk into a self contained block, falling back to the raw words if compressing doesn't pay off
+ * @param InChunkCoordinate The chunk coordinate
+ * @param InFormat The compression format, for example NAME_Oodle or NAME_Zlib, NAME_None to skip compressing
+ * @param OutBlock The block
+ */
+void FVoxelOccupancy::CompressChunk(const FIntVector& InChunkCoordinate, const FName InFormat, TArray<uint8>& OutBlock) const
+{
+	TArray<uint64> ChunkWords;
+	GetChunkWords(InChunkCoordinate, ChunkWords);
+
+	OutBlock.Reset();
+
+	if(!ChunkWords.ContainsByPredicate([](const uint64 Word) { return Word != 0; }))
+	{
+		OutBlock.Add(static_cast<uint8>(EChunkBlock::Empty));
+		return;
+	}
+
+	const int32 RawSize = ChunkWords.Num() * sizeof(uint64);
+
+	if(!InFormat.IsNone())
+	{
+		int32 CompressedSize = FCompression::CompressMemoryBound(InFormat, RawSize);
+		OutBlock.SetNumUninitialized(1 + CompressedSize);
+
+		if(FCompression::CompressMemory(InFormat, OutBlock.GetData() + 1, CompressedSize, ChunkWords.GetData(), RawSize) &&
+			CompressedSize < RawSize)
+		{
+			OutBlock[0] = static_cast<uint8>(EChunkBlock::Compressed);
+			OutBlock.SetNum(1 + CompressedSize);
+			return;
+		}
+	}
+
+	OutBlock.SetNumUninitialized(1 + RawSize);
+	OutBlock[0] = static_cast<uint8>(EChunkBlock::Raw);
+	FMemory::Memcpy(OutBlock.GetData() + 1, ChunkWords.GetData(), RawSize);
+}
+
+/**
+ * Unpacks a block made by CompressChunk into a chunk
+ * @param InChunkCoordinate The chunk coordinate
+ * @param InFormat The compression format the block was made with
+ * @param InBlock The block
+ * @return false if the block is malformed, the chunk is left untouched
+ */
+bool FVoxelOccupancy::UncompressChunk(const FIntVector& InChunkCoordinate, const FName InFormat, TConstArrayView<uint8> InBlock)
+{
+	if(InBlock.Num() < 1)
+	{
+		return false;
+	}
+
+	FIntVector Min, Max;
+	GetChunkVoxelRange(InChunkCoordinate, Min, Max);
+
+	TArray<uint64> ChunkWords;
+	ChunkWords.SetNumZeroed((Max.Y - Min.Y) * (Max.Z - Min.Z));
+
+	const int32 RawSize = ChunkWords.Num() * sizeof(uint64);
+	const uint8* Payload = InBlock.GetData() + 1;
+	const int32 PayloadSize = InBlock.Num() - 1;
+
+	switch(static_cast<EChunkBlock>(InBlock[0]))
+	{
+	case EChunkBlock::Empty:
+		if(PayloadSize != 0)
+		{
+			return false;
+		}
+		break;
+	case EChunkBlock::Raw:
+		if(PayloadSize != RawSize)
+		{
+			return false;
+		}
+		FMemory::Memcpy(ChunkWords.GetData(), Payload, RawSize);
+		break;
+	case EChunkBlock::Compressed:
+		if(InFormat.IsNone() || !FCompression::UncompressMemory(InFormat, ChunkWords.GetData(), RawSize, Payload, PayloadSize))
+		{
+			return false;
+		}
+		break;
+	default:
+		return false;
+	}
+
+	SetChunkWords(InChunkCoordinate, ChunkWords);
+
+	return true;
+}
+
+/**
+ * Walks the voxels along a segment (3D DDA) and checks if any of them are occupied
+ * Both points are in voxel space, where one unit is one voxel and the origin is the grid minimum
+ * The start must be inside the grid, the segment stops where it leaves the grid
+ * @param InStart The start of the segment in voxel space
+ * @param InEnd The end of the segment in voxel space
+ * @return true if an occupied voxel was hit
+ */
+bool FVoxelOccupancy::LineTraceVoxels(const FVector& InStart, const FVector& InEnd) const
+{
+	const FIntVector Count = Grid.GetVectorVoxelCount();
+	const FIntVector EndVoxel(
+		FMath::Clamp(FMath::FloorToInt(InEnd.X), 0, Count.X - 1),
+		FMath::Clamp(FMath::FloorToInt(InEnd.Y), 0, Count.Y - 1),
+		FMath::Clamp(FMath::FloorToInt(InEnd.Z), 0, Count.Z - 1));
+	
+	FIntVector Voxel(
+		FMath::Clamp(FMath::FloorToInt(InStart.X), 0, Count.X - 1),
+		FMath::Clamp(FMath::FloorToInt(InStart.Y), 0, Count.Y - 1),
+		FMath::Clamp(FMath::FloorToInt(InStart.Z), 0, Count.Z - 1));
+
+	const FVector Direction = InEnd - InStart;
+	
+	FIntVector Step;
+	FVector DeltaT;
+	FVector MaxT;
+	
+	for(int32 Axis = 0; Axis < 3; Axis++)
+	{
+		if(Direction[Axis] > 0.0)
+		{
+			Step[Axis] = 1;
+			DeltaT[Axis] = 1.0 / Direction[Axis];
+			MaxT[Axis] = (Voxel[Axis] + 1 - InStart[Axis]) * DeltaT[Axis];
+		} else if(Direction[Axis] < 0.0)
+		{
+			Step[Axis] = -1;
+			DeltaT[Axis] = -1.0 / Direction[Axis];
+			MaxT[Axis] = (InStart[Axis] - Voxel[Axis]) * DeltaT[Axis];
+		} else
+		{
+			Step[Axis] = 0;
+			DeltaT[Axis] = BIG_NUMBER;
+			MaxT[Axis] = BIG_NUMBER;
+		}
+	}
+
+	while(true)
+	{
+		if(IsOccupied(Voxel))
+		{
+			return true;
+		}
+
+		if(Voxel == EndVoxel)
+		{
+			return false;
+		}
+
+		// Step along the axis whose voxel boundary is crossed first
+		const int32 Axis = MaxT.X < MaxT.Y ? (MaxT.X < MaxT.Z ? 0 : 2) : (MaxT.Y < MaxT.Z ? 1 : 2);
+		
+		if(MaxT[Axis] > 1.0)
+		{
+			return false;
+		}
+
+		Voxel[Axis] += Step[Axis];
+		MaxT[Axis] += DeltaT[Axis];
+
+		if(Voxel[Axis] < 0 || Voxel[Axis] >= Count[Axis])
+		{
+			return false;
+		}
+	}
+}
+
+/**
+ * Serializes the occupancy in binary without compression
+ * @param Ar The archive to serialize with
+ * @return true, the occupancy always handles its own serialization
+ */
+bool FVoxelOccupancy::Serialize(FArchive& Ar)
+{
+	Serialize(Ar, NAME_None);
+
+	return true;
+}
+
+/**
+ * Serializes the occupancy in binary
+ * Without compression the words go to the archive as a single bulk copy,
+ * otherwise every chunk is stored as its own block so chunks are packed and unpacked in parallel
+ * A malformed archive sets the archive's error flag and leaves the occupancy empty
+ * @param Ar The archive to serialize with
+ * @param InCompressionFormat The format to save with, for example NAME_Oodle or NAME_Zlib, NAME_None to store the words as they are.
+ * Ignored when loading, the format stored in the archive is used instead
+ */
+void FVoxelOccupancy::Serialize(FArchive& Ar, const FName InCompressionFormat)
+{
+	Ar.UsingCustomVersion(FVoxelCustomVersion::GUID);
+
+	Ar << Grid;
+
+	// Stored as a string, plain file and memory archives don't all support names
+	FString CompressionFormatName = InCompressionFormat.ToString();
+	Ar << CompressionFormatName;
+
+	const FName CompressionFormat = Ar.IsLoading() ? FName(*CompressionFormatName) : InCompressionFormat;
+
+	if(Ar.IsLoading())
+	{
+		if(Ar.IsError() || !IsLoadedGridValid(Ar, Grid, !CompressionFormat.IsNone()))
+		{
+			Ar.SetError();
+			Init(FVoxelGrid());
+			return;
+		}
+
+		Init(Grid);
+	}
+
+	if(CompressionFormat.IsNone())
+	{
+		const int32 NumWords = Words.Num();
+
+		Words.BulkSerialize(Ar);
+
+		if(Ar.IsLoading() && (Ar.IsError() || Words.Num() != NumWords))
+		{
+			Ar.SetError();
+			Init(Grid);
+		}
+
+		return;
+	}
+
+	const int32 NumChunks = GetNumChunks();
+
+	TArray<TArray<uint8>> Blocks;
+	Blocks.SetNum(NumChunks);
+
+	if(Ar.IsSaving())
+	{
+		ParallelFor(NumChunks, [this, &Blocks, CompressionFormat](const int32 ChunkIndex)
+		{
+			CompressChunk(GetChunkCoordinate(ChunkIndex), CompressionFormat, Blocks[ChunkIndex]);
+		});
+	}
+
+	for(TArray<uint8>& Block : Blocks)
+	{
+		Ar << Block;
+	}
+
+	if(Ar.IsLoading())
+	{
+		TArray<bool> IsChunkValid;
+		IsChunkValid.SetNumZeroed(NumChunks);
+
+		if(!Ar.IsError())
+		{
+			ParallelFor(NumChunks, [this, &Blocks, &IsChunkValid, CompressionFormat](const int32 ChunkIndex)
+			{
+				IsChunkValid[ChunkIndex] = UncompressChunk(GetChunkCoordinate(ChunkIndex), CompressionFormat, Blocks[ChunkIndex]);
+			});
+		}
+
+		if(IsChunkValid.Contains(false))
+		{
+			Ar.SetError();
+			Init(Grid);
+		}
+	}
+}
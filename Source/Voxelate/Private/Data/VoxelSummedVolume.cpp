@@ -0,0 +1,270 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Data/VoxelSummedVolume.h"
+
+#include "Async/ParallelFor.h"
+
+/**
+ * Struct constructor, builds the tables of every chunk
+ * @param InOccupancy The occupancy to sum
+ */
+FVoxelSummedVolume::FVoxelSummedVolume(const FVoxelOccupancy& InOccupancy)
+{
+	Build(InOccupancy);
+}
+
+/**
+ * Builds the tables of every chunk, chunks are built in parallel
+ * @param InOccupancy The occupancy to sum
+ */
+void FVoxelSummedVolume::Build(const FVoxelOccupancy& InOccupancy)
+{
+	Grid = InOccupancy.GetGrid();
+	ChunkCount = InOccupancy.GetChunkCount();
+
+	Tables.Reset();
+	Tables.SetNum(InOccupancy.GetNumChunks());
+
+	ParallelFor(Tables.Num(), [this, &InOccupancy](const int32 ChunkIndex)
+	{
+		BuildChunk(InOccupancy, InOccupancy.GetChunkCoordinate(ChunkIndex), Tables[ChunkIndex]);
+	});
+}
+
+/**
+ * Rebuilds the table of a chunk after its occupancy changed
+ * @param InOccupancy The occupancy the table was built from
+ * @param InChunkCoordinate The chunk that changed
+ */
+void FVoxelSummedVolume::UpdateChunk(const FVoxelOccupancy& InOccupancy, const FIntVector& InChunkCoordinate)
+{
+	checkf(InOccupancy.GetGrid() == Grid, TEXT("Occupancy doesn't match the summed volume's grid"));
+
+	BuildChunk(InOccupancy, InChunkCoordinate, Tables[GetChunkIndex(InChunkCoordinate)]);
+}
+
+/**
+ * Rebuilds the tables of every chunk touched by a box of voxels that changed, chunks are rebuilt in parallel
+ * @param InOccupancy The occupancy the table was built from
+ * @param InVoxelBox The voxels that changed
+ */
+void FVoxelSummedVolume::UpdateVoxels(const FVoxelOccupancy& InOccupancy, const FVoxelBox& InVoxelBox)
+{
+	checkf(InOccupancy.GetGrid() == Grid, TEXT("Occupancy doesn't match the summed volume's grid"));
+
+	const FVoxelBox ChunkBox = InOccupancy.GetChunkBox(InVoxelBox);
+	const FIntVector Size = ChunkBox.GetSize();
+
+	ParallelFor(ChunkBox.Num(), [this, &InOccupancy, &ChunkBox, &Size](const int32 Index)
+	{
+		const FIntVector ChunkCoordinate = ChunkBox.Min + FIntVector(Index % Size.X, (Index / Size.X) % Size.Y, Index / (Size.X * Size.Y));
+
+		BuildChunk(InOccupancy, ChunkCoordinate, Tables[GetChunkIndex(ChunkCoordinate)]);
+	});
+}
+
+const FVoxelGrid& FVoxelSummedVolume::GetGrid() const
+{
+	return Grid;
+}
+
+/**
+ * Gets the memory used by the tables
+ * @return The size in bytes
+ */
+SIZE_T FVoxelSummedVolume::GetAllocatedSize() const
+{
+	SIZE_T Size = Tables.GetAllocatedSize();
+
+	for(const TArray<uint32>& Table : Tables)
+	{
+		Size += Table.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+/**
+ * Counts the occupied voxels in a box, 8 lookups for every chunk the box touches
+ * @param InVoxelBox The voxel box, the part outside the grid counts as empty
+ * @return The number of occupied voxels
+ */
+int64 FVoxelSummedVolume::CountOccupied(const FVoxelBox& InVoxelBox) const
+{
+	const FVoxelBox VoxelBox = InVoxelBox.Intersect(Grid.GetVoxelBox());
+
+	if(VoxelBox.IsEmpty())
+	{
+		return 0;
+	}
+
+	int64 Count = 0;
+
+	FVoxelBox(VoxelBox.Min / ChunkSize, (VoxelBox.Max - FIntVector(1)) / ChunkSize + FIntVector(1)).ForEach(
+		[this, &VoxelBox, &Count](const FIntVector& ChunkCoordinate)
+	{
+		const FIntVector ChunkMin = ChunkCoordinate * ChunkSize;
+		const FVoxelBox LocalBox = VoxelBox.Translate(-ChunkMin).Intersect(FVoxelBox(FIntVector::ZeroValue, GetChunkSize(ChunkCoordinate)));
+
+		Count += CountChunk(ChunkCoordinate, LocalBox);
+	});
+
+	return Count;
+}
+
+/**
+ * Counts the occupied voxels overlapping some bounds
+ * @param InBounds The bounds in world space, rounded out to whole voxels
+ * @return The number of occupied voxels
+ */
+int64 FVoxelSummedVolume::CountOccupied(const FBox& InBounds) const
+{
+	return CountOccupied(Grid.GetVoxelBox(InBounds));
+}
+
+/**
+ * Checks if a box holds no occupied voxel
+ * @param InVoxelBox The voxel box, the part outside the grid counts as empty
+ * @return true if the box is free
+ */
+bool FVoxelSummedVolume::IsFree(const FVoxelBox& InVoxelBox) const
+{
+	return CountOccupied(InVoxelBox) == 0;
+}
+
+/**
+ * Checks if no occupied voxel overlaps some bounds
+ * @param InBounds The bounds in world space, rounded out to whole voxels
+ * @return true if the bounds are free
+ */
+bool FVoxelSummedVolume::IsFree(const FBox& InBounds) const
+{
+	return CountOccupied(InBounds) == 0;
+}
+
+/**
+ * Gets the number of voxels of a chunk along each axis, chunks on the grid's far border may be smaller
+ * @param InChunkCoordinate The chunk coordinate
+ * @return The chunk's size
+ */
+FIntVector FVoxelSummedVolume::GetChunkSize(const FIntVector& InChunkCoordinate) const
+{
+	const FIntVector Count = Grid.GetVectorVoxelCount();
+	const FIntVector Min = InChunkCoordinate * ChunkSize;
+
+	return FIntVector(
+		FMath::Min(ChunkSize, Count.X - Min.X),
+		FMath::Min(ChunkSize, Count.Y - Min.Y),
+		FMath::Min(ChunkSize, Count.Z - Min.Z));
+}
+
+int32 FVoxelSummedVolume::GetChunkIndex(const FIntVector& InChunkCoordinate) const
+{
+	checkf(InChunkCoordinate.X >= 0 && InChunkCoordinate.X < ChunkCount.X &&
+		InChunkCoordinate.Y >= 0 && InChunkCoordinate.Y < ChunkCount.Y &&
+		InChunkCoordinate.Z >= 0 && InChunkCoordinate.Z < ChunkCount.Z, TEXT("Invalid chunk coordinate %s"), *InChunkCoordinate.ToString());
+
+	return InChunkCoordinate.X + (InChunkCoordinate.Y + InChunkCoordinate.Z * ChunkCount.Y) * ChunkCount.X;
+}
+
+/**
+ * Builds the prefix sums of a chunk, a chunk row is a single occupancy word
+ * S(X, Y, Z) = Row(X, Y, Z) + S(X, Y - 1, Z) + S(X, Y, Z - 1) - S(X, Y - 1, Z - 1), where Row is the prefix sum along the row
+ * @param InOccupancy The occupancy to sum
+ * @param InChunkCoordinate The chunk coordinate
+ * @param OutTable Receives the table, emptied if the chunk has no occupied voxel
+ */
+void FVoxelSummedVolume::BuildChunk(const FVoxelOccupancy& InOccupancy, const FIntVector& InChunkCoordinate, TArray<uint32>& OutTable) const
+{
+	if(InOccupancy.IsChunkEmpty(InChunkCoordinate))
+	{
+		OutTable.Empty();
+		return;
+	}
+
+	const FIntVector Size = GetChunkSize(InChunkCoordinate);
+	const FIntVector Min = InChunkCoordinate * ChunkSize;
+	const int32 StrideY = Size.X + 1;
+	const int32 StrideZ = StrideY * (Size.Y + 1);
+
+	OutTable.Reset();
+	OutTable.SetNumZeroed(StrideZ * (Size.Z + 1));
+
+	const uint64* Words = InOccupancy.GetWords().GetData();
+
+	for(int32 Z = 0; Z < Size.Z; Z++)
+	{
+		for(int32 Y = 0; Y < Size.Y; Y++)
+		{
+			const uint64 Word = Words[InOccupancy.GetRowWordIndex(Min.Y + Y, Min.Z + Z) + InChunkCoordinate.X];
+
+			uint32* Out = OutTable.GetData() + (Y + 1) * StrideY + (Z + 1) * StrideZ + 1;
+			const uint32* Behind = Out - StrideY;
+			const uint32* Below = Out - StrideZ;
+			const uint32* BelowBehind = Below - StrideY;
+
+			uint32 RowSum = 0;
+
+			for(int32 X = 0; X < Size.X; X++)
+			{
+				RowSum += (Word >> X) & 1;
+				Out[X] = RowSum + Behind[X] + Below[X] - BelowBehind[X];
+			}
+		}
+	}
+}
+
+/**
+ * Counts the occupied voxels of a box inside a single chunk
+ * @param InChunkCoordinate The chunk coordinate
+ * @param InLocalBox The box relative to the chunk's first voxel, must be inside the chunk
+ * @return The number of occupied voxels
+ */
+int64 FVoxelSummedVolume::CountChunk(const FIntVector& InChunkCoordinate, const FVoxelBox& InLocalBox) const
+{
+	const TArray<uint32>& Table = Tables[GetChunkIndex(InChunkCoordinate)];
+
+	if(Table.Num() == 0 || InLocalBox.IsEmpty())
+	{
+		return 0;
+	}
+
+	const FIntVector Size = GetChunkSize(InChunkCoordinate);
+	const int32 StrideY = Size.X + 1;
+	const int32 StrideZ = StrideY * (Size.Y + 1);
+
+	// The padded table at (X, Y, Z) holds the sum of every voxel below X, Y and Z
+	auto At = [&Table, StrideY, StrideZ](const int32 X, const int32 Y, const int32 Z) -> int64
+	{
+		return Table[X + Y * StrideY + Z * StrideZ];
+	};
+
+	const FIntVector& A = InLocalBox.Min;
+	const FIntVector& B = InLocalBox.Max;
+
+	return At(B.X, B.Y, B.Z) - At(A.X, B.Y, B.Z) - At(B.X, A.Y, B.Z) - At(B.X, B.Y, A.Z)
+		+ At(A.X, A.Y, B.Z) + At(A.X, B.Y, A.Z) + At(B.X, A.Y, A.Z) - At(A.X, A.Y, A.Z);
+}
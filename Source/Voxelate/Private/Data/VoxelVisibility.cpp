@@ -0,0 +1,166 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Data/VoxelVisibility.h"
+
+#include "Data/VoxelCustomVersion.h"
+
+/**
+ * Struct constructor, no chunk starts visible
+ * @param InNumChunks The number of chunks
+ */
+FVoxelVisibility::FVoxelVisibility(const int32 InNumChunks)
+{
+	Init(InNumChunks);
+}
+
+/**
+ * Initializes the visibility, no chunk starts visible
+ * @param InNumChunks The number of chunks
+ */
+void FVoxelVisibility::Init(const int32 InNumChunks)
+{
+	NumChunks = InNumChunks;
+	WordsPerChunk = FMath::DivideAndRoundUp(NumChunks, 64);
+
+	Bits.Reset();
+	Bits.SetNumZeroed(NumChunks * WordsPerChunk);
+}
+
+/**
+ * Gets the number of chunks
+ * @return The number of chunks
+ */
+int32 FVoxelVisibility::GetNumChunks() const
+{
+	return NumChunks;
+}
+
+/**
+ * Checks if a chunk may be visible from another chunk
+ * @param InFromChunk The index of the chunk the viewer is in
+ * @param InToChunk The index of the chunk to check
+ * @return true if the chunk is potentially visible
+ */
+bool FVoxelVisibility::IsVisible(const int32 InFromChunk, const int32 InToChunk) const
+{
+	checkf(InFromChunk >= 0 && InFromChunk < NumChunks, TEXT("Invalid chunk index %d"), InFromChunk);
+	checkf(InToChunk >= 0 && InToChunk < NumChunks, TEXT("Invalid chunk index %d"), InToChunk);
+
+	return (Bits[InFromChunk * WordsPerChunk + (InToChunk >> 6)] >> (InToChunk & 63)) & 1;
+}
+
+/**
+ * Marks a chunk as potentially visible from another chunk
+ * Only the bitset of the from chunk is written
+ * @param InFromChunk The index of the chunk the viewer is in
+ * @param InToChunk The index of the visible chunk
+ */
+void FVoxelVisibility::SetVisible(const int32 InFromChunk, const int32 InToChunk)
+{
+	checkf(InFromChunk >= 0 && InFromChunk < NumChunks, TEXT("Invalid chunk index %d"), InFromChunk);
+	checkf(InToChunk >= 0 && InToChunk < NumChunks, TEXT("Invalid chunk index %d"), InToChunk);
+
+	Bits[InFromChunk * WordsPerChunk + (InToChunk >> 6)] |= uint64(1) << (InToChunk & 63);
+}
+
+/**
+ * Gets the raw bitset of a chunk, bit N of the set is chunk N
+ * @param InFromChunk The index of the chunk the viewer is in
+ * @return The bitset
+ */
+TConstArrayView<uint64> FVoxelVisibility::GetVisibleSet(const int32 InFromChunk) const
+{
+	checkf(InFromChunk >= 0 && InFromChunk < NumChunks, TEXT("Invalid chunk index %d"), InFromChunk);
+
+	return TConstArrayView<uint64>(Bits.GetData() + InFromChunk * WordsPerChunk, WordsPerChunk);
+}
+
+/**
+ * Gets the indices of all chunks that may be visible from a chunk
+ * @param InFromChunk The index of the chunk the viewer is in
+ * @return The indices of the potentially visible chunks
+ */
+TArray<int32> FVoxelVisibility::GetVisibleChunks(const int32 InFromChunk) const
+{
+	TArray<int32> Result;
+
+	const TConstArrayView<uint64> VisibleSet = GetVisibleSet(InFromChunk);
+
+	for(int32 WordIndex = 0; WordIndex < VisibleSet.Num(); WordIndex++)
+	{
+		uint64 Word = VisibleSet[WordIndex];
+
+		while(Word != 0)
+		{
+			Result.Add(WordIndex * 64 + FMath::CountTrailingZeros64(Word));
+			Word &= Word - 1;
+		}
+	}
+
+	return Result;
+}
+
+/**
+ * Serializes the visibility in binary, the bitsets go to the archive as a single bulk copy
+ * A malformed archive sets the archive's error flag and leaves no chunk visible
+ * @param Ar The archive to serialize with
+ * @return true, the visibility always handles its own serialization
+ */
+bool FVoxelVisibility::Serialize(FArchive& Ar)
+{
+	Ar.UsingCustomVersion(FVoxelCustomVersion::GUID);
+
+	Ar << NumChunks;
+
+	if(Ar.IsLoading())
+	{
+		// The count comes straight from the archive, check it before allocating, archives that don't know their size only get the count checks
+		const int64 NumWords = NumChunks >= 0 ? int64(NumChunks) * FMath::DivideAndRoundUp(NumChunks, 64) : -1;
+		const int64 TotalSize = Ar.TotalSize();
+
+		if(Ar.IsError() || NumWords < 0 || NumWords > MAX_int32 ||
+			(TotalSize >= 0 && int64(sizeof(int32)) + NumWords * int64(sizeof(uint64)) > TotalSize - Ar.Tell()))
+		{
+			Ar.SetError();
+			Init(0);
+			return true;
+		}
+
+		Init(NumChunks);
+	}
+
+	const int32 NumWords = Bits.Num();
+
+	Bits.BulkSerialize(Ar);
+
+	if(Ar.IsLoading() && (Ar.IsError() || Bits.Num() != NumWords))
+	{
+		Ar.SetError();
+		Init(NumChunks);
+	}
+
+	return true;
+}
@@ -0,0 +1,485 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelAgentBaker.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/**
+	 * Shifts a row of words along X, Out[X] = In[X - Shift]
+	 * @param In The row to shift
+	 * @param Out Receives the shifted row, must not alias In
+	 * @param NumWords Number of words in a row
+	 * @param Shift Number of voxels to shift by, positive towards higher X
+	 * @param LastWordMask Mask of the valid bits of the row's last word
+	 * @param bFill Value of the voxels shifted in from outside the row
+	 */
+	void ShiftRow(const uint64* In, uint64* Out, const int32 NumWords, const int32 Shift, const uint64 LastWordMask, const bool bFill)
+	{
+		const uint64 Fill = bFill ? ~uint64(0) : 0;
+
+		auto GetWord = [In, NumWords, LastWordMask, Fill](const int32 Word) -> uint64
+		{
+			if(Word < 0 || Word >= NumWords)
+			{
+				return Fill;
+			}
+
+			// Padding bits are outside the row too
+			return Word == NumWords - 1 ? In[Word] | (Fill & ~LastWordMask) : In[Word];
+		};
+
+		const int32 Distance = FMath::Abs(Shift);
+		const int32 WordShift = Distance >> 6;
+		const int32 BitShift = Distance & 63;
+
+		for(int32 Word = 0; Word < NumWords; Word++)
+		{
+			if(Shift >= 0)
+			{
+				Out[Word] = GetWord(Word - WordShift) << BitShift;
+				Out[Word] |= BitShift ? GetWord(Word - WordShift - 1) >> (64 - BitShift) : 0;
+			}
+			else
+			{
+				Out[Word] = GetWord(Word + WordShift) >> BitShift;
+				Out[Word] |= BitShift ? GetWord(Word + WordShift + 1) << (64 - BitShift) : 0;
+			}
+		}
+
+		Out[NumWords - 1] &= LastWordMask;
+	}
+
+	/**
+	 * Grows the set bits of a row by a distance along X on both sides
+	 * The covered distance doubles with every step, so a radius R costs about log2(R) pairs of shifts
+	 * @param InOut The row to grow
+	 * @param ScratchA Scratch space of at least NumWords words
+	 * @param ScratchB Scratch space of at least NumWords words
+	 * @param NumWords Number of words in a row
+	 * @param Radius Number of voxels to grow by
+	 * @param LastWordMask Mask of the valid bits of the row's last word
+	 */
+	void DilateRow(uint64* InOut, uint64* ScratchA, uint64* ScratchB, const int32 NumWords, const int32 Radius, const uint64 LastWordMask)
+	{
+		for(int32 Covered = 0; Covered < Radius;)
+		{
+			// Bits past the ends of the row are lost, so a step longer than Covered + 1 could leave gaps near the ends
+			const int32 Step = FMath::Min(Covered + 1, Radius - Covered);
+
+			ShiftRow(InOut, ScratchA, NumWords, Step, LastWordMask, false);
+			ShiftRow(InOut, ScratchB, NumWords, -Step, LastWordMask, false);
+
+			for(int32 Word = 0; Word < NumWords; Word++)
+			{
+				InOut[Word] |= ScratchA[Word] | ScratchB[Word];
+			}
+
+			Covered += Step;
+		}
+	}
+
+	/**
+	 * Gets the mask of the valid bits of a row's last word
+	 * @param VoxelCountX Number of voxels in a row
+	 * @return The mask
+	 */
+	uint64 GetLastWordMask(const int32 VoxelCountX)
+	{
+		const int32 Bits = VoxelCountX & 63;
+
+		return Bits ? (uint64(1) << Bits) - 1 : ~uint64(0);
+	}
+
+	/**
+	 * A profile's dimensions in voxels
+	 */
+	struct FProfileVoxels
+	{
+		int32 RadiusX = 0;
+		int32 RadiusY = 0;
+		int32 Height = 1;
+		int32 Climb = 0;
+		int32 SlopeDistance = 1;
+		int32 MaxRise = 0;
+	};
+
+	/**
+	 * Converts a profile's dimensions to voxels of a grid
+	 * @param InGrid The grid
+	 * @param InProfile The agent profile
+	 * @return The dimensions, the climb never exceeds the height
+	 */
+	FProfileVoxels GetProfileVoxels(const FVoxelGrid& InGrid, const FVoxelAgentProfile& InProfile)
+	{
+		const FVector VoxelSize = InGrid.GetVoxelSize();
+
+		FProfileVoxels Voxels;
+		Voxels.RadiusX = FMath::Max(FMath::CeilToInt(InProfile.Radius / VoxelSize.X), 0);
+		Voxels.RadiusY = FMath::Max(FMath::CeilToInt(InProfile.Radius / VoxelSize.Y), 0);
+		Voxels.Height = FMath::Max(FMath::CeilToInt(InProfile.Height / VoxelSize.Z), 1);
+		Voxels.Climb = FMath::Clamp(FMath::FloorToInt(InProfile.MaxStepHeight / VoxelSize.Z), 0, Voxels.Height);
+
+		// Measure the slope over the agent's footprint, coarse voxels can't tell gentle slopes from flat ground over a single voxel
+		Voxels.SlopeDistance = FMath::Max3(Voxels.RadiusX, Voxels.RadiusY, 1);
+
+		if(InProfile.MaxSlope < 90.0)
+		{
+			const double Run = Voxels.SlopeDistance * FMath::Min(VoxelSize.X, VoxelSize.Y);
+			Voxels.MaxRise = FMath::FloorToInt(Run * FMath::Tan(FMath::DegreesToRadians(FMath::Max(InProfile.MaxSlope, 0.0))) / VoxelSize.Z);
+		}
+
+		return Voxels;
+	}
+}
+
+/**
+ * Struct constructor
+ * @param InName The profile's name
+ * @param InRadius Radius of the agent
+ * @param InHeight Free space the agent needs above the floor
+ * @param InMaxSlope Steepest walkable slope in degrees
+ * @param InMaxStepHeight Highest ledge the agent can step onto
+ */
+FVoxelAgentProfile::FVoxelAgentProfile(const FName InName, const double InRadius, const double InHeight, const double InMaxSlope,
+	const double InMaxStepHeight)
+	: Name(InName), Radius(InRadius), Height(InHeight), MaxSlope(InMaxSlope), MaxStepHeight(InMaxStepHeight)
+{
+}
+
+FVoxelAgentBaker::FVoxelAgentBaker(const TArray<FVoxelAgentProfile>& InProfiles) : Profiles(InProfiles)
+{
+}
+
+/**
+ * Bakes the walkable layer of every profile from the same occupancy, profiles are baked in parallel
+ * @param InOccupancy The occupancy of the navigable geometry
+ * @return The walkable voxels of each profile, in profile order
+ */
+TArray<FVoxelOccupancy> FVoxelAgentBaker::Bake(const FVoxelOccupancy& InOccupancy) const
+{
+	TArray<FVoxelOccupancy> Layers;
+	Layers.SetNum(Profiles.Num());
+
+	ParallelFor(Profiles.Num(), [this, &InOccupancy, &Layers](const int32 Profile)
+	{
+		Layers[Profile] = BakeProfile(InOccupancy, Profiles[Profile]);
+	});
+
+	return Layers;
+}
+
+/**
+ * Bakes the walkable layer of a single profile
+ * Obstacles are grown by the agent's radius above its step height, floors without the agent's height of free space above are dropped,
+ * then floors whose neighbours a radius away rise or fall more than the slope allows are dropped
+ * @param InOccupancy The occupancy of the navigable geometry
+ * @param InProfile The agent profile
+ * @return The walkable voxels
+ */
+FVoxelOccupancy FVoxelAgentBaker::BakeProfile(const FVoxelOccupancy& InOccupancy, const FVoxelAgentProfile& InProfile)
+{
+	const FProfileVoxels Voxels = GetProfileVoxels(InOccupancy.GetGrid(), InProfile);
+
+	const FVoxelOccupancy Dilated = Dilate(InOccupancy, Voxels.RadiusX, Voxels.RadiusY);
+	FVoxelOccupancy Walkable = GetClearFloor(InOccupancy, Dilated, Voxels.Height, Voxels.Climb);
+
+	if(InProfile.MaxSlope < 90.0)
+	{
+		FilterSlope(InOccupancy, Voxels.SlopeDistance, Voxels.MaxRise, Walkable);
+	}
+
+	return Walkable;
+}
+
+/**
+ * Rebakes the walkable layer of a single profile inside a box after the occupancy changed
+ * The box is grown by the kernel radius, baked on its own and only the box is copied back,
+ * so the cost depends on the size of the change rather than the size of the grid
+ * A walkable voxel depends on the occupancy up to GetKernelRadius voxels away,
+ * so the box must cover the changed voxels grown by that radius
+ * @param InOccupancy The occupancy of the navigable geometry
+ * @param InProfile The agent profile
+ * @param InVoxelBox The voxels to rebake, clamped to the grid
+ * @param InOutWalkable The walkable layer to update, must share the occupancy's grid
+ */
+void FVoxelAgentBaker::UpdateProfile(const FVoxelOccupancy& InOccupancy, const FVoxelAgentProfile& InProfile, const FVoxelBox& InVoxelBox,
+	FVoxelOccupancy& InOutWalkable)
+{
+	checkf(InOutWalkable.GetGrid() == InOccupancy.GetGrid(), TEXT("Walkable layer doesn't match the occupancy's grid"));
+
+	const FVoxelBox GridBox = InOccupancy.GetGrid().GetVoxelBox();
+	const FVoxelBox VoxelBox = InVoxelBox.Intersect(GridBox);
+
+	if(VoxelBox.IsEmpty())
+	{
+		return;
+	}
+
+	// The region's sides inside the grid are a kernel radius away from the box, so the box bakes as it would in the full grid
+	const FVoxelBox Region = VoxelBox.Expand(GetKernelRadius(InOccupancy.GetGrid(), InProfile)).Intersect(GridBox);
+	const FVoxelOccupancy Walkable = BakeProfile(InOccupancy.GetSubOccupancy(Region), InProfile);
+
+	InOutWalkable.CopyVoxels(Walkable, VoxelBox.Min - Region.Min, VoxelBox);
+}
+
+/**
+ * Gets how far a change to the occupancy can affect a profile's walkable layer
+ * @param InGrid The grid the layer is baked on
+ * @param InProfile The agent profile
+ * @return The radius in voxels along each axis, the agent's radius plus the slope's measuring distance
+ * horizontally, its height plus the slope's largest rise vertically, the step height lies within the height
+ */
+FIntVector FVoxelAgentBaker::GetKernelRadius(const FVoxelGrid& InGrid, const FVoxelAgentProfile& InProfile)
+{
+	const FProfileVoxels Voxels = GetProfileVoxels(InGrid, InProfile);
+
+	return FIntVector(
+		Voxels.RadiusX + Voxels.SlopeDistance + 1,
+		Voxels.RadiusY + Voxels.SlopeDistance + 1,
+		Voxels.Height + Voxels.MaxRise + 1);
+}
+
+/**
+ * Grows the occupied voxels by an elliptic disc on the horizontal plane
+ * Every output row is the OR of the rows within the disc's Y range, each grown along X by the disc's half width at that row
+ * @param InOccupancy The occupancy to grow
+ * @param InRadiusX Radius of the disc along X in voxels
+ * @param InRadiusY Radius of the disc along Y in voxels
+ * @return The grown occupancy
+ */
+FVoxelOccupancy FVoxelAgentBaker::Dilate(const FVoxelOccupancy& InOccupancy, const int32 InRadiusX, const int32 InRadiusY)
+{
+	FVoxelOccupancy Result(InOccupancy.GetGrid());
+
+	const FIntVector Count = InOccupancy.GetGrid().GetVectorVoxelCount();
+	const int32 NumWords = InOccupancy.GetWordsPerRow();
+	const uint64 LastWordMask = GetLastWordMask(Count.X);
+
+	if(NumWords == 0)
+	{
+		return Result;
+	}
+
+	// Half width of the disc along X for every row offset along Y
+	TArray<int32> HalfWidths;
+
+	for(int32 OffsetY = -InRadiusY; OffsetY <= InRadiusY; OffsetY++)
+	{
+		const double Fraction = InRadiusY > 0 ? static_cast<double>(OffsetY) / InRadiusY : 0.0;
+		HalfWidths.Add(FMath::FloorToInt(InRadiusX * FMath::Sqrt(FMath::Max(1.0 - Fraction * Fraction, 0.0)) + UE_KINDA_SMALL_NUMBER));
+	}
+
+	const uint64* InWords = InOccupancy.GetWords().GetData();
+	uint64* OutWords = Result.GetWords().GetData();
+
+	ParallelFor(Count.Z, [&](const int32 Z)
+	{
+		TArray<uint64> Row, ScratchA, ScratchB;
+		Row.SetNumUninitialized(NumWords);
+		ScratchA.SetNumUninitialized(NumWords);
+		ScratchB.SetNumUninitialized(NumWords);
+
+		for(int32 Y = 0; Y < Count.Y; Y++)
+		{
+			uint64* Out = OutWords + Result.GetRowWordIndex(Y, Z);
+
+			for(int32 OffsetY = -InRadiusY; OffsetY <= InRadiusY; OffsetY++)
+			{
+				const int32 SourceY = Y + OffsetY;
+
+				if(SourceY < 0 || SourceY >= Count.Y)
+				{
+					continue;
+				}
+
+				FMemory::Memcpy(Row.GetData(), InWords + InOccupancy.GetRowWordIndex(SourceY, Z), NumWords * sizeof(uint64));
+				DilateRow(Row.GetData(), ScratchA.GetData(), ScratchB.GetData(), NumWords, HalfWidths[OffsetY + InRadiusY], LastWordMask);
+
+				for(int32 Word = 0; Word < NumWords; Word++)
+				{
+					Out[Word] |= Row[Word];
+				}
+			}
+		}
+	});
+
+	return Result;
+}
+
+/**
+ * Finds the empty voxels standing on an occupied voxel with enough free space above them
+ * @param InOccupancy The occupancy of the navigable geometry, floors are taken from it
+ * @param InDilated The occupancy grown by the agent's radius, free space above the climb is taken from it
+ * @param InHeight Number of free voxels the agent needs, starting with the walkable voxel itself
+ * @param InClimb Number of voxels above the floor the agent can step onto, only its own column must be free there
+ * so rising floors nearby, such as stairs and ramps, don't block it
+ * @return The walkable voxels
+ */
+FVoxelOccupancy FVoxelAgentBaker::GetClearFloor(const FVoxelOccupancy& InOccupancy, const FVoxelOccupancy& InDilated, const int32 InHeight,
+	const int32 InClimb)
+{
+	checkf(InOccupancy.GetGrid() == InDilated.GetGrid(), TEXT("Occupancy and dilated occupancy must share a grid"));
+
+	FVoxelOccupancy Result(InOccupancy.GetGrid());
+
+	const FIntVector Count = InOccupancy.GetGrid().GetVectorVoxelCount();
+	const int32 NumWords = InOccupancy.GetWordsPerRow();
+
+	const uint64* InWords = InOccupancy.GetWords().GetData();
+	const uint64* DilatedWords = InDilated.GetWords().GetData();
+	uint64* OutWords = Result.GetWords().GetData();
+
+	// Nothing stands on the bottom slice, there is no floor below it
+	ParallelFor(FMath::Max(Count.Z - 1, 0), [&](const int32 SliceIndex)
+	{
+		const int32 Z = SliceIndex + 1;
+		const int32 MaxZ = FMath::Min(Z + InHeight, Count.Z);
+		const int32 ClimbZ = FMath::Min(Z + FMath::Min(InClimb, InHeight), MaxZ);
+
+		for(int32 Y = 0; Y < Count.Y; Y++)
+		{
+			const uint64* Floor = InWords + InOccupancy.GetRowWordIndex(Y, Z - 1);
+			uint64* Out = OutWords + Result.GetRowWordIndex(Y, Z);
+
+			for(int32 Word = 0; Word < NumWords; Word++)
+			{
+				uint64 Bits = Floor[Word];
+
+				// Space above the top of the grid counts as free
+				for(int32 ClearZ = Z; ClearZ < ClimbZ && Bits; ClearZ++)
+				{
+					Bits &= ~InWords[InOccupancy.GetRowWordIndex(Y, ClearZ) + Word];
+				}
+
+				for(int32 ClearZ = ClimbZ; ClearZ < MaxZ && Bits; ClearZ++)
+				{
+					Bits &= ~DilatedWords[InDilated.GetRowWordIndex(Y, ClearZ) + Word];
+				}
+
+				Out[Word] = Bits;
+			}
+		}
+	});
+
+	return Result;
+}
+
+/**
+ * Drops walkable voxels on slopes that are too steep, or on ledges
+ * A walkable voxel is kept if the columns a distance away along +X, -X, +Y and -Y all have a floor within the allowed rise,
+ * columns outside the grid always pass
+ * @param InOccupancy The occupancy of the navigable geometry
+ * @param InDistance Horizontal distance to the neighbouring columns in voxels
+ * @param InMaxRise Largest allowed height difference to a neighbouring floor in voxels
+ * @param InOutWalkable The walkable voxels to filter
+ */
+void FVoxelAgentBaker::FilterSlope(const FVoxelOccupancy& InOccupancy, const int32 InDistance, const int32 InMaxRise, FVoxelOccupancy& InOutWalkable)
+{
+	checkf(InOccupancy.GetGrid() == InOutWalkable.GetGrid(), TEXT("Occupancy and walkable voxels must share a grid"));
+
+	const FIntVector Count = InOccupancy.GetGrid().GetVectorVoxelCount();
+	const int32 NumWords = InOccupancy.GetWordsPerRow();
+	const uint64 LastWordMask = GetLastWordMask(Count.X);
+
+	if(NumWords == 0)
+	{
+		return;
+	}
+
+	const uint64* InWords = InOccupancy.GetWords().GetData();
+	uint64* WalkableWords = InOutWalkable.GetWords().GetData();
+
+	// Floors within the allowed rise of a slice, i.e. the tops of occupied voxels a few slices up or down
+	auto GetNearFloors = [&InOccupancy, &Count, NumWords, InWords, InMaxRise](const int32 Y, const int32 Z, uint64* Out)
+	{
+		FMemory::Memzero(Out, NumWords * sizeof(uint64));
+
+		for(int32 FloorZ = FMath::Max(Z - InMaxRise, 1); FloorZ <= FMath::Min(Z + InMaxRise, Count.Z - 1); FloorZ++)
+		{
+			const uint64* Below = InWords + InOccupancy.GetRowWordIndex(Y, FloorZ - 1);
+			const uint64* Above = InWords + InOccupancy.GetRowWordIndex(Y, FloorZ);
+
+			for(int32 Word = 0; Word < NumWords; Word++)
+			{
+				Out[Word] |= Below[Word] & ~Above[Word];
+			}
+		}
+	};
+
+	ParallelFor(Count.Z, [&](const int32 Z)
+	{
+		TArray<uint64> Near, Shifted;
+		Near.SetNumUninitialized(NumWords);
+		Shifted.SetNumUninitialized(NumWords);
+
+		auto Keep = [NumWords](uint64* Walkable, const uint64* Mask)
+		{
+			for(int32 Word = 0; Word < NumWords; Word++)
+			{
+				Walkable[Word] &= Mask[Word];
+			}
+		};
+
+		for(int32 Y = 0; Y < Count.Y; Y++)
+		{
+			uint64* Walkable = WalkableWords + InOutWalkable.GetRowWordIndex(Y, Z);
+
+			bool bAnyWalkable = false;
+
+			for(int32 Word = 0; Word < NumWords && !bAnyWalkable; Word++)
+			{
+				bAnyWalkable = Walkable[Word] != 0;
+			}
+
+			if(!bAnyWalkable)
+			{
+				continue;
+			}
+
+			GetNearFloors(Y, Z, Near.GetData());
+
+			ShiftRow(Near.GetData(), Shifted.GetData(), NumWords, InDistance, LastWordMask, true);
+			Keep(Walkable, Shifted.GetData());
+
+			ShiftRow(Near.GetData(), Shifted.GetData(), NumWords, -InDistance, LastWordMask, true);
+			Keep(Walkable, Shifted.GetData());
+
+			if(Y - InDistance >= 0)
+			{
+				GetNearFloors(Y - InDistance, Z, Near.GetData());
+				Keep(Walkable, Near.GetData());
+			}
+
+			if(Y + InDistance < Count.Y)
+			{
+				GetNearFloors(Y + InDistance, Z, Near.GetData());
+				Keep(Walkable, Near.GetData());
+			}
+		}
+	});
+}
@@ -0,0 +1,447 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelBoxDecomposer.h"
+
+#include "Async/ParallelFor.h"
+#include "PhysicsEngine/BodySetup.h"
+
+namespace
+{
+	// Axis orders tried when growing a box, the first axis is grown as far as it goes before the second
+	constexpr int32 GrowOrders[6][3] = {
+		{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}
+	};
+
+	/**
+	 * Sets every voxel of a box, whole words are masked and written at once
+	 * @param InOutOccupancy The occupancy to write to
+	 * @param InVoxelBox The voxels to set, must be inside the grid
+	 */
+	void FillBox(FVoxelOccupancy& InOutOccupancy, const FVoxelBox& InVoxelBox)
+	{
+		if(InVoxelBox.IsEmpty())
+		{
+			return;
+		}
+
+		const int32 FirstWord = InVoxelBox.Min.X >> 6;
+		const int32 LastWord = (InVoxelBox.Max.X - 1) >> 6;
+		const uint64 FirstMask = ~uint64(0) << (InVoxelBox.Min.X & 63);
+		const uint64 LastMask = ~uint64(0) >> (63 - ((InVoxelBox.Max.X - 1) & 63));
+
+		uint64* Words = InOutOccupancy.GetWords().GetData();
+
+		for(int32 Z = InVoxelBox.Min.Z; Z < InVoxelBox.Max.Z; Z++)
+		{
+			for(int32 Y = InVoxelBox.Min.Y; Y < InVoxelBox.Max.Y; Y++)
+			{
+				uint64* Row = Words + InOutOccupancy.GetRowWordIndex(Y, Z);
+
+				for(int32 Word = FirstWord; Word <= LastWord; Word++)
+				{
+					uint64 Mask = ~uint64(0);
+					Mask &= Word == FirstWord ? FirstMask : Mask;
+					Mask &= Word == LastWord ? LastMask : Mask;
+
+					Row[Word] |= Mask;
+				}
+			}
+		}
+	}
+
+	/**
+	 * Gets how far apart two boxes are along one axis
+	 * @return Negative if the ranges overlap, 0 if they touch, positive if there is a gap
+	 */
+	int32 GetAxisGap(const FVoxelBox& A, const FVoxelBox& B, const int32 Axis)
+	{
+		return FMath::Max(A.Min[Axis] - B.Max[Axis], B.Min[Axis] - A.Max[Axis]);
+	}
+
+	/**
+	 * Finds the set a box belongs to, halving the path on the way
+	 * @param InOutParents The parent of every box
+	 * @param InBox The box
+	 * @return The set's root box
+	 */
+	int32 FindRoot(TArray<int32>& InOutParents, int32 InBox)
+	{
+		while(InOutParents[InBox] != InBox)
+		{
+			InOutParents[InBox] = InOutParents[InOutParents[InBox]];
+			InBox = InOutParents[InBox];
+		}
+
+		return InBox;
+	}
+}
+
+/**
+ * Struct constructor
+ * @param bInAllowOverlap Whether boxes may grow through voxels other boxes already cover
+ * @param InMinBoxVoxels Boxes with fewer voxels are dropped
+ * @param InMaxBoxes The number of largest boxes to keep, 0 keeps every box
+ */
+FVoxelBoxDecomposer::FVoxelBoxDecomposer(const bool bInAllowOverlap, const int32 InMinBoxVoxels, const int32 InMaxBoxes)
+	: bAllowOverlap(bInAllowOverlap), MinBoxVoxels(InMinBoxVoxels), MaxBoxes(InMaxBoxes)
+{
+}
+
+/**
+ * Covers every occupied voxel of the grid with boxes
+ * @param InOccupancy The voxels to cover
+ * @return The boxes, largest first when MaxBoxes is set, otherwise in scan order of their first voxel
+ */
+TArray<FVoxelBox> FVoxelBoxDecomposer::Decompose(const FVoxelOccupancy& InOccupancy) const
+{
+	return Decompose(InOccupancy, InOccupancy.GetGrid().GetVoxelBox());
+}
+
+/**
+ * Covers the occupied voxels of a region with boxes, the boxes stay inside the region
+ * @param InOccupancy The voxels to cover
+ * @param InRegion The voxels to decompose, clamped to the grid
+ * @return The boxes, largest first when MaxBoxes is set, otherwise in scan order of their first voxel
+ */
+TArray<FVoxelBox> FVoxelBoxDecomposer::Decompose(const FVoxelOccupancy& InOccupancy, const FVoxelBox& InRegion) const
+{
+	TArray<FVoxelBox> Boxes = GrowBoxes(InOccupancy, InRegion.Intersect(InOccupancy.GetGrid().GetVoxelBox()), bAllowOverlap);
+	FilterBoxes(Boxes);
+
+	return Boxes;
+}
+
+/**
+ * Covers each face connected component of the occupied voxels with its own boxes
+ * Components are found by decomposing without overlap and joining boxes that share part of a face,
+ * then each component is decomposed again in parallel when overlap is allowed
+ * @param InOccupancy The voxels to cover
+ * @return The boxes of each component, components in scan order of their first voxel
+ */
+TArray<TArray<FVoxelBox>> FVoxelBoxDecomposer::DecomposeComponents(const FVoxelOccupancy& InOccupancy) const
+{
+	const FVoxelGrid& Grid = InOccupancy.GetGrid();
+
+	TArray<TArray<FVoxelBox>> Components = GroupTouchingBoxes(GrowBoxes(InOccupancy, Grid.GetVoxelBox(), false));
+
+	ParallelFor(Components.Num(), [this, &Grid, &Components](const int32 ComponentIndex)
+	{
+		TArray<FVoxelBox>& Boxes = Components[ComponentIndex];
+
+		if(bAllowOverlap && Boxes.Num() > 1)
+		{
+			FVoxelBox Bounds;
+
+			for(const FVoxelBox& Box : Boxes)
+			{
+				Bounds = Bounds.Union(Box);
+			}
+
+			// Only this component's voxels, so boxes can't grow into a neighbouring component
+			FVoxelOccupancy Component(Grid.GetSubGrid(Bounds.Min, Bounds.GetSize()));
+
+			for(const FVoxelBox& Box : Boxes)
+			{
+				FillBox(Component, Box.Translate(-Bounds.Min));
+			}
+
+			Boxes = GrowBoxes(Component, Component.GetGrid().GetVoxelBox(), true);
+
+			for(FVoxelBox& Box : Boxes)
+			{
+				Box = Box.Translate(Bounds.Min);
+			}
+		}
+
+		FilterBoxes(Boxes);
+	});
+
+	Components.RemoveAll([](const TArray<FVoxelBox>& Boxes)
+	{
+		return Boxes.IsEmpty();
+	});
+
+	return Components;
+}
+
+/**
+ * Converts boxes to oriented boxes, for a grid laid out in the local space of a transform
+ * @param InGrid The grid the boxes' coordinates are on
+ * @param InBoxes The boxes
+ * @param InTransform Maps the grid's space to world space
+ * @return The oriented boxes in world space
+ */
+TArray<FOOBBoxProxy> FVoxelBoxDecomposer::ToOrientedBoxes(const FVoxelGrid& InGrid, const TArray<FVoxelBox>& InBoxes,
+	const FTransform& InTransform)
+{
+	TArray<FOOBBoxProxy> Result;
+	Result.Reserve(InBoxes.Num());
+
+	for(const FVoxelBox& Box : InBoxes)
+	{
+		Result.Emplace(InGrid.GetBounds(Box), InTransform);
+	}
+
+	return Result;
+}
+
+/**
+ * Converts boxes to collision box elements in the grid's space
+ * @param InGrid The grid the boxes' coordinates are on
+ * @param InBoxes The boxes
+ * @return The box elements, unrotated
+ */
+TArray<FKBoxElem> FVoxelBoxDecomposer::ToBoxElements(const FVoxelGrid& InGrid, const TArray<FVoxelBox>& InBoxes)
+{
+	TArray<FKBoxElem> Result;
+	Result.Reserve(InBoxes.Num());
+
+	for(const FVoxelBox& Box : InBoxes)
+	{
+		const FBox Bounds = InGrid.GetBounds(Box);
+		const FVector Size = Bounds.GetSize();
+
+		FKBoxElem& Element = Result.Emplace_GetRef(float(Size.X), float(Size.Y), float(Size.Z));
+		Element.Center = Bounds.GetCenter();
+	}
+
+	return Result;
+}
+
+/**
+ * Replaces the simple collision of a body setup with boxes, the grid must be laid out in the body's local space
+ * @param InOutBodySetup The body setup to write to
+ * @param InGrid The grid the boxes' coordinates are on
+ * @param InBoxes The boxes
+ * @param bUseSimpleAsComplex Whether complex queries should use the boxes instead of the triangle mesh
+ */
+void FVoxelBoxDecomposer::ApplyToBodySetup(UBodySetup* InOutBodySetup, const FVoxelGrid& InGrid, const TArray<FVoxelBox>& InBoxes,
+	const bool bUseSimpleAsComplex)
+{
+	checkf(InOutBodySetup, TEXT("Body setup is null"));
+
+	InOutBodySetup->Modify();
+	InOutBodySetup->RemoveSimpleCollision();
+	InOutBodySetup->AggGeom.BoxElems = ToBoxElements(InGrid, InBoxes);
+
+	if(bUseSimpleAsComplex)
+	{
+		InOutBodySetup->CollisionTraceFlag = CTF_UseSimpleAsComplex;
+	}
+
+	InOutBodySetup->InvalidatePhysicsData();
+	InOutBodySetup->CreatePhysicsMeshes();
+}
+
+/**
+ * Greedily covers the occupied voxels of a region with boxes
+ * The first uncovered occupied voxel in scan order seeds a box, which is grown one slab at a time along each axis order
+ * and the largest result is kept, until every occupied voxel is covered
+ * @param InOccupancy The voxels to cover
+ * @param InRegion The voxels to decompose, must be inside the grid
+ * @param bInAllowOverlap Whether a box may grow through voxels earlier boxes cover
+ * @return The boxes in scan order of their first voxel
+ */
+TArray<FVoxelBox> FVoxelBoxDecomposer::GrowBoxes(const FVoxelOccupancy& InOccupancy, const FVoxelBox& InRegion, const bool bInAllowOverlap) const
+{
+	TArray<FVoxelBox> Boxes;
+
+	if(InRegion.IsEmpty())
+	{
+		return Boxes;
+	}
+
+	FVoxelOccupancy Covered(InOccupancy.GetGrid());
+
+	const auto IsSlabFree = [&InOccupancy, &Covered, bInAllowOverlap](const FVoxelBox& InSlab)
+	{
+		return InOccupancy.CountOccupied(InSlab) == InSlab.Num() && (bInAllowOverlap || Covered.CountOccupied(InSlab) == 0);
+	};
+
+	const auto GrowBox = [&InRegion, &IsSlabFree](const FIntVector& InSeed, const int32 (&InOrder)[3])
+	{
+		FVoxelBox Box = FVoxelBox::FromCoordinate(InSeed);
+
+		for(const int32 Axis : InOrder)
+		{
+			while(Box.Max[Axis] < InRegion.Max[Axis])
+			{
+				FVoxelBox Slab = Box;
+				Slab.Min[Axis] = Box.Max[Axis];
+				Slab.Max[Axis] = Box.Max[Axis] + 1;
+
+				if(!IsSlabFree(Slab))
+				{
+					break;
+				}
+
+				Box.Max[Axis]++;
+			}
+		}
+
+		return Box;
+	};
+
+	const int32 FirstWord = InRegion.Min.X >> 6;
+	const int32 LastWord = (InRegion.Max.X - 1) >> 6;
+	const uint64 FirstMask = ~uint64(0) << (InRegion.Min.X & 63);
+	const uint64 LastMask = ~uint64(0) >> (63 - ((InRegion.Max.X - 1) & 63));
+
+	const uint64* Words = InOccupancy.GetWords().GetData();
+	const uint64* CoveredWords = Covered.GetWords().GetData();
+
+	for(int32 Z = InRegion.Min.Z; Z < InRegion.Max.Z; Z++)
+	{
+		for(int32 Y = InRegion.Min.Y; Y < InRegion.Max.Y; Y++)
+		{
+			const int32 RowIndex = InOccupancy.GetRowWordIndex(Y, Z);
+
+			for(int32 Word = FirstWord; Word <= LastWord; Word++)
+			{
+				uint64 Mask = ~uint64(0);
+				Mask &= Word == FirstWord ? FirstMask : Mask;
+				Mask &= Word == LastWord ? LastMask : Mask;
+
+				// Every box covers its seed, so the uncovered bits shrink each time round
+				for(uint64 Uncovered = Words[RowIndex + Word] & ~CoveredWords[RowIndex + Word] & Mask; Uncovered != 0;
+					Uncovered = Words[RowIndex + Word] & ~CoveredWords[RowIndex + Word] & Mask)
+				{
+					const FIntVector Seed(Word * 64 + int32(FMath::CountTrailingZeros64(Uncovered)), Y, Z);
+
+					FVoxelBox Best;
+
+					for(const int32 (&Order)[3] : GrowOrders)
+					{
+						const FVoxelBox Box = GrowBox(Seed, Order);
+
+						if(Box.Num() > Best.Num())
+						{
+							Best = Box;
+						}
+					}
+
+					FillBox(Covered, Best);
+					Boxes.Add(Best);
+				}
+			}
+		}
+	}
+
+	return Boxes;
+}
+
+/**
+ * Drops boxes below the minimum size and keeps only the largest boxes when the number of boxes is capped
+ * @param InOutBoxes The boxes to filter
+ */
+void FVoxelBoxDecomposer::FilterBoxes(TArray<FVoxelBox>& InOutBoxes) const
+{
+	if(MinBoxVoxels > 1)
+	{
+		InOutBoxes.RemoveAll([this](const FVoxelBox& Box)
+		{
+			return Box.Num() < MinBoxVoxels;
+		});
+	}
+
+	if(MaxBoxes > 0 && InOutBoxes.Num() > MaxBoxes)
+	{
+		InOutBoxes.StableSort([](const FVoxelBox& A, const FVoxelBox& B)
+		{
+			return A.Num() > B.Num();
+		});
+
+		InOutBoxes.SetNum(MaxBoxes);
+	}
+}
+
+/**
+ * Splits boxes into face connected groups, boxes are joined when they touch across part of a face
+ * The boxes must not overlap, a sweep along X keeps the pair tests to boxes whose X ranges meet
+ * @param InBoxes The boxes
+ * @return The boxes of each group, groups in the order of their first box
+ */
+TArray<TArray<FVoxelBox>> FVoxelBoxDecomposer::GroupTouchingBoxes(const TArray<FVoxelBox>& InBoxes)
+{
+	TArray<int32> Parents;
+	Parents.SetNumUninitialized(InBoxes.Num());
+
+	TArray<int32> Sorted;
+	Sorted.SetNumUninitialized(InBoxes.Num());
+
+	for(int32 Box = 0; Box < InBoxes.Num(); Box++)
+	{
+		Parents[Box] = Box;
+		Sorted[Box] = Box;
+	}
+
+	Sorted.Sort([&InBoxes](const int32 A, const int32 B)
+	{
+		return InBoxes[A].Min.X < InBoxes[B].Min.X;
+	});
+
+	for(int32 SortedA = 0; SortedA < Sorted.Num(); SortedA++)
+	{
+		const FVoxelBox& A = InBoxes[Sorted[SortedA]];
+
+		for(int32 SortedB = SortedA + 1; SortedB < Sorted.Num() && InBoxes[Sorted[SortedB]].Min.X <= A.Max.X; SortedB++)
+		{
+			const FVoxelBox& B = InBoxes[Sorted[SortedB]];
+
+			const int32 GapX = GetAxisGap(A, B, 0);
+			const int32 GapY = GetAxisGap(A, B, 1);
+			const int32 GapZ = GetAxisGap(A, B, 2);
+
+			// Touching along one axis and overlapping along the other two, the boxes never overlap along all three
+			const bool bIsTouching = (GapX == 0 && GapY < 0 && GapZ < 0) ||
+				(GapX < 0 && GapY == 0 && GapZ < 0) ||
+				(GapX < 0 && GapY < 0 && GapZ == 0);
+
+			if(bIsTouching)
+			{
+				Parents[FindRoot(Parents, Sorted[SortedA])] = FindRoot(Parents, Sorted[SortedB]);
+			}
+		}
+	}
+
+	TArray<TArray<FVoxelBox>> Groups;
+	TMap<int32, int32> GroupOfRoot;
+
+	for(int32 Box = 0; Box < InBoxes.Num(); Box++)
+	{
+		const int32 Root = FindRoot(Parents, Box);
+		int32* Group = GroupOfRoot.Find(Root);
+
+		if(!Group)
+		{
+			Group = &GroupOfRoot.Add(Root, Groups.AddDefaulted());
+		}
+
+		Groups[*Group].Add(InBoxes[Box]);
+	}
+
+	return Groups;
+}
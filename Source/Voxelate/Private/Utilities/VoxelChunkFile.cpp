@@ -0,0 +1,391 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelChunkFile.h"
+
+#include "Async/ParallelFor.h"
+#include "Data/VoxelCustomVersion.h"
+#include "HAL/FileManager.h"
+
+/**
+ * Serializes the header of a chunk file
+ * When loading the archive's custom version is set from the file, so everything after it loads with the right layout
+ * @param Ar The archive to serialize with
+ * @param InOutGrid The grid of the chunked occupancy
+ * @param InOutCompressionFormat The format the chunk blocks are compressed with
+ * @param InOutNumChunks The number of chunks in the grid
+ * @return false if the header is malformed or from a newer version
+ */
+bool FVoxelChunkFile::SerializeHeader(FArchive& Ar, FVoxelGrid& InOutGrid, FName& InOutCompressionFormat, int32& InOutNumChunks)
+{
+	uint32 FileMagic = Magic;
+	Ar << FileMagic;
+
+	int32 Version = FVoxelCustomVersion::LatestVersion;
+	Ar << Version;
+
+	if(Ar.IsLoading())
+	{
+		if(FileMagic != Magic || Version < FVoxelCustomVersion::InitialVersion || Version > FVoxelCustomVersion::LatestVersion)
+		{
+			Ar.SetError();
+			return false;
+		}
+
+		Ar.SetCustomVersion(FVoxelCustomVersion::GUID, Version, TEXT("VoxelVer"));
+	}
+
+	Ar << InOutGrid;
+
+	FString CompressionFormatName = InOutCompressionFormat.ToString();
+	Ar << CompressionFormatName;
+	
+	if(Ar.IsLoading())
+	{
+		InOutCompressionFormat = FName(*CompressionFormatName);
+	}
+
+	Ar << InOutNumChunks;
+
+	return !Ar.IsError();
+}
+
+/**
+ * Reads the header and chunk table of a chunk file and checks every entry lies inside the file
+ * @param Ar The archive to read from, positioned at the start of the file
+ * @param OutGrid The grid of the chunked occupancy
+ * @param OutCompressionFormat The format the chunk blocks are compressed with
+ * @param OutTable The entry of every chunk of the grid
+ * @return false if the file is malformed
+ */
+bool FVoxelChunkFile::ReadTable(FArchive& Ar, FVoxelGrid& OutGrid, FName& OutCompressionFormat, TArray<FEntry>& OutTable)
+{
+	int32 NumChunks = 0;
+
+	if(!SerializeHeader(Ar, OutGrid, OutCompressionFormat, NumChunks))
+	{
+		return false;
+	}
+
+	// The grid comes straight from the file, check it before its counts are trusted
+	if(!FVoxelOccupancy::IsGridValid(OutGrid))
+	{
+		return false;
+	}
+
+	const FIntVector ChunkCount = GetChunkCount(OutGrid);
+	const int64 TotalSize = Ar.TotalSize();
+
+	if(NumChunks != int64(ChunkCount.X) * ChunkCount.Y * ChunkCount.Z || TotalSize < Ar.Tell() + FooterSize)
+	{
+		return false;
+	}
+
+	int64 TableOffset = 0;
+	uint32 FooterMagic = 0;
+
+	Ar.Seek(TotalSize - FooterSize);
+	Ar << TableOffset;
+	Ar << FooterMagic;
+
+	if(FooterMagic != Magic || TableOffset < 0 || TableOffset + NumChunks * int64(sizeof(int64) + sizeof(int32)) > TotalSize - FooterSize)
+	{
+		return false;
+	}
+
+	OutTable.SetNum(NumChunks);
+	Ar.Seek(TableOffset);
+
+	for(FEntry& Entry : OutTable)
+	{
+		Ar << Entry;
+
+		if(Entry.Offset != INDEX_NONE && (Entry.Offset < 0 || Entry.Size < 1 || Entry.Offset + Entry.Size > TableOffset))
+		{
+			return false;
+		}
+	}
+
+	return !Ar.IsError();
+}
+
+/**
+ * Writes the chunk table and footer, which end a chunk file
+ * @param Ar The archive to write to
+ * @param InTable The entry of every chunk of the grid
+ * @param InTableOffset Where in the file the table starts
+ */
+void FVoxelChunkFile::WriteTable(FArchive& Ar, TArray<FEntry>& InTable, int64 InTableOffset)
+{
+	for(FEntry& Entry : InTable)
+	{
+		Ar << Entry;
+	}
+
+	uint32 FooterMagic = Magic;
+	Ar << InTableOffset;
+	Ar << FooterMagic;
+}
+
+/**
+ * Finds where the chunks of a sub grid sit in its parent grid
+ * The sub grid must be on the same lattice, start on a chunk boundary of the parent and end on one or on the parent's end,
+ * so each of its chunks is exactly one of the parent's chunks
+ * @param InParentGrid The parent grid
+ * @param InGrid The sub grid
+ * @param OutChunkOffset The parent chunk coordinate of the sub grid's first chunk
+ * @return false if the sub grid's chunks aren't the parent's chunks
+ */
+bool FVoxelChunkFile::GetChunkOffset(const FVoxelGrid& InParentGrid, const FVoxelGrid& InGrid, FIntVector& OutChunkOffset)
+{
+	if(InParentGrid.GetVoxelSize() != InGrid.GetVoxelSize())
+	{
+		return false;
+	}
+
+	const FIntVector Offset = InGrid.GetLatticeOrigin() - InParentGrid.GetLatticeOrigin();
+	const FIntVector End = Offset + InGrid.GetVectorVoxelCount();
+	const FIntVector ParentCount = InParentGrid.GetVectorVoxelCount();
+
+	for(int32 Axis = 0; Axis < 3; Axis++)
+	{
+		if(Offset[Axis] < 0 || Offset[Axis] % FVoxelOccupancy::ChunkSize != 0 || End[Axis] > ParentCount[Axis] ||
+			(End[Axis] % FVoxelOccupancy::ChunkSize != 0 && End[Axis] != ParentCount[Axis]))
+		{
+			return false;
+		}
+	}
+
+	OutChunkOffset = Offset / FVoxelOccupancy::ChunkSize;
+
+	return true;
+}
+
+/**
+ * Reads the chunks held by a chunk file into an occupancy
+ * If the file's grid is the occupancy's grid or a chunk aligned sub grid of it only the chunks in the file are overwritten,
+ * so reading several files into one occupancy merges them, otherwise the occupancy is reset to the file's grid first
+ * Blocks are read in one pass and uncompressed in parallel into a temporary occupancy, which is only copied over on success
+ * @param InFilename The chunk file
+ * @param InOutOccupancy The occupancy to read into
+ * @return false if the file couldn't be read or is malformed, the occupancy is left untouched
+ */
+bool FVoxelChunkFile::ReadChunks(const FString& InFilename, FVoxelOccupancy& InOutOccupancy)
+{
+	const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*InFilename));
+
+	if(!Reader)
+	{
+		return false;
+	}
+
+	FVoxelGrid Grid;
+	FName CompressionFormat;
+	TArray<FEntry> Table;
+
+	if(!ReadTable(*Reader, Grid, CompressionFormat, Table))
+	{
+		return false;
+	}
+
+	FIntVector ChunkOffset;
+	const bool bIsSubGrid = GetChunkOffset(InOutOccupancy.GetGrid(), Grid, ChunkOffset);
+
+	const int32 NumChunks = Table.Num();
+	const FIntVector ChunkCount = GetChunkCount(Grid);
+
+	TArray<TArray<uint8>> Blocks;
+	Blocks.SetNum(NumChunks);
+
+	for(int32 ChunkIndex = 0; ChunkIndex < NumChunks && !Reader->IsError(); ChunkIndex++)
+	{
+		if(Table[ChunkIndex].Offset != INDEX_NONE)
+		{
+			Blocks[ChunkIndex].SetNumUninitialized(Table[ChunkIndex].Size);
+			Reader->Seek(Table[ChunkIndex].Offset);
+			Reader->Serialize(Blocks[ChunkIndex].GetData(), Table[ChunkIndex].Size);
+		}
+	}
+
+	if(Reader->IsError())
+	{
+		return false;
+	}
+
+	FVoxelOccupancy Loaded(Grid);
+
+	TArray<bool> IsChunkValid;
+	IsChunkValid.Init(true, NumChunks);
+
+	ParallelFor(NumChunks, [&Loaded, &Table, &Blocks, &IsChunkValid, &ChunkCount, CompressionFormat](const int32 ChunkIndex)
+	{
+		if(Table[ChunkIndex].Offset != INDEX_NONE)
+		{
+			const FIntVector ChunkCoordinate(
+				ChunkIndex % ChunkCount.X,
+				ChunkIndex / ChunkCount.X % ChunkCount.Y,
+				ChunkIndex / (ChunkCount.X * ChunkCount.Y));
+
+			IsChunkValid[ChunkIndex] = Loaded.UncompressChunk(ChunkCoordinate, CompressionFormat, Blocks[ChunkIndex]);
+		}
+	});
+
+	if(IsChunkValid.Contains(false))
+	{
+		return false;
+	}
+
+	if(!bIsSubGrid)
+	{
+		InOutOccupancy = MoveTemp(Loaded);
+		return true;
+	}
+
+	// Each of the file's chunks is exactly one of the occupancy's chunks, so their words copy over as they are
+	ParallelFor(NumChunks, [&InOutOccupancy, &Loaded, &Table, &ChunkCount, &ChunkOffset](const int32 ChunkIndex)
+	{
+		if(Table[ChunkIndex].Offset != INDEX_NONE)
+		{
+			const FIntVector ChunkCoordinate(
+				ChunkIndex % ChunkCount.X,
+				ChunkIndex / ChunkCount.X % ChunkCount.Y,
+				ChunkIndex / (ChunkCount.X * ChunkCount.Y));
+
+			TArray<uint64> ChunkWords;
+			Loaded.GetChunkWords(ChunkCoordinate, ChunkWords);
+			InOutOccupancy.SetChunkWords(ChunkCoordinate + ChunkOffset, ChunkWords);
+		}
+	});
+
+	return true;
+}
+
+/**
+ * Merges chunk files of chunk aligned sub grids into a single chunk file for their parent grid
+ * Blocks are copied as they are, nothing is uncompressed, so every input must use the same compression format
+ * If more than one input holds a chunk the last one wins
+ * @param InFilenames The chunk files to merge
+ * @param InGrid The parent grid
+ * @param InFilename The chunk file to write
+ * @return false if an input couldn't be read, doesn't fit the parent grid or the output couldn't be written
+ */
+bool FVoxelChunkFile::Merge(const TArray<FString>& InFilenames, const FVoxelGrid& InGrid, const FString& InFilename)
+{
+	const FIntVector ParentChunkCount = GetChunkCount(InGrid);
+	int32 NumChunks = ParentChunkCount.X * ParentChunkCount.Y * ParentChunkCount.Z;
+
+	const TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*InFilename));
+
+	if(!Writer)
+	{
+		return false;
+	}
+
+	TArray<FEntry> MergedTable;
+	MergedTable.Init(FEntry(), NumChunks);
+
+	bool bHasHeader = false;
+	FName MergedCompressionFormat;
+	TArray<uint8> Block;
+
+	for(const FString& Filename : InFilenames)
+	{
+		const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+
+		FVoxelGrid Grid;
+		FName CompressionFormat;
+		TArray<FEntry> Table;
+		FIntVector ChunkOffset;
+
+		if(!Reader || !ReadTable(*Reader, Grid, CompressionFormat, Table) || !GetChunkOffset(InGrid, Grid, ChunkOffset) ||
+			(bHasHeader && CompressionFormat != MergedCompressionFormat))
+		{
+			return false;
+		}
+
+		if(!bHasHeader)
+		{
+			FVoxelGrid MergedGrid = InGrid;
+			MergedCompressionFormat = CompressionFormat;
+			SerializeHeader(*Writer, MergedGrid, MergedCompressionFormat, NumChunks);
+			bHasHeader = true;
+		}
+
+		const FIntVector ChunkCount = GetChunkCount(Grid);
+
+		for(int32 ChunkIndex = 0; ChunkIndex < Table.Num(); ChunkIndex++)
+		{
+			if(Table[ChunkIndex].Offset == INDEX_NONE)
+			{
+				continue;
+			}
+
+			Block.SetNumUninitialized(Table[ChunkIndex].Size);
+			Reader->Seek(Table[ChunkIndex].Offset);
+			Reader->Serialize(Block.GetData(), Block.Num());
+
+			const FIntVector ParentChunkCoordinate = ChunkOffset + FIntVector(
+				ChunkIndex % ChunkCount.X,
+				ChunkIndex / ChunkCount.X % ChunkCount.Y,
+				ChunkIndex / (ChunkCount.X * ChunkCount.Y));
+
+			FEntry& Entry = MergedTable[ParentChunkCoordinate.X + (ParentChunkCoordinate.Y + ParentChunkCoordinate.Z * ParentChunkCount.Y) * ParentChunkCount.X];
+			Entry.Offset = Writer->Tell();
+			Entry.Size = Block.Num();
+
+			Writer->Serialize(Block.GetData(), Block.Num());
+		}
+
+		if(Reader->IsError())
+		{
+			return false;
+		}
+	}
+
+	if(!bHasHeader)
+	{
+		FVoxelGrid MergedGrid = InGrid;
+		SerializeHeader(*Writer, MergedGrid, MergedCompressionFormat, NumChunks);
+	}
+
+	WriteTable(*Writer, MergedTable, Writer->Tell());
+
+	return Writer->Close();
+}
+
+/**
+ * Gets the number of chunks of a grid in each dimension, matching FVoxelOccupancy
+ * @param InGrid The grid
+ * @return The number of chunks in each dimension
+ */
+FIntVector FVoxelChunkFile::GetChunkCount(const FVoxelGrid& InGrid)
+{
+	const FIntVector Count = InGrid.GetVectorVoxelCount();
+
+	return FIntVector(
+		FMath::DivideAndRoundUp(Count.X, FVoxelOccupancy::ChunkSize),
+		FMath::DivideAndRoundUp(Count.Y, FVoxelOccupancy::ChunkSize),
+		FMath::DivideAndRoundUp(Count.Z, FVoxelOccupancy::ChunkSize));
+}
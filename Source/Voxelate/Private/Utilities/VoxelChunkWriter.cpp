@@ -0,0 +1,210 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelChunkWriter.h"
+
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+
+/**
+ * Class constructor
+ * @param InOccupancy The occupancy to write, must outlive the writer
+ * @param InCompressionFormat The format chunks are compressed with, for example NAME_Oodle or NAME_Zlib, NAME_None to store the words as they are
+ * @param InMaxChunksInFlight The most chunks waiting to be compressed or written at once
+ */
+FVoxelChunkWriter::FVoxelChunkWriter(const FVoxelOccupancy& InOccupancy, const FName InCompressionFormat, const int32 InMaxChunksInFlight)
+	: Occupancy(InOccupancy), CompressionFormat(InCompressionFormat), MaxChunksInFlight(FMath::Max(InMaxChunksInFlight, 1))
+{
+}
+
+/**
+ * Class destructor, closes the file if it's still open
+ */
+FVoxelChunkWriter::~FVoxelChunkWriter()
+{
+	if(IsOpen())
+	{
+		Close();
+	}
+}
+
+/**
+ * Creates the chunk file and writes its header, missing directories are created
+ * @param InFilename The chunk file
+ * @return false if the file couldn't be created
+ */
+bool FVoxelChunkWriter::Open(const FString& InFilename)
+{
+	checkf(!IsOpen(), TEXT("Chunk writer is already open"));
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(InFilename));
+
+	FileHandle.Reset(PlatformFile.OpenWrite(*InFilename));
+
+	if(!FileHandle)
+	{
+		return false;
+	}
+
+	FVoxelGrid Grid = Occupancy.GetGrid();
+	FName Format = CompressionFormat;
+	int32 NumChunks = Occupancy.GetNumChunks();
+
+	TArray<uint8> Header;
+	FMemoryWriter Writer(Header);
+	FVoxelChunkFile::SerializeHeader(Writer, Grid, Format, NumChunks);
+
+	if(!FileHandle->Write(Header.GetData(), Header.Num()))
+	{
+		FileHandle.Reset();
+		return false;
+	}
+
+	FileOffset = Header.Num();
+	ChunkTable.Init(FVoxelChunkFile::FEntry(), NumChunks);
+	bHasError = false;
+
+	return true;
+}
+
+/**
+ * Checks if the chunk file is open
+ * @return true if chunks can be written
+ */
+bool FVoxelChunkWriter::IsOpen() const
+{
+	return FileHandle.IsValid();
+}
+
+/**
+ * Queues a finished chunk to be compressed and written
+ * Blocks while MaxChunksInFlight chunks are already queued
+ * Writing a chunk again replaces its entry in the chunk table, the old block stays in the file unused
+ * @param InChunkCoordinate The chunk coordinate
+ */
+void FVoxelChunkWriter::WriteChunk(const FIntVector& InChunkCoordinate)
+{
+	checkf(IsOpen(), TEXT("Chunk writer isn't open"));
+
+	const int32 ChunkIndex = Occupancy.GetChunkIndex(InChunkCoordinate);
+
+	// IO tasks finish in order, so retire finished ones from the front and wait on the oldest when at the limit
+	while(WritesInFlight.Num() > 0 && (WritesInFlight.Num() >= MaxChunksInFlight || WritesInFlight[0].IsCompleted()))
+	{
+		WritesInFlight[0].Wait();
+		WritesInFlight.RemoveAt(0);
+	}
+
+	const TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> Block = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+
+	TArray<UE::Tasks::FTask, TInlineAllocator<2>> Prerequisites;
+
+	Prerequisites.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, InChunkCoordinate, Block]()
+	{
+		Occupancy.CompressChunk(InChunkCoordinate, CompressionFormat, *Block);
+	}));
+
+	// Chaining every IO task to the previous one keeps the blocks in submission order and the file handle single threaded
+	if(WritesInFlight.Num() > 0)
+	{
+		Prerequisites.Add(WritesInFlight.Last());
+	}
+
+	WritesInFlight.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, ChunkIndex, Block]()
+	{
+		WriteBlock(ChunkIndex, *Block);
+	}, Prerequisites));
+}
+
+/**
+ * Queues every chunk in a box of chunk coordinates, in chunk index order
+ * @param InChunkBox The chunk box, clamped to the occupancy's chunks
+ */
+void FVoxelChunkWriter::WriteChunks(const FVoxelBox& InChunkBox)
+{
+	InChunkBox.Intersect(FVoxelBox(FIntVector::ZeroValue, Occupancy.GetChunkCount())).ForEach([this](const FIntVector& ChunkCoordinate)
+	{
+		WriteChunk(ChunkCoordinate);
+	});
+}
+
+/**
+ * Queues every chunk of the occupancy, in chunk index order
+ */
+void FVoxelChunkWriter::WriteAllChunks()
+{
+	WriteChunks(FVoxelBox(FIntVector::ZeroValue, Occupancy.GetChunkCount()));
+}
+
+/**
+ * Waits for every queued chunk, then writes the chunk table and closes the file
+ * @return false if any write failed, the file is incomplete in that case
+ */
+bool FVoxelChunkWriter::Close()
+{
+	checkf(IsOpen(), TEXT("Chunk writer isn't open"));
+
+	if(WritesInFlight.Num() > 0)
+	{
+		WritesInFlight.Last().Wait();
+		WritesInFlight.Reset();
+	}
+
+	TArray<uint8> Footer;
+	FMemoryWriter Writer(Footer);
+	FVoxelChunkFile::WriteTable(Writer, ChunkTable, FileOffset);
+
+	const bool bSuccess = !bHasError && FileHandle->Write(Footer.GetData(), Footer.Num()) && FileHandle->Flush();
+
+	FileHandle.Reset();
+	ChunkTable.Empty();
+
+	return bSuccess;
+}
+
+/**
+ * Writes a compressed block to the end of the file, runs on the IO stage
+ * @param InChunkIndex The index of the block's chunk
+ * @param InBlock The block
+ */
+void FVoxelChunkWriter::WriteBlock(const int32 InChunkIndex, const TArray<uint8>& InBlock)
+{
+	if(bHasError)
+	{
+		return;
+	}
+
+	if(!FileHandle->Write(InBlock.GetData(), InBlock.Num()))
+	{
+		bHasError = true;
+		return;
+	}
+
+	ChunkTable[InChunkIndex].Offset = FileOffset;
+	ChunkTable[InChunkIndex].Size = InBlock.Num();
+	FileOffset += InBlock.Num();
+}
@@ -0,0 +1,127 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelComponentFilter.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+/**
+ * Checks if a component should be voxelated
+ * Only reads the component, so it is safe to call from worker threads while the world isn't ticking
+ * @param InComponent The component to check
+ * @return true if the component is navigable geometry
+ */
+bool FVoxelComponentFilter::PassesFilter(const UPrimitiveComponent* InComponent) const
+{
+	if(!IsValid(InComponent) || !InComponent->IsRegistered() || !InComponent->IsCollisionEnabled())
+	{
+		return false;
+	}
+
+	if(bRequireNavigationRelevance && !InComponent->CanEverAffectNavigation())
+	{
+		return false;
+	}
+
+	if(!bIncludeMovable && InComponent->Mobility == EComponentMobility::Movable)
+	{
+		return false;
+	}
+
+	if(InComponent->GetCollisionResponseToChannel(CollisionChannel) < MinimumResponse)
+	{
+		return false;
+	}
+
+	if(IgnoredCollisionProfiles.Contains(InComponent->GetCollisionProfileName()))
+	{
+		return false;
+	}
+
+	if(IncludedClasses.Num() > 0 && !IsAnyClass(InComponent, IncludedClasses))
+	{
+		return false;
+	}
+
+	return !IsAnyClass(InComponent, ExcludedClasses);
+}
+
+/**
+ * Collects every primitive component of every level of a world, unfiltered
+ * @param InWorld The world to collect from
+ * @return The components
+ */
+TArray<UPrimitiveComponent*> FVoxelComponentFilter::GatherComponents(const UWorld* InWorld)
+{
+	TArray<UPrimitiveComponent*> Components;
+
+	if(!InWorld)
+	{
+		return Components;
+	}
+
+	for(const ULevel* Level : InWorld->GetLevels())
+	{
+		if(!Level)
+		{
+			continue;
+		}
+
+		for(AActor* Actor : Level->Actors)
+		{
+			if(IsValid(Actor))
+			{
+				Actor->ForEachComponent<UPrimitiveComponent>(false, [&Components](UPrimitiveComponent* Component)
+				{
+					Components.Add(Component);
+				});
+			}
+		}
+	}
+
+	return Components;
+}
+
+/**
+ * Checks if a component is of any of the given classes
+ * @param InComponent The component to check
+ * @param InClasses The classes to check against, null entries are ignored
+ * @return true if the component is of at least one class
+ */
+bool FVoxelComponentFilter::IsAnyClass(const UPrimitiveComponent* InComponent, const TArray<TSubclassOf<UPrimitiveComponent>>& InClasses)
+{
+	for(const TSubclassOf<UPrimitiveComponent>& Class : InClasses)
+	{
+		if(Class && InComponent->IsA(Class))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,581 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelCostField.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	// Buckets of the dial queue, more than the costliest step so a step never lands in the bucket being drained
+	constexpr int32 NumBuckets = 512;
+
+	/**
+	 * Gets the cost of a step into a voxel, scaled by the step's length
+	 * @param InOffset The step, one of the 26 neighbour offsets
+	 * @param InStepCost The voxel's step cost
+	 * @return The cost, at least 1
+	 */
+	int32 ScaleStepCost(const FIntVector& InOffset, const int32 InStepCost)
+	{
+		// Face, edge and corner steps, in tenths
+		constexpr int32 LengthTenths[4] = {0, 10, 14, 17};
+
+		const int32 Axes = FMath::Abs(InOffset.X) + FMath::Abs(InOffset.Y) + FMath::Abs(InOffset.Z);
+
+		return FMath::Max((FMath::Max(InStepCost, 1) * LengthTenths[Axes] + 5) / 10, 1);
+	}
+}
+
+/**
+ * Class constructor, the field starts with no sources so every voxel is unreachable
+ * @param InTraversable The voxels paths can go through, e.g. a walkable layer or the empty voxels reachable from a spawn
+ * @param InRegion The voxels the field covers, clamped to the grid
+ * @param InConnectivity The neighbours a step can go to
+ * @param InStepCosts The cost of a step into each voxel on the traversable voxels' grid, DefaultStepCost for every voxel when null
+ * @param InCornerCutting Which diagonal steps are taken past blocked voxels
+ */
+FVoxelCostField::FVoxelCostField(const FVoxelOccupancy& InTraversable, const FVoxelBox& InRegion, const EVoxelConnectivity InConnectivity,
+	const TVoxelAttribute<uint8>* InStepCosts, const EVoxelCornerCutting InCornerCutting)
+	: Region(InRegion.Intersect(InTraversable.GetGrid().GetVoxelBox())),
+	Traversable(InTraversable.GetSubOccupancy(Region)),
+	Neighbourhood(Traversable.GetGrid(), InConnectivity),
+	CornerCutting(InCornerCutting)
+{
+	const FIntVector Size = Region.GetSize();
+
+	if(InStepCosts)
+	{
+		checkf(InStepCosts->GetGrid() == InTraversable.GetGrid(), TEXT("Step costs must be on the traversable voxels' grid"));
+
+		StepCosts.SetNumUninitialized(Region.Num());
+
+		for(int32 Z = 0; Z < Size.Z; Z++)
+		{
+			for(int32 Y = 0; Y < Size.Y; Y++)
+			{
+				const int32 SourceIndex = InStepCosts->GetGrid().GetVoxelIndex(Region.Min + FIntVector(0, Y, Z));
+				FMemory::Memcpy(StepCosts.GetData() + (Y + Z * Size.Y) * Size.X, InStepCosts->GetValues().GetData() + SourceIndex, Size.X);
+			}
+		}
+	}
+
+	Costs.Init(Traversable.GetGrid(), Unreachable);
+	Owners.Init(NoSource, Region.Num());
+
+	BlockCount = FIntVector(
+		FMath::DivideAndRoundUp(Size.X, BlockSize),
+		FMath::DivideAndRoundUp(Size.Y, BlockSize),
+		FMath::DivideAndRoundUp(Size.Z, BlockSize));
+
+	PendingVoxels.SetNum(BlockCount.X * BlockCount.Y * BlockCount.Z);
+}
+
+/**
+ * Gets the chunks around a set of locations, the usual region for a field read by agents at those locations
+ * @param InOccupancy The occupancy the field will be built on
+ * @param InLocations The locations, e.g. the agents, locations outside the grid are ignored
+ * @param InChunkRadius The number of chunks to include on each side of a location's chunk
+ * @return The smallest voxel box holding every chunk, clamped to the grid
+ */
+FVoxelBox FVoxelCostField::GetRegionAround(const FVoxelOccupancy& InOccupancy, const TArray<FVector>& InLocations, const int32 InChunkRadius)
+{
+	const FVoxelGrid& Grid = InOccupancy.GetGrid();
+	const FVoxelBox AllChunks(FIntVector::ZeroValue, InOccupancy.GetChunkCount());
+
+	FVoxelBox Result;
+
+	for(const FVector& Location : InLocations)
+	{
+		if(!Grid.IsLocationInBounds(Location))
+		{
+			continue;
+		}
+
+		const FIntVector Coordinate = Grid.GetVoxelCoordinate(Location);
+
+		// The far faces of the bounds are inside the bounds but past the last voxel
+		if(!Grid.IsVoxelCoordinateValid(Coordinate))
+		{
+			continue;
+		}
+
+		const FVoxelBox Chunks = FVoxelBox::FromCoordinate(Coordinate / FVoxelOccupancy::ChunkSize).Expand(InChunkRadius).Intersect(AllChunks);
+
+		Result = Result.Union(FVoxelBox(Chunks.Min * FVoxelOccupancy::ChunkSize, Chunks.Max * FVoxelOccupancy::ChunkSize));
+	}
+
+	return Result.Intersect(Grid.GetVoxelBox());
+}
+
+const FVoxelBox& FVoxelCostField::GetRegion() const
+{
+	return Region;
+}
+
+/**
+ * Gets the distance of every voxel of the region, on the region's grid
+ * @return The distances, Unreachable where no source reaches
+ */
+const TVoxelAttribute<uint16>& FVoxelCostField::GetCosts() const
+{
+	return Costs;
+}
+
+/**
+ * Gets the distance of a voxel to the nearest source
+ * @param InCoordinate The voxel coordinate in the traversable voxels' grid
+ * @return The distance, Unreachable if no source reaches the voxel or it is outside the region
+ */
+uint16 FVoxelCostField::GetCost(const FIntVector& InCoordinate) const
+{
+	return Region.Contains(InCoordinate) ? Costs[InCoordinate - Region.Min] : Unreachable;
+}
+
+/**
+ * Gets the distance of the voxel holding a location to the nearest source
+ * @param InLocation The world location
+ * @return The distance, Unreachable if no source reaches the voxel or it is outside the region
+ */
+uint16 FVoxelCostField::GetCost(const FVector& InLocation) const
+{
+	const FVoxelGrid& Grid = Costs.GetGrid();
+
+	if(!Grid.IsLocationInBounds(InLocation))
+	{
+		return Unreachable;
+	}
+
+	const FIntVector Coordinate = Grid.GetVoxelCoordinate(InLocation);
+
+	return Grid.IsVoxelCoordinateValid(Coordinate) ? Costs[Coordinate] : Unreachable;
+}
+
+/**
+ * Checks if a step leaves a traversable voxel for a traversable voxel without cutting a blocked corner
+ * The step must be one the field's connectivity allows
+ * @param InLocalCoordinate The voxel the step starts from, in the region's grid
+ * @param InOffset The step
+ * @return true if the step can be taken, steps leaving the region can't
+ */
+bool FVoxelCostField::CanStep(const FIntVector& InLocalCoordinate, const FIntVector& InOffset) const
+{
+	const FVoxelGrid& Grid = Traversable.GetGrid();
+
+	const auto IsTraversable = [this, &Grid](const FIntVector& InCoordinate)
+	{
+		return Grid.IsVoxelCoordinateValid(InCoordinate) && Traversable.IsOccupied(InCoordinate);
+	};
+
+	if(!IsTraversable(InLocalCoordinate + InOffset))
+	{
+		return false;
+	}
+
+	switch(CornerCutting)
+	{
+	case EVoxelCornerCutting::PreventHorizontal:
+		return InOffset.X == 0 || InOffset.Y == 0 ||
+			(IsTraversable(InLocalCoordinate + FIntVector(InOffset.X, 0, InOffset.Z)) &&
+			IsTraversable(InLocalCoordinate + FIntVector(0, InOffset.Y, InOffset.Z)));
+	case EVoxelCornerCutting::Prevent:
+		if(FMath::Abs(InOffset.X) + FMath::Abs(InOffset.Y) + FMath::Abs(InOffset.Z) < 2)
+		{
+			return true;
+		}
+
+		return (InOffset.X == 0 || IsTraversable(InLocalCoordinate + FIntVector(InOffset.X, 0, 0))) &&
+			(InOffset.Y == 0 || IsTraversable(InLocalCoordinate + FIntVector(0, InOffset.Y, 0))) &&
+			(InOffset.Z == 0 || IsTraversable(InLocalCoordinate + FIntVector(0, 0, InOffset.Z)));
+	default:
+		return true;
+	}
+}
+
+/**
+ * Adds a source, applied by the next update
+ * @param InCoordinate The source's voxel in the traversable voxels' grid, sources outside the region or on untraversable voxels reach nothing
+ * @param InInitialCost The distance of the source's own voxel, lets some sources count for less than others
+ * @return The source's handle
+ */
+int32 FVoxelCostField::AddSource(const FIntVector& InCoordinate, const uint16 InInitialCost)
+{
+	uint16 Source;
+
+	if(!FreeSources.IsEmpty())
+	{
+		Source = FreeSources.Pop();
+	}
+	else
+	{
+		checkf(Sources.Num() < NoSource, TEXT("A cost field can't hold more than %d sources"), int32(NoSource));
+
+		Source = uint16(Sources.Add(FSource()));
+	}
+
+	Sources[Source] = FSource{InCoordinate, InInitialCost, true};
+	PendingAdditions.Add(Source);
+
+	return Source;
+}
+
+/**
+ * Moves a source or changes its initial cost, applied by the next update
+ * @param InSource The source's handle
+ * @param InCoordinate The source's new voxel in the traversable voxels' grid
+ * @param InInitialCost The new distance of the source's own voxel
+ */
+void FVoxelCostField::MoveSource(const int32 InSource, const FIntVector& InCoordinate, const uint16 InInitialCost)
+{
+	checkf(Sources.IsValidIndex(InSource) && Sources[InSource].bIsActive, TEXT("Invalid source %d"), InSource);
+
+	FSource& Source = Sources[InSource];
+
+	PendingRemovals.Emplace(uint16(InSource), Source.Coordinate);
+	PendingAdditions.AddUnique(uint16(InSource));
+
+	Source.Coordinate = InCoordinate;
+	Source.InitialCost = InInitialCost;
+}
+
+/**
+ * Removes a source, applied by the next update, the handle can be reused after the update
+ * @param InSource The source's handle
+ */
+void FVoxelCostField::RemoveSource(const int32 InSource)
+{
+	checkf(Sources.IsValidIndex(InSource) && Sources[InSource].bIsActive, TEXT("Invalid source %d"), InSource);
+
+	PendingRemovals.Emplace(uint16(InSource), Sources[InSource].Coordinate);
+	PendingFrees.Add(uint16(InSource));
+
+	Sources[InSource].bIsActive = false;
+}
+
+/**
+ * Applies the pending source changes and spreads the distances until every block settles
+ * Blocks are spread in parallel rounds, only the blocks that gained a lower distance take part in a round
+ */
+void FVoxelCostField::Update()
+{
+	// Clear what removed and moved sources reached first, the voxels around the cleared ones seed the refill
+	for(const TPair<uint16, FIntVector>& Removal : PendingRemovals)
+	{
+		ClearSource(Removal.Key, Removal.Value);
+	}
+
+	for(const uint16 Source : PendingFrees)
+	{
+		Sources[Source] = FSource();
+		FreeSources.Add(Source);
+	}
+
+	// A cleared source may have taken over other sources' own voxels, so every source is put back after a removal
+	if(!PendingRemovals.IsEmpty())
+	{
+		for(int32 Source = 0; Source < Sources.Num(); Source++)
+		{
+			if(Sources[Source].bIsActive)
+			{
+				SeedSource(uint16(Source));
+			}
+		}
+	}
+	else
+	{
+		for(const uint16 Source : PendingAdditions)
+		{
+			if(Sources[Source].bIsActive)
+			{
+				SeedSource(Source);
+			}
+		}
+	}
+
+	PendingRemovals.Reset();
+	PendingFrees.Reset();
+	PendingAdditions.Reset();
+
+	TArray<int32> ActiveBlocks;
+
+	for(int32 Block = 0; Block < PendingVoxels.Num(); Block++)
+	{
+		if(!PendingVoxels[Block].IsEmpty())
+		{
+			ActiveBlocks.Add(Block);
+		}
+	}
+
+	TArray<TArray<FHandOver>> HandOvers;
+	TArray<uint8> IsBlockActive;
+
+	while(!ActiveBlocks.IsEmpty())
+	{
+		HandOvers.Reset();
+		HandOvers.SetNum(ActiveBlocks.Num());
+
+		// Every task only writes the voxels of its own block
+		ParallelFor(ActiveBlocks.Num(), [this, &ActiveBlocks, &HandOvers](const int32 ActiveIndex)
+		{
+			const int32 Block = ActiveBlocks[ActiveIndex];
+			const FIntVector BlockCoordinate(Block % BlockCount.X, (Block / BlockCount.X) % BlockCount.Y, Block / (BlockCount.X * BlockCount.Y));
+
+			SpreadBlock(BlockCoordinate, PendingVoxels[Block], HandOvers[ActiveIndex]);
+		});
+
+		IsBlockActive.Reset();
+		IsBlockActive.SetNumZeroed(PendingVoxels.Num());
+		ActiveBlocks.Reset();
+
+		for(const TArray<FHandOver>& BlockHandOvers : HandOvers)
+		{
+			for(const FHandOver& HandOver : BlockHandOvers)
+			{
+				if(HandOver.Cost >= Costs[HandOver.Index])
+				{
+					continue;
+				}
+
+				Costs[HandOver.Index] = HandOver.Cost;
+				Owners[HandOver.Index] = HandOver.Source;
+
+				const int32 Block = GetBlockIndex(Costs.GetGrid().GetVoxelCoordinate(HandOver.Index));
+				PendingVoxels[Block].Add(HandOver.Index);
+
+				if(!IsBlockActive[Block])
+				{
+					IsBlockActive[Block] = 1;
+					ActiveBlocks.Add(Block);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Clears every voxel whose distance comes from a source, walking out from the source through the voxels it owns
+ * The reached voxels around the cleared ones are queued so the other sources fill the hole
+ * @param InSource The source
+ * @param InCoordinate The voxel the source was on when it was last applied
+ */
+void FVoxelCostField::ClearSource(const uint16 InSource, const FIntVector& InCoordinate)
+{
+	if(!Region.Contains(InCoordinate))
+	{
+		return;
+	}
+
+	const FVoxelGrid& Grid = Costs.GetGrid();
+	const int32 SourceIndex = Grid.GetVoxelIndex(InCoordinate - Region.Min);
+
+	if(Owners[SourceIndex] != InSource)
+	{
+		return;
+	}
+
+	TArray<int32> Queue;
+	Queue.Add(SourceIndex);
+
+	Costs[SourceIndex] = Unreachable;
+	Owners[SourceIndex] = NoSource;
+
+	for(int32 Head = 0; Head < Queue.Num(); Head++)
+	{
+		Neighbourhood.ForEachNeighbour(Grid.GetVoxelCoordinate(Queue[Head]), [&](const FIntVector& Neighbour, const int32 NeighbourIndex)
+		{
+			if(Owners[NeighbourIndex] == InSource)
+			{
+				Costs[NeighbourIndex] = Unreachable;
+				Owners[NeighbourIndex] = NoSource;
+				Queue.Add(NeighbourIndex);
+			}
+			else if(Costs[NeighbourIndex] != Unreachable)
+			{
+				PendingVoxels[GetBlockIndex(Neighbour)].Add(NeighbourIndex);
+			}
+		});
+	}
+}
+
+/**
+ * Puts a source on its voxel if it lowers the voxel's distance
+ * @param InSource The source
+ */
+void FVoxelCostField::SeedSource(const uint16 InSource)
+{
+	const FSource& Source = Sources[InSource];
+
+	if(!Region.Contains(Source.Coordinate))
+	{
+		return;
+	}
+
+	const FIntVector Coordinate = Source.Coordinate - Region.Min;
+	const int32 Index = Costs.GetGrid().GetVoxelIndex(Coordinate);
+
+	if(Traversable.IsOccupied(Coordinate) && Source.InitialCost < Costs[Index])
+	{
+		Costs[Index] = Source.InitialCost;
+		Owners[Index] = InSource;
+		PendingVoxels[GetBlockIndex(Coordinate)].Add(Index);
+	}
+}
+
+/**
+ * Spreads distances from a block's pending voxels through the block with a dial queue
+ * Seeds are sorted by distance and join the queue when it reaches their distance, so the queue's buckets only ever
+ * span one step and wrap around
+ * @param InBlockCoordinate The block
+ * @param InOutSeeds The block's pending voxels, emptied
+ * @param OutHandOvers The distances found for voxels of other blocks, neither read nor written here
+ */
+void FVoxelCostField::SpreadBlock(const FIntVector& InBlockCoordinate, TArray<int32>& InOutSeeds, TArray<FHandOver>& OutHandOvers)
+{
+	const FVoxelGrid& Grid = Costs.GetGrid();
+	const FIntVector Min = InBlockCoordinate * BlockSize;
+	const FIntVector Max(
+		FMath::Min(Min.X + BlockSize, Region.GetSize().X),
+		FMath::Min(Min.Y + BlockSize, Region.GetSize().Y),
+		FMath::Min(Min.Z + BlockSize, Region.GetSize().Z));
+
+	InOutSeeds.RemoveAll([this](const int32 Index)
+	{
+		return Costs[Index] == Unreachable;
+	});
+
+	InOutSeeds.Sort([this](const int32 A, const int32 B)
+	{
+		return Costs[A] != Costs[B] ? Costs[A] < Costs[B] : A < B;
+	});
+
+	TArray<TArray<int32>> Buckets;
+	Buckets.SetNum(NumBuckets);
+
+	int32 NumQueued = 0;
+	int32 NextSeed = 0;
+	int32 Current = InOutSeeds.IsEmpty() ? 0 : Costs[InOutSeeds[0]];
+
+	while(true)
+	{
+		// Seeds lowered since they were sorted were already queued at their lower distance
+		for(; NextSeed < InOutSeeds.Num() && Costs[InOutSeeds[NextSeed]] <= Current; NextSeed++)
+		{
+			const int32 Seed = InOutSeeds[NextSeed];
+
+			if(Costs[Seed] == Current && (NextSeed == 0 || InOutSeeds[NextSeed - 1] != Seed))
+			{
+				Buckets[Current % NumBuckets].Add(Seed);
+				NumQueued++;
+			}
+		}
+
+		if(NumQueued == 0)
+		{
+			if(NextSeed == InOutSeeds.Num())
+			{
+				break;
+			}
+
+			Current = Costs[InOutSeeds[NextSeed]];
+			continue;
+		}
+
+		// Steps cost at least 1, nothing is added to the bucket being drained
+		TArray<int32>& Bucket = Buckets[Current % NumBuckets];
+
+		for(int32 Queued = 0; Queued < Bucket.Num(); Queued++)
+		{
+			const int32 Index = Bucket[Queued];
+
+			if(Costs[Index] != Current)
+			{
+				continue;
+			}
+
+			const FIntVector Coordinate = Grid.GetVoxelCoordinate(Index);
+			const uint16 Source = Owners[Index];
+
+			Neighbourhood.ForEachNeighbour(Coordinate, [&](const FIntVector& Neighbour, const int32 NeighbourIndex)
+			{
+				if(!CanStep(Coordinate, Neighbour - Coordinate))
+				{
+					return;
+				}
+
+				const int32 Cost = Current + GetStepCost(Neighbour - Coordinate, NeighbourIndex);
+
+				if(Cost >= Unreachable)
+				{
+					return;
+				}
+
+				const bool bIsInBlock = Neighbour.X >= Min.X && Neighbour.X < Max.X &&
+					Neighbour.Y >= Min.Y && Neighbour.Y < Max.Y &&
+					Neighbour.Z >= Min.Z && Neighbour.Z < Max.Z;
+
+				if(!bIsInBlock)
+				{
+					OutHandOvers.Add(FHandOver{NeighbourIndex, uint16(Cost), Source});
+				}
+				else if(Cost < Costs[NeighbourIndex])
+				{
+					Costs[NeighbourIndex] = uint16(Cost);
+					Owners[NeighbourIndex] = Source;
+					Buckets[Cost % NumBuckets].Add(NeighbourIndex);
+					NumQueued++;
+				}
+			});
+		}
+
+		NumQueued -= Bucket.Num();
+		Bucket.Reset();
+		Current++;
+	}
+
+	InOutSeeds.Reset();
+}
+
+/**
+ * Gets the block holding a voxel
+ * @param InLocalCoordinate The voxel coordinate in the region's grid
+ * @return The block's index
+ */
+int32 FVoxelCostField::GetBlockIndex(const FIntVector& InLocalCoordinate) const
+{
+	const FIntVector Block = InLocalCoordinate / BlockSize;
+
+	return Block.X + Block.Y * BlockCount.X + Block.Z * BlockCount.X * BlockCount.Y;
+}
+
+/**
+ * Gets the cost of a step into a voxel
+ * @param InOffset The step
+ * @param InIndex The voxel's index in the region's grid
+ * @return The cost, at least 1
+ */
+int32 FVoxelCostField::GetStepCost(const FIntVector& InOffset, const int32 InIndex) const
+{
+	return ScaleStepCost(InOffset, StepCosts.IsEmpty() ? DefaultStepCost : StepCosts[InIndex]);
+}
@@ -0,0 +1,621 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelEditor.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/**
+	 * Checks which side of a directed edge a point is on, projected on the YZ plane
+	 * @return Twice the signed area of the triangle the edge makes with the point
+	 */
+	double GetEdgeFunction(const FVector& U, const FVector& V, const double Y, const double Z)
+	{
+		return (V.Y - U.Y) * (Z - U.Z) - (V.Z - U.Z) * (Y - U.Y);
+	}
+
+	/**
+	 * Checks if a point is on the inner side of a triangle's edge
+	 * Points exactly on an edge belong to one side only, so a row through an edge shared by two triangles crosses it once
+	 */
+	bool IsInsideEdge(const double EdgeFunction, const FVector& U, const FVector& V)
+	{
+		const double DeltaY = V.Y - U.Y;
+		const double DeltaZ = V.Z - U.Z;
+
+		return EdgeFunction > 0.0 || (EdgeFunction == 0.0 && (DeltaZ < 0.0 || (DeltaZ == 0.0 && DeltaY > 0.0)));
+	}
+
+	/**
+	 * Gets where a row along X crosses a triangle
+	 * @param Triangle The triangle
+	 * @param Y Location of the row along Y
+	 * @param Z Location of the row along Z
+	 * @param OutX Location of the crossing along X
+	 * @return true if the row crosses the triangle, rows in the triangle's plane never do
+	 */
+	bool GetRowCrossing(const FTriangleProxy& Triangle, const double Y, const double Z, double& OutX)
+	{
+		const FVector& A = Triangle.V[0];
+		FVector B = Triangle.V[1];
+		FVector C = Triangle.V[2];
+
+		double Area = GetEdgeFunction(A, B, C.Y, C.Z);
+
+		if(FMath::Abs(Area) < UE_DOUBLE_SMALL_NUMBER)
+		{
+			return false;
+		}
+
+		// Make every triangle counter clockwise on the YZ plane, so the edge rule treats all of them alike
+		if(Area < 0.0)
+		{
+			Swap(B, C);
+			Area = -Area;
+		}
+
+		const double WeightA = GetEdgeFunction(B, C, Y, Z);
+		const double WeightB = GetEdgeFunction(C, A, Y, Z);
+		const double WeightC = GetEdgeFunction(A, B, Y, Z);
+
+		if(!IsInsideEdge(WeightA, B, C) || !IsInsideEdge(WeightB, C, A) || !IsInsideEdge(WeightC, A, B))
+		{
+			return false;
+		}
+
+		OutX = (WeightA * A.X + WeightB * B.X + WeightC * C.X) / Area;
+
+		return true;
+	}
+}
+
+/**
+ * Class constructor, copies the store's current version
+ * @param InStore The store to edit, must outlive the editor
+ */
+FVoxelEditor::FVoxelEditor(FVoxelChunkStore& InStore) : Store(InStore)
+{
+	Mirrored = Store.GetSnapshot();
+	Occupancy = Mirrored->ToOccupancy();
+}
+
+/**
+ * Gets the editor's dense copy of the occupancy, derived layers are baked from it
+ * @return The occupancy as of the last edit or Sync
+ */
+const FVoxelOccupancy& FVoxelEditor::GetOccupancy() const
+{
+	return Occupancy;
+}
+
+/**
+ * Gets the store version the editor's occupancy and derived layers match
+ * @return The version
+ */
+int64 FVoxelEditor::GetVersion() const
+{
+	return Mirrored->GetVersion();
+}
+
+/**
+ * Registers a derived layer to update after every change, it must already match the editor's occupancy
+ * @param InKernelRadius How far, in voxels along each axis, a changed voxel can affect the layer
+ * @param InUpdate Rebakes the layer inside a box, called on a worker thread alongside the other layers
+ * @return The handle to remove the layer with
+ */
+int32 FVoxelEditor::AddDerivedLayer(const FIntVector& InKernelRadius, FUpdateFunction&& InUpdate)
+{
+	FDerivedLayer& Layer = DerivedLayers.AddDefaulted_GetRef();
+	Layer.Handle = NextHandle++;
+	Layer.KernelRadius = InKernelRadius;
+	Layer.Update = MoveTemp(InUpdate);
+
+	return Layer.Handle;
+}
+
+/**
+ * Builds a summed volume table of the editor's occupancy and keeps it up to date
+ * @param InOutVolume The table, must outlive the registration
+ * @return The handle to remove the layer with
+ */
+int32 FVoxelEditor::AddSummedVolume(FVoxelSummedVolume& InOutVolume)
+{
+	InOutVolume.Build(Occupancy);
+
+	return AddDerivedLayer(FIntVector::ZeroValue, [&InOutVolume](const FVoxelOccupancy& InOccupancy, const FVoxelBox& InVoxelBox)
+	{
+		InOutVolume.UpdateVoxels(InOccupancy, InVoxelBox);
+	});
+}
+
+/**
+ * Bakes an agent profile's walkable layer from the editor's occupancy and keeps it up to date
+ * @param InProfile The agent profile
+ * @param InOutWalkable The walkable layer, must outlive the registration
+ * @return The handle to remove the layer with
+ */
+int32 FVoxelEditor::AddWalkableLayer(const FVoxelAgentProfile& InProfile, FVoxelOccupancy& InOutWalkable)
+{
+	InOutWalkable = FVoxelAgentBaker::BakeProfile(Occupancy, InProfile);
+
+	return AddDerivedLayer(FVoxelAgentBaker::GetKernelRadius(Occupancy.GetGrid(), InProfile),
+		[InProfile, &InOutWalkable](const FVoxelOccupancy& InOccupancy, const FVoxelBox& InVoxelBox)
+	{
+		FVoxelAgentBaker::UpdateProfile(InOccupancy, InProfile, InVoxelBox, InOutWalkable);
+	});
+}
+
+/**
+ * Bakes the exposure of the editor's occupancy and keeps it up to date
+ * @param InBaker The exposure settings
+ * @param InOutExposure The exposure, must outlive the registration
+ * @return The handle to remove the layer with
+ */
+int32 FVoxelEditor::AddExposureLayer(const FVoxelExposureBaker& InBaker, TVoxelAttribute<uint8>& InOutExposure)
+{
+	InOutExposure = InBaker.Bake(Occupancy);
+
+	return AddDerivedLayer(FIntVector(InBaker.GetKernelRadius()),
+		[InBaker, &InOutExposure](const FVoxelOccupancy& InOccupancy, const FVoxelBox& InVoxelBox)
+	{
+		InBaker.Update(InOccupancy, InVoxelBox, InOutExposure);
+	});
+}
+
+/**
+ * Stops updating a derived layer
+ * @param InHandle The handle the layer was registered with
+ * @return true if the layer was registered
+ */
+bool FVoxelEditor::RemoveDerivedLayer(const int32 InHandle)
+{
+	return DerivedLayers.RemoveAll([InHandle](const FDerivedLayer& Layer)
+	{
+		return Layer.Handle == InHandle;
+	}) > 0;
+}
+
+/**
+ * Adds or subtracts a sphere
+ * @param InSphere The sphere in world space
+ * @param InOperation Whether to add or subtract
+ * @return What the edit changed
+ */
+FVoxelEditResult FVoxelEditor::ApplySphere(const FSphereProxy& InSphere, const EVoxelEditOperation InOperation)
+{
+	const FBox Bounds(InSphere.Center - FVector(InSphere.Radius), InSphere.Center + FVector(InSphere.Radius));
+
+	return ApplyPoints(Bounds, InOperation, [&InSphere](const FVector& Point)
+	{
+		return FVector::DistSquared(Point, InSphere.Center) <= FMath::Square(InSphere.Radius);
+	});
+}
+
+/**
+ * Adds or subtracts a capsule
+ * @param InCapsule The capsule in world space
+ * @param InOperation Whether to add or subtract
+ * @return What the edit changed
+ */
+FVoxelEditResult FVoxelEditor::ApplyCapsule(const FCapsuleProxy& InCapsule, const EVoxelEditOperation InOperation)
+{
+	FBox Bounds(ForceInit);
+	Bounds += InCapsule.Start;
+	Bounds += InCapsule.End;
+
+	return ApplyPoints(Bounds.ExpandBy(InCapsule.Radius), InOperation, [&InCapsule](const FVector& Point)
+	{
+		return FMath::PointDistToSegmentSquared(Point, InCapsule.Start, InCapsule.End) <= FMath::Square(InCapsule.Radius);
+	});
+}
+
+/**
+ * Adds or subtracts an oriented box
+ * @param InBox The box in world space
+ * @param InOperation Whether to add or subtract
+ * @return What the edit changed
+ */
+FVoxelEditResult FVoxelEditor::ApplyBox(const FOOBBoxProxy& InBox, const EVoxelEditOperation InOperation)
+{
+	TArray<FVector> Corners;
+	InBox.GetCorners(Corners);
+
+	return ApplyPoints(FBox(Corners), InOperation, [&InBox](const FVector& Point)
+	{
+		return InBox.IsInsideOrOn(Point);
+	});
+}
+
+/**
+ * Adds or subtracts the inside of a closed triangle mesh
+ * Each row of voxels along X is crossed with the triangles, a voxel is inside when an odd number of crossings lie before its center
+ * A mesh with holes still works, a row crossing it an odd number of times ignores its last crossing
+ * @param InTriangles The mesh's triangles in world space, winding doesn't matter
+ * @param InOperation Whether to add or subtract
+ * @return What the edit changed
+ */
+FVoxelEditResult FVoxelEditor::ApplyMesh(const TArray<FTriangleProxy>& InTriangles, const EVoxelEditOperation InOperation)
+{
+	constexpr int32 ChunkSize = FVoxelOccupancy::ChunkSize;
+
+	const FVoxelGrid& Grid = Occupancy.GetGrid();
+
+	FBox Bounds(ForceInit);
+	TArray<FBox> TriangleBounds;
+	TriangleBounds.Reserve(InTriangles.Num());
+
+	for(const FTriangleProxy& Triangle : InTriangles)
+	{
+		TriangleBounds.Add(FBox(Triangle.V, 3));
+		Bounds += TriangleBounds.Last();
+	}
+
+	// Bin the triangles by the chunk rows they cross, rows only test the triangles of their own bin
+	const FVoxelBox ChunkRange = Occupancy.GetChunkBox(Grid.GetVoxelBox(Bounds));
+	const FIntVector NumChunks = ChunkRange.GetSize();
+
+	const FVector VoxelSize = Grid.GetVoxelSize();
+	const FIntVector LatticeOrigin = Grid.GetLatticeOrigin();
+
+	TArray<TArray<int32>> Bins;
+	Bins.SetNum(NumChunks.Y * NumChunks.Z);
+
+	for(int32 Triangle = 0; Triangle < InTriangles.Num(); Triangle++)
+	{
+		// Only Y and Z pick the rows, a triangle past the grid along X still crosses the rows inside it
+		const FBox& Box = TriangleBounds[Triangle];
+		const FIntVector RowMin = Grid.GetLatticeCoordinate(Box.Min) - LatticeOrigin;
+		const FIntVector RowMax = FIntVector(0, FMath::CeilToInt(Box.Max.Y / VoxelSize.Y), FMath::CeilToInt(Box.Max.Z / VoxelSize.Z)) - LatticeOrigin;
+		const FVoxelBox RowBox(FIntVector(0, RowMin.Y, RowMin.Z), FIntVector(Grid.GetVectorVoxelCount().X, RowMax.Y, RowMax.Z));
+		const FVoxelBox TriangleChunks = Occupancy.GetChunkBox(RowBox).Intersect(ChunkRange);
+
+		for(int32 ChunkZ = TriangleChunks.Min.Z; ChunkZ < TriangleChunks.Max.Z; ChunkZ++)
+		{
+			for(int32 ChunkY = TriangleChunks.Min.Y; ChunkY < TriangleChunks.Max.Y; ChunkY++)
+			{
+				Bins[(ChunkY - ChunkRange.Min.Y) + (ChunkZ - ChunkRange.Min.Z) * NumChunks.Y].Add(Triangle);
+			}
+		}
+	}
+
+	return Apply(Bounds, InOperation, [this, &Grid, &InTriangles, &Bins, &ChunkRange, &NumChunks](const FIntVector& InChunkMin,
+		const int32 Y, const int32 Z, const int32 MinX, const int32 MaxX)
+	{
+		const TArray<int32>& Bin = Bins[(InChunkMin.Y / ChunkSize - ChunkRange.Min.Y) + (InChunkMin.Z / ChunkSize - ChunkRange.Min.Z) * NumChunks.Y];
+		const FVector RowStart = GetVoxelCenter(FIntVector(MinX, Y, Z));
+
+		TArray<double, TInlineAllocator<16>> Crossings;
+
+		for(const int32 Triangle : Bin)
+		{
+			double X;
+
+			if(GetRowCrossing(InTriangles[Triangle], RowStart.Y, RowStart.Z, X))
+			{
+				Crossings.Add(X);
+			}
+		}
+
+		Crossings.Sort();
+
+		if(Crossings.Num() % 2 == 1)
+		{
+			Crossings.Pop();
+		}
+
+		if(Crossings.Num() == 0)
+		{
+			return uint64(0);
+		}
+
+		uint64 Bits = 0;
+		int32 Next = 0;
+
+		for(int32 X = MinX; X < MaxX; X++)
+		{
+			const double CenterX = RowStart.X + (X - MinX) * Grid.GetVoxelSize().X;
+
+			while(Next < Crossings.Num() && Crossings[Next] <= CenterX)
+			{
+				Next++;
+			}
+
+			if(Next % 2 == 1)
+			{
+				Bits |= uint64(1) << (X - InChunkMin.X);
+			}
+		}
+
+		return Bits;
+	});
+}
+
+/**
+ * Makes the store's previous version current and brings the occupancy and derived layers up to date
+ * @return true if there was a version to go back to
+ */
+bool FVoxelEditor::Undo()
+{
+	if(!Store.Undo())
+	{
+		return false;
+	}
+
+	Sync();
+
+	return true;
+}
+
+/**
+ * Makes the store's last undone version current and brings the occupancy and derived layers up to date
+ * @return true if there was a version to go forward to
+ */
+bool FVoxelEditor::Redo()
+{
+	if(!Store.Redo())
+	{
+		return false;
+	}
+
+	Sync();
+
+	return true;
+}
+
+/**
+ * Brings the occupancy and derived layers up to the store's current version, only chunks that differ are copied
+ * @return The voxels of the chunks that changed
+ */
+FVoxelBox FVoxelEditor::Sync()
+{
+	return SyncTo(Store.GetSnapshot(), nullptr);
+}
+
+/**
+ * Edits the voxels of a shape, retrying on top of the new current version when another writer commits first
+ * @param InBounds The shape's bounds in world space
+ * @param InOperation Whether to add or subtract
+ * @param GetShapeRow Gets the voxels of a row inside the shape
+ * @return What the edit changed
+ */
+FVoxelEditResult FVoxelEditor::Apply(const FBox& InBounds, const EVoxelEditOperation InOperation, FRowFunction GetShapeRow)
+{
+	const FVoxelBox VoxelBox = Occupancy.GetGrid().GetVoxelBox(InBounds);
+
+	if(VoxelBox.IsEmpty())
+	{
+		return FVoxelEditResult();
+	}
+
+	for(int32 Attempt = 0; Attempt < MaxCommitAttempts; Attempt++)
+	{
+		const FVoxelChunkStore::FEditPtr Edit = Store.BeginEdit();
+
+		// Mirror the edit's own base, another writer may commit between a sync and the edit beginning,
+		// then the only chunks differing from the mirror once the edit commits are the ones it changed itself
+		SyncTo(Edit->GetBaseVersion(), nullptr);
+
+		FVoxelEditResult Result;
+		EditChunks(*Edit, VoxelBox, InOperation, GetShapeRow, Result);
+
+		if(Result.ChangedChunks.Num() == 0)
+		{
+			return Result;
+		}
+
+		if(Store.Commit(Edit))
+		{
+			Result.bCommitted = true;
+			Result.Version = Edit->GetVersion();
+
+			SyncTo(Edit, &Result);
+
+			return Result;
+		}
+	}
+
+	return FVoxelEditResult();
+}
+
+/**
+ * Edits the voxels whose center is inside a shape
+ * @param InBounds The shape's bounds in world space
+ * @param InOperation Whether to add or subtract
+ * @param IsInside Checks if a point in world space is inside the shape
+ * @return What the edit changed
+ */
+FVoxelEditResult FVoxelEditor::ApplyPoints(const FBox& InBounds, const EVoxelEditOperation InOperation, TFunctionRef<bool(const FVector&)> IsInside)
+{
+	return Apply(InBounds, InOperation, [this, &IsInside](const FIntVector& InChunkMin, const int32 Y, const int32 Z, const int32 MinX, const int32 MaxX)
+	{
+		uint64 Bits = 0;
+
+		for(int32 X = MinX; X < MaxX; X++)
+		{
+			if(IsInside(GetVoxelCenter(FIntVector(X, Y, Z))))
+			{
+				Bits |= uint64(1) << (X - InChunkMin.X);
+			}
+		}
+
+		return Bits;
+	});
+}
+
+/**
+ * Combines a shape with the chunks it overlaps, chunks are processed in parallel
+ * A chunk is only cloned once one of its words actually changes, a subtraction that empties a chunk frees it
+ * @param InOutEdit The edit to write to
+ * @param InVoxelBox The shape's voxels, must be inside the grid
+ * @param InOperation Whether to add or subtract
+ * @param GetShapeRow Gets the voxels of a row inside the shape
+ * @param OutResult Receives the changed chunks and voxels
+ */
+void FVoxelEditor::EditChunks(FVoxelChunkMap& InOutEdit, const FVoxelBox& InVoxelBox, const EVoxelEditOperation InOperation,
+	FRowFunction GetShapeRow, FVoxelEditResult& OutResult) const
+{
+	constexpr int32 ChunkSize = FVoxelChunk::ChunkSize;
+
+	const FVoxelBox ChunkRange = Occupancy.GetChunkBox(InVoxelBox);
+	const FIntVector NumChunks = ChunkRange.GetSize();
+
+	TArray<FVoxelBox> ChangedBoxes;
+	ChangedBoxes.SetNum(ChunkRange.Num());
+
+	ParallelFor(ChunkRange.Num(), [&](const int32 Task)
+	{
+		const FIntVector ChunkCoordinate = ChunkRange.Min + FIntVector(Task % NumChunks.X, (Task / NumChunks.X) % NumChunks.Y, Task / (NumChunks.X * NumChunks.Y));
+		const FIntVector ChunkMin = ChunkCoordinate * ChunkSize;
+		const FVoxelBox Box = InOutEdit.GetChunkBox(ChunkCoordinate).Intersect(InVoxelBox);
+
+		const FVoxelChunk* Chunk = InOutEdit.GetChunk(ChunkCoordinate);
+		FVoxelChunk* MutableChunk = nullptr;
+
+		// Nothing to subtract from an empty chunk
+		if(!Chunk && InOperation == EVoxelEditOperation::Subtract)
+		{
+			return;
+		}
+
+		FVoxelBox& Changed = ChangedBoxes[Task];
+
+		for(int32 Z = Box.Min.Z; Z < Box.Max.Z; Z++)
+		{
+			for(int32 Y = Box.Min.Y; Y < Box.Max.Y; Y++)
+			{
+				const int32 Word = (Y - ChunkMin.Y) + (Z - ChunkMin.Z) * ChunkSize;
+				const uint64 Shape = GetShapeRow(ChunkMin, Y, Z, Box.Min.X, Box.Max.X);
+				const uint64 Old = Chunk ? Chunk->Words[Word] : 0;
+				const uint64 New = InOperation == EVoxelEditOperation::Add ? Old | Shape : Old & ~Shape;
+
+				if(New == Old)
+				{
+					continue;
+				}
+
+				if(!MutableChunk)
+				{
+					MutableChunk = &InOutEdit.GetMutableChunk(ChunkCoordinate);
+					Chunk = MutableChunk;
+				}
+
+				MutableChunk->Words[Word] = New;
+
+				const uint64 Difference = New ^ Old;
+				const int32 FirstX = ChunkMin.X + static_cast<int32>(FMath::CountTrailingZeros64(Difference));
+				const int32 LastX = ChunkMin.X + 63 - static_cast<int32>(FMath::CountLeadingZeros64(Difference));
+
+				Changed = Changed.Union(FVoxelBox(FIntVector(FirstX, Y, Z), FIntVector(LastX + 1, Y + 1, Z + 1)));
+			}
+		}
+
+		if(MutableChunk && InOperation == EVoxelEditOperation::Subtract && MutableChunk->IsEmpty())
+		{
+			InOutEdit.ClearChunk(ChunkCoordinate);
+		}
+	});
+
+	for(int32 Task = 0; Task < ChangedBoxes.Num(); Task++)
+	{
+		if(!ChangedBoxes[Task].IsEmpty())
+		{
+			OutResult.ChangedBox = OutResult.ChangedBox.Union(ChangedBoxes[Task]);
+			OutResult.ChangedChunks.Add(ChunkRange.Min + FIntVector(Task % NumChunks.X, (Task / NumChunks.X) % NumChunks.Y, Task / (NumChunks.X * NumChunks.Y)));
+		}
+	}
+}
+
+/**
+ * Copies the chunks of a version that differ from the mirrored version and updates the derived layers over them
+ * @param InVersion The version to mirror, a version of the editor's store
+ * @param InEdit The edit that was committed as the version, its changed voxels replace its chunks' boxes, null if unknown
+ * @return The changed voxels
+ */
+FVoxelBox FVoxelEditor::SyncTo(const FVoxelChunkStore::FMapPtr& InVersion, const FVoxelEditResult* InEdit)
+{
+	if(InVersion == Mirrored)
+	{
+		return FVoxelBox();
+	}
+
+	const TArray<FIntVector> ChangedChunks = InVersion->GetChangedChunks(*Mirrored);
+
+	ParallelFor(ChangedChunks.Num(), [this, &InVersion, &ChangedChunks](const int32 Index)
+	{
+		InVersion->CopyChunkTo(ChangedChunks[Index], Occupancy);
+	});
+
+	// Chunks the edit didn't touch were changed by another writer committing between the last sync and the edit
+	FVoxelBox ChangedBox = InEdit ? InEdit->ChangedBox : FVoxelBox();
+
+	for(const FIntVector& ChunkCoordinate : ChangedChunks)
+	{
+		if(!InEdit || !InEdit->ChangedChunks.Contains(ChunkCoordinate))
+		{
+			ChangedBox = ChangedBox.Union(InVersion->GetChunkBox(ChunkCoordinate));
+		}
+	}
+
+	Mirrored = InVersion;
+
+	UpdateDerivedLayers(ChangedBox);
+
+	return ChangedBox;
+}
+
+/**
+ * Updates every derived layer over the changed voxels grown by its kernel radius, layers are updated in parallel
+ * @param InChangedBox The changed voxels
+ */
+void FVoxelEditor::UpdateDerivedLayers(const FVoxelBox& InChangedBox)
+{
+	if(InChangedBox.IsEmpty())
+	{
+		return;
+	}
+
+	const FVoxelBox GridBox = Occupancy.GetGrid().GetVoxelBox();
+
+	ParallelFor(DerivedLayers.Num(), [this, &InChangedBox, &GridBox](const int32 Index)
+	{
+		const FDerivedLayer& Layer = DerivedLayers[Index];
+
+		Layer.Update(Occupancy, InChangedBox.Expand(Layer.KernelRadius).Intersect(GridBox));
+	});
+}
+
+/**
+ * Gets the center of a voxel in world space, the coordinate doesn't need to be inside the grid
+ * @param InCoordinate The voxel coordinate
+ * @return The center
+ */
+FVector FVoxelEditor::GetVoxelCenter(const FIntVector& InCoordinate) const
+{
+	const FVoxelGrid& Grid = Occupancy.GetGrid();
+
+	return Grid.GetBounds().Min + (FVector(InCoordinate) + FVector(0.5)) * Grid.GetVoxelSize();
+}
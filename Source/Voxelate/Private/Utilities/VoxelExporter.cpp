@@ -0,0 +1,426 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelExporter.h"
+
+#include "Async/ParallelFor.h"
+#include "Data/VoxelCustomVersion.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/MemoryWriter.h"
+
+static_assert(FVoxelExporter::VoxModelSize % 64 == 0, "Vox models must cover whole words");
+
+namespace
+{
+	/**
+	 * Writes the header of a MagicaVoxel chunk
+	 * @param Ar The archive to write to
+	 * @param InId The four character chunk id
+	 * @param InContentSize The size of the chunk's content in bytes
+	 * @param InChildrenSize The size of the chunk's children in bytes
+	 */
+	void WriteVoxChunkHeader(FArchive& Ar, const ANSICHAR* InId, int32 InContentSize, int32 InChildrenSize)
+	{
+		Ar.Serialize(const_cast<ANSICHAR*>(InId), 4);
+		Ar << InContentSize;
+		Ar << InChildrenSize;
+	}
+
+	/**
+	 * Writes a MagicaVoxel chunk without children
+	 * @param Ar The archive to write to
+	 * @param InId The four character chunk id
+	 * @param InContent The chunk's content
+	 */
+	void WriteVoxChunk(FArchive& Ar, const ANSICHAR* InId, TArray<uint8>& InContent)
+	{
+		WriteVoxChunkHeader(Ar, InId, InContent.Num(), 0);
+		Ar.Serialize(InContent.GetData(), InContent.Num());
+	}
+
+	/**
+	 * Writes a MagicaVoxel dictionary of string pairs
+	 * @param Ar The archive to write to
+	 * @param InPairs The keys and values
+	 */
+	void WriteVoxDict(FArchive& Ar, const TArray<TPair<FString, FString>>& InPairs)
+	{
+		int32 NumPairs = InPairs.Num();
+		Ar << NumPairs;
+
+		for(const TPair<FString, FString>& Pair : InPairs)
+		{
+			for(const FString& String : {Pair.Key, Pair.Value})
+			{
+				FTCHARToUTF8 Utf8(*String);
+				int32 Length = Utf8.Length();
+				Ar << Length;
+				Ar.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Length);
+			}
+		}
+	}
+}
+
+/**
+ * Exports the occupancy as a dense bit packed file with a JSON header
+ * The file starts with the header's size as a little endian uint64 followed by the header as UTF-8 JSON,
+ * the voxel data follows straight after and is the occupancy's rows as they are stored, see GetRawHeader for the layout
+ * @param InOccupancy The occupancy to export
+ * @param InFilename The file to write, usually .bin
+ * @return false if the file couldn't be written
+ */
+bool FVoxelExporter::ExportRaw(const FVoxelOccupancy& InOccupancy, const FString& InFilename)
+{
+	const TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*InFilename));
+
+	if(!Writer)
+	{
+		return false;
+	}
+
+	const FTCHARToUTF8 Header(*GetRawHeader(InOccupancy));
+	uint64 HeaderSize = Header.Length();
+
+	*Writer << HeaderSize;
+	Writer->Serialize(const_cast<ANSICHAR*>(Header.Get()), Header.Length());
+
+	// Rows are already in file order, so each Z slice goes straight from the words to the file
+	const FIntVector Count = InOccupancy.GetGrid().GetVectorVoxelCount();
+	const int64 WordsPerSlice = int64(InOccupancy.GetWordsPerRow()) * Count.Y;
+	const uint64* Words = InOccupancy.GetWords().GetData();
+
+	for(int32 Z = 0; Z < Count.Z && !Writer->IsError(); Z++)
+	{
+		Writer->Serialize(const_cast<uint64*>(Words + Z * WordsPerSlice), WordsPerSlice * sizeof(uint64));
+	}
+
+	return Writer->Close();
+}
+
+/**
+ * Exports the occupancy as a MagicaVoxel file
+ * The grid is split into models of at most VoxModelSize voxels a side placed with a scene graph, empty models are left out
+ * Voxels take their palette index from the colour indices, or 255 without them, and the palette is a grey ramp
+ * The format stores sizes as 32 bit integers, so grids with more than around 500 million occupied voxels can't be exported
+ * @param InOccupancy The occupancy to export
+ * @param InFilename The file to write, usually .vox
+ * @param InColorIndices Optional palette index per voxel, for example an exposure bake, 0 is written as 1 as the format reserves 0 for empty voxels
+ * @return false if the file couldn't be written or is too large for the format
+ */
+bool FVoxelExporter::ExportVox(const FVoxelOccupancy& InOccupancy, const FString& InFilename, const TVoxelAttribute<uint8>* InColorIndices)
+{
+	checkf(!InColorIndices || InColorIndices->GetGrid() == InOccupancy.GetGrid(), TEXT("Colour indices must cover the occupancy's grid"));
+
+	const FIntVector Count = InOccupancy.GetGrid().GetVectorVoxelCount();
+	const FIntVector ModelCount(
+		FMath::DivideAndRoundUp(Count.X, VoxModelSize),
+		FMath::DivideAndRoundUp(Count.Y, VoxModelSize),
+		FMath::DivideAndRoundUp(Count.Z, VoxModelSize));
+
+	TArray<FVoxelBox> AllModelBoxes;
+
+	FVoxelBox(FIntVector::ZeroValue, ModelCount).ForEach([&InOccupancy, &AllModelBoxes](const FIntVector& ModelCoordinate)
+	{
+		const FIntVector Min = ModelCoordinate * VoxModelSize;
+		AllModelBoxes.Add(FVoxelBox(Min, Min + FIntVector(VoxModelSize)).Intersect(InOccupancy.GetGrid().GetVoxelBox()));
+	});
+
+	TArray<int32> AllModelCounts;
+	AllModelCounts.SetNumZeroed(AllModelBoxes.Num());
+
+	ParallelFor(AllModelBoxes.Num(), [&InOccupancy, &AllModelBoxes, &AllModelCounts](const int32 ModelIndex)
+	{
+		AllModelCounts[ModelIndex] = CountVoxModel(InOccupancy, AllModelBoxes[ModelIndex]);
+	});
+
+	TArray<FVoxelBox> ModelBoxes;
+	TArray<int32> ModelCounts;
+
+	// SIZE and XYZI chunk per model, then the RGBA chunk
+	int64 ChildrenSize = 12 + 256 * 4;
+
+	for(int32 ModelIndex = 0; ModelIndex < AllModelBoxes.Num(); ModelIndex++)
+	{
+		if(AllModelCounts[ModelIndex] > 0)
+		{
+			ModelBoxes.Add(AllModelBoxes[ModelIndex]);
+			ModelCounts.Add(AllModelCounts[ModelIndex]);
+			ChildrenSize += (12 + 12) + (12 + 4 + 4 * int64(AllModelCounts[ModelIndex]));
+		}
+	}
+
+	TArray<uint8> SceneGraph;
+	FMemoryWriter SceneGraphWriter(SceneGraph);
+	WriteVoxSceneGraph(SceneGraphWriter, ModelBoxes);
+	ChildrenSize += SceneGraph.Num();
+
+	if(ChildrenSize > MAX_int32)
+	{
+		return false;
+	}
+
+	const TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*InFilename));
+
+	if(!Writer)
+	{
+		return false;
+	}
+
+	int32 FileVersion = 150;
+	Writer->Serialize(const_cast<ANSICHAR*>("VOX "), 4);
+	*Writer << FileVersion;
+	WriteVoxChunkHeader(*Writer, "MAIN", 0, static_cast<int32>(ChildrenSize));
+
+	for(int32 ModelIndex = 0; ModelIndex < ModelBoxes.Num() && !Writer->IsError(); ModelIndex++)
+	{
+		WriteVoxModel(*Writer, InOccupancy, ModelBoxes[ModelIndex], ModelCounts[ModelIndex], InColorIndices);
+	}
+
+	Writer->Serialize(SceneGraph.GetData(), SceneGraph.Num());
+
+	// Palette entry N is palette index N + 1
+	TArray<uint8> Palette;
+	Palette.SetNumUninitialized(256 * 4);
+
+	for(int32 Entry = 0; Entry < 256; Entry++)
+	{
+		const uint8 Grey = static_cast<uint8>(FMath::Min(Entry + 1, 255));
+		Palette[Entry * 4 + 0] = Grey;
+		Palette[Entry * 4 + 1] = Grey;
+		Palette[Entry * 4 + 2] = Grey;
+		Palette[Entry * 4 + 3] = 255;
+	}
+
+	WriteVoxChunk(*Writer, "RGBA", Palette);
+
+	return Writer->Close();
+}
+
+/**
+ * Builds the JSON header of a raw export
+ * @param InOccupancy The occupancy being exported
+ * @return The header
+ */
+FString FVoxelExporter::GetRawHeader(const FVoxelOccupancy& InOccupancy)
+{
+	const FVoxelGrid& Grid = InOccupancy.GetGrid();
+
+	auto MakeArray = [](const auto& InVector)
+	{
+		TArray<TSharedPtr<FJsonValue>> Values;
+
+		for(int32 Axis = 0; Axis < 3; Axis++)
+		{
+			Values.Add(MakeShared<FJsonValueNumber>(InVector[Axis]));
+		}
+
+		return Values;
+	};
+
+	const TSharedRef<FJsonObject> Header = MakeShared<FJsonObject>();
+	Header->SetStringField(TEXT("format"), TEXT("voxelate_raw"));
+	Header->SetNumberField(TEXT("version"), FVoxelCustomVersion::LatestVersion);
+	Header->SetArrayField(TEXT("voxel_count"), MakeArray(Grid.GetVectorVoxelCount()));
+	Header->SetArrayField(TEXT("voxel_size"), MakeArray(Grid.GetVoxelSize()));
+	Header->SetArrayField(TEXT("lattice_origin"), MakeArray(Grid.GetLatticeOrigin()));
+	Header->SetArrayField(TEXT("bounds_min"), MakeArray(Grid.GetBounds().Min));
+	// One bit per voxel, X rows padded to whole little endian 64 bit words, bit 0 is the lowest X
+	Header->SetNumberField(TEXT("bits_per_voxel"), 1);
+	Header->SetNumberField(TEXT("row_stride_bytes"), InOccupancy.GetWordsPerRow() * sizeof(uint64));
+	Header->SetStringField(TEXT("row_order"), TEXT("y_then_z"));
+
+	FString Result;
+	const TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Result);
+	FJsonSerializer::Serialize(Header, Writer);
+
+	return Result;
+}
+
+/**
+ * Counts the occupied voxels of a vox model, models cover whole words so no masking is needed
+ * @param InOccupancy The occupancy being exported
+ * @param InModelBox The voxels covered by the model
+ * @return The number of occupied voxels
+ */
+int32 FVoxelExporter::CountVoxModel(const FVoxelOccupancy& InOccupancy, const FVoxelBox& InModelBox)
+{
+	const TArray<uint64>& Words = InOccupancy.GetWords();
+	const int32 FirstWord = InModelBox.Min.X / 64;
+	const int32 LastWord = FMath::DivideAndRoundUp(InModelBox.Max.X, 64);
+
+	int32 Count = 0;
+
+	for(int32 Z = InModelBox.Min.Z; Z < InModelBox.Max.Z; Z++)
+	{
+		for(int32 Y = InModelBox.Min.Y; Y < InModelBox.Max.Y; Y++)
+		{
+			const int32 RowWordIndex = InOccupancy.GetRowWordIndex(Y, Z);
+
+			for(int32 Word = FirstWord; Word < LastWord; Word++)
+			{
+				Count += FMath::CountBits(Words[RowWordIndex + Word]);
+			}
+		}
+	}
+
+	return Count;
+}
+
+/**
+ * Writes the SIZE and XYZI chunks of a vox model, one row at a time
+ * @param Ar The archive to write to
+ * @param InOccupancy The occupancy being exported
+ * @param InModelBox The voxels covered by the model
+ * @param InNumVoxels The number of occupied voxels in the model
+ * @param InColorIndices Optional palette index per voxel
+ */
+void FVoxelExporter::WriteVoxModel(FArchive& Ar, const FVoxelOccupancy& InOccupancy, const FVoxelBox& InModelBox, const int32 InNumVoxels,
+	const TVoxelAttribute<uint8>* InColorIndices)
+{
+	FIntVector Size = InModelBox.GetSize();
+	int32 NumVoxels = InNumVoxels;
+
+	WriteVoxChunkHeader(Ar, "SIZE", 12, 0);
+	Ar << Size.X;
+	Ar << Size.Y;
+	Ar << Size.Z;
+
+	WriteVoxChunkHeader(Ar, "XYZI", 4 + 4 * NumVoxels, 0);
+	Ar << NumVoxels;
+
+	const TArray<uint64>& Words = InOccupancy.GetWords();
+	const int32 FirstWord = InModelBox.Min.X / 64;
+	const int32 LastWord = FMath::DivideAndRoundUp(InModelBox.Max.X, 64);
+
+	TArray<uint8> Row;
+	Row.Reserve(VoxModelSize * 4);
+
+	for(int32 Z = InModelBox.Min.Z; Z < InModelBox.Max.Z; Z++)
+	{
+		for(int32 Y = InModelBox.Min.Y; Y < InModelBox.Max.Y; Y++)
+		{
+			const int32 RowWordIndex = InOccupancy.GetRowWordIndex(Y, Z);
+
+			Row.Reset();
+
+			for(int32 WordIndex = FirstWord; WordIndex < LastWord; WordIndex++)
+			{
+				for(uint64 Word = Words[RowWordIndex + WordIndex]; Word != 0; Word &= Word - 1)
+				{
+					const int32 X = WordIndex * 64 + FMath::CountTrailingZeros64(Word);
+
+					Row.Add(static_cast<uint8>(X - InModelBox.Min.X));
+					Row.Add(static_cast<uint8>(Y - InModelBox.Min.Y));
+					Row.Add(static_cast<uint8>(Z - InModelBox.Min.Z));
+					Row.Add(InColorIndices ? FMath::Max<uint8>((*InColorIndices)[FIntVector(X, Y, Z)], 1) : 255);
+				}
+			}
+
+			Ar.Serialize(Row.GetData(), Row.Num());
+		}
+	}
+}
+
+/**
+ * Writes the scene graph placing the vox models
+ * A root transform holds a group, which holds a transform and shape pair for each model
+ * @param Ar The archive to write to
+ * @param InModelBoxes The voxels covered by each model, in model order
+ */
+void FVoxelExporter::WriteVoxSceneGraph(FArchive& Ar, const TArray<FVoxelBox>& InModelBoxes)
+{
+	const TArray<TPair<FString, FString>> EmptyDict;
+
+	TArray<uint8> Content;
+
+	auto WriteTransform = [&Ar, &Content, &EmptyDict](int32 NodeId, int32 ChildId, int32 LayerId, const TArray<TPair<FString, FString>>& InFrame)
+	{
+		Content.Reset();
+		FMemoryWriter Writer(Content);
+
+		int32 ReservedId = INDEX_NONE;
+		int32 NumFrames = 1;
+
+		Writer << NodeId;
+		WriteVoxDict(Writer, EmptyDict);
+		Writer << ChildId;
+		Writer << ReservedId;
+		Writer << LayerId;
+		Writer << NumFrames;
+		WriteVoxDict(Writer, InFrame);
+
+		WriteVoxChunk(Ar, "nTRN", Content);
+	};
+
+	WriteTransform(0, 1, INDEX_NONE, EmptyDict);
+
+	{
+		Content.Reset();
+		FMemoryWriter Writer(Content);
+
+		int32 NodeId = 1;
+		int32 NumChildren = InModelBoxes.Num();
+
+		Writer << NodeId;
+		WriteVoxDict(Writer, EmptyDict);
+		Writer << NumChildren;
+
+		for(int32 ModelIndex = 0; ModelIndex < InModelBoxes.Num(); ModelIndex++)
+		{
+			int32 ChildId = 2 + ModelIndex * 2;
+			Writer << ChildId;
+		}
+
+		WriteVoxChunk(Ar, "nGRP", Content);
+	}
+
+	for(int32 ModelIndex = 0; ModelIndex < InModelBoxes.Num(); ModelIndex++)
+	{
+		// Models are placed by their centre, rounded down
+		const FIntVector Center = InModelBoxes[ModelIndex].Min + InModelBoxes[ModelIndex].GetSize() / 2;
+
+		WriteTransform(2 + ModelIndex * 2, 3 + ModelIndex * 2, 0,
+			{TPair<FString, FString>(TEXT("_t"), FString::Printf(TEXT("%d %d %d"), Center.X, Center.Y, Center.Z))});
+
+		Content.Reset();
+		FMemoryWriter Writer(Content);
+
+		int32 NodeId = 3 + ModelIndex * 2;
+		int32 NumModels = 1;
+		int32 ModelId = ModelIndex;
+
+		Writer << NodeId;
+		WriteVoxDict(Writer, EmptyDict);
+		Writer << NumModels;
+		Writer << ModelId;
+		WriteVoxDict(Writer, EmptyDict);
+
+		WriteVoxChunk(Ar, "nSHP", Content);
+	}
+}
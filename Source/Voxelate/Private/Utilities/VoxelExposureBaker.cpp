@@ -0,0 +1,178 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelExposureBaker.h"
+
+#include "Async/ParallelFor.h"
+#include "Data/VoxelNeighbourhood.h"
+
+FVoxelExposureBaker::FVoxelExposureBaker(const int32 InNumDirections, const double InRayLength)
+	: NumDirections(InNumDirections), RayLength(InRayLength)
+{
+}
+
+/**
+ * Bakes the exposure of every surface voxel, chunks are processed in parallel
+ * @param InOccupancy The occupancy to cast rays through
+ * @return The exposure of each voxel, 0 (enclosed) to 255 (fully open), voxels that aren't surface voxels are 0
+ */
+TVoxelAttribute<uint8> FVoxelExposureBaker::Bake(const FVoxelOccupancy& InOccupancy) const
+{
+	TVoxelAttribute<uint8> Result(InOccupancy.GetGrid(), 0);
+
+	Update(InOccupancy, InOccupancy.GetGrid().GetVoxelBox(), Result);
+
+	return Result;
+}
+
+/**
+ * Rebakes the exposure of a box of voxels after the occupancy changed, the chunks it touches are processed in parallel
+ * A voxel's exposure depends on the occupancy up to GetKernelRadius voxels away,
+ * so the box must cover the changed voxels grown by that radius
+ * @param InOccupancy The occupancy to cast rays through
+ * @param InVoxelBox The voxels to rebake, clamped to the grid
+ * @param InOutExposure The exposure to update, must share the occupancy's grid
+ */
+void FVoxelExposureBaker::Update(const FVoxelOccupancy& InOccupancy, const FVoxelBox& InVoxelBox, TVoxelAttribute<uint8>& InOutExposure) const
+{
+	checkf(InOutExposure.GetGrid() == InOccupancy.GetGrid(), TEXT("Exposure doesn't match the occupancy's grid"));
+
+	const FVoxelBox VoxelBox = InVoxelBox.Intersect(InOccupancy.GetGrid().GetVoxelBox());
+
+	if(VoxelBox.IsEmpty())
+	{
+		return;
+	}
+
+	// Every voxel shares the same direction table, only the hemisphere it picks from it differs
+	const TArray<FVector> Directions = GetDirections();
+
+	const FVoxelBox ChunkRange = InOccupancy.GetChunkBox(VoxelBox);
+	const FIntVector NumChunks = ChunkRange.GetSize();
+
+	ParallelFor(ChunkRange.Num(), [&](const int32 Task)
+	{
+		const FIntVector ChunkCoordinate = ChunkRange.Min + FIntVector(Task % NumChunks.X, (Task / NumChunks.X) % NumChunks.Y, Task / (NumChunks.X * NumChunks.Y));
+		const FVoxelBox Box = InOccupancy.GetChunkBox(ChunkCoordinate).Intersect(VoxelBox);
+		const int32 ChunkMinX = ChunkCoordinate.X * FVoxelOccupancy::ChunkSize;
+
+		// A chunk row is one word, gather the neighbourhoods of the whole row at once
+		uint32 Masks[FVoxelOccupancy::ChunkSize];
+
+		for(int32 Z = Box.Min.Z; Z < Box.Max.Z; Z++)
+		{
+			for(int32 Y = Box.Min.Y; Y < Box.Max.Y; Y++)
+			{
+				FVoxelNeighbourhood::GatherWord(InOccupancy, ChunkCoordinate.X, Y, Z, Masks);
+
+				for(int32 X = Box.Min.X; X < Box.Max.X; X++)
+				{
+					const uint32 Mask = Masks[X - ChunkMinX];
+
+					// Only empty voxels with an occupied face neighbour are surface voxels
+					const bool bIsSurface = !(Mask & FVoxelNeighbourhood::CenterMask) && (Mask & FVoxelNeighbourhood::FaceMask);
+
+					InOutExposure[FIntVector(X, Y, Z)] = bIsSurface ? GetExposure(InOccupancy, FIntVector(X, Y, Z), Mask, Directions) : 0;
+				}
+			}
+		}
+	});
+}
+
+/**
+ * Gets how far a change to the occupancy can affect the exposure
+ * @return The radius in voxels, the ray length plus the face neighbour deciding what a surface voxel is
+ */
+int32 FVoxelExposureBaker::GetKernelRadius() const
+{
+	return FMath::CeilToInt(RayLength) + 1;
+}
+
+/**
+ * Spreads the directions evenly over the sphere (Fibonacci sphere)
+ * @return NumDirections unit directions
+ */
+TArray<FVector> FVoxelExposureBaker::GetDirections() const
+{
+	TArray<FVector> Result;
+	Result.Reserve(NumDirections);
+
+	const double GoldenAngle = UE_PI * (3.0 - FMath::Sqrt(5.0));
+
+	for(int32 Index = 0; Index < NumDirections; Index++)
+	{
+		const double Z = 1.0 - (Index + 0.5) * 2.0 / NumDirections;
+		const double RadiusXY = FMath::Sqrt(1.0 - Z * Z);
+		const double Theta = GoldenAngle * Index;
+
+		Result.Add(FVector(FMath::Cos(Theta) * RadiusXY, FMath::Sin(Theta) * RadiusXY, Z));
+	}
+
+	return Result;
+}
+
+/**
+ * Gets the exposure of a single surface voxel
+ * The hemisphere faces away from the occupied face neighbours
+ * @param InOccupancy The occupancy to cast rays through
+ * @param InCoordinate The empty voxel
+ * @param InNeighbourhoodMask The voxel's 3x3x3 neighbourhood mask
+ * @param InDirections The shared direction table
+ * @return The exposure
+ */
+uint8 FVoxelExposureBaker::GetExposure(const FVoxelOccupancy& InOccupancy, const FIntVector& InCoordinate,
+	const uint32 InNeighbourhoodMask, const TArray<FVector>& InDirections) const
+{
+	// Mask bits 12/14, 10/16 and 4/22 are the face neighbours along -X/+X, -Y/+Y and -Z/+Z
+	const FVector Normal(
+		static_cast<double>((InNeighbourhoodMask >> 12) & 1) - ((InNeighbourhoodMask >> 14) & 1),
+		static_cast<double>((InNeighbourhoodMask >> 10) & 1) - ((InNeighbourhoodMask >> 16) & 1),
+		static_cast<double>((InNeighbourhoodMask >> 4) & 1) - ((InNeighbourhoodMask >> 22) & 1));
+
+	// Geometry on opposite sides cancels out, fall back to the full sphere
+	const FVector SafeNormal = Normal.GetSafeNormal();
+	const FVector Start = FVector(InCoordinate) + FVector(0.5);
+
+	int32 NumRays = 0;
+	int32 NumEscaped = 0;
+
+	for(const FVector& Direction : InDirections)
+	{
+		if(Direction.Dot(SafeNormal) < 0.0)
+		{
+			continue;
+		}
+
+		NumRays++;
+
+		// Rays leaving the grid count as open air
+		if(!InOccupancy.LineTraceVoxels(Start, Start + Direction * RayLength))
+		{
+			NumEscaped++;
+		}
+	}
+
+	return NumRays > 0 ? static_cast<uint8>(FMath::RoundToInt(255.0 * NumEscaped / NumRays)) : 0;
+}
@@ -0,0 +1,391 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelFloodFill.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/**
+	 * Spreads seeds along a row through the passable bits in both directions (Kogge-Stone occluded fill)
+	 * @param Seeds The reachable bits, must be a subset of Passable
+	 * @param Passable The empty bits of the row
+	 * @return Every passable bit connected to a seed within the word
+	 */
+	uint64 FillRow(const uint64 Seeds, const uint64 Passable)
+	{
+		uint64 Up = Seeds;
+		uint64 UpPropagate = Passable;
+		uint64 Down = Seeds;
+		uint64 DownPropagate = Passable;
+
+		for(int32 Shift = 1; Shift < 64; Shift <<= 1)
+		{
+			Up |= UpPropagate & (Up << Shift);
+			UpPropagate &= UpPropagate << Shift;
+			Down |= DownPropagate & (Down >> Shift);
+			DownPropagate &= DownPropagate >> Shift;
+		}
+
+		return Up | Down;
+	}
+
+	/**
+	 * Gets the mask of the bits of a chunk row that are inside the grid
+	 * @param InWidth The number of voxels of the chunk along X
+	 * @return The mask
+	 */
+	uint64 GetRowMask(const int32 InWidth)
+	{
+		return InWidth >= 64 ? ~uint64(0) : (uint64(1) << InWidth) - 1;
+	}
+}
+
+/**
+ * Gets every empty voxel connected to the seeds through face neighbours
+ * Seeds that are outside the grid or inside occupied voxels are ignored
+ * @param InOccupancy The occupancy to fill through
+ * @param InSeeds The voxel coordinates to start from
+ * @return The reachable voxels, in the same layout as the occupancy
+ */
+FVoxelOccupancy FVoxelFloodFill::GetReachable(const FVoxelOccupancy& InOccupancy, const TArray<FIntVector>& InSeeds)
+{
+	const FVoxelGrid& Grid = InOccupancy.GetGrid();
+	const int32 NumChunks = InOccupancy.GetNumChunks();
+
+	FVoxelOccupancy Reachable(Grid);
+
+	// Bits waiting to be applied to each chunk, as (word index, bits) pairs
+	TArray<TArray<TPair<int32, uint64>>> PendingSeeds;
+	PendingSeeds.SetNum(NumChunks);
+
+	for(const FIntVector& Seed : InSeeds)
+	{
+		if(Grid.IsVoxelCoordinateValid(Seed) && !InOccupancy.IsOccupied(Seed))
+		{
+			const int32 ChunkIndex = InOccupancy.GetChunkIndex(Seed / FVoxelOccupancy::ChunkSize);
+			const int32 WordIndex = InOccupancy.GetRowWordIndex(Seed.Y, Seed.Z) + (Seed.X >> 6);
+
+			PendingSeeds[ChunkIndex].Emplace(WordIndex, uint64(1) << (Seed.X & 63));
+		}
+	}
+
+	TArray<int32> Frontier;
+
+	for(int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+	{
+		if(!PendingSeeds[ChunkIndex].IsEmpty())
+		{
+			Frontier.Add(ChunkIndex);
+		}
+	}
+
+	const FIntVector ChunkCount = InOccupancy.GetChunkCount();
+	const TArray<uint64>& OccupiedWords = InOccupancy.GetWords();
+	TArray<uint64>& ReachableWords = Reachable.GetWords();
+
+	TArray<uint8> ChangedChunks;
+	TArray<uint8> CandidateChunks;
+
+	while(!Frontier.IsEmpty())
+	{
+		ChangedChunks.Reset();
+		ChangedChunks.SetNumZeroed(NumChunks);
+
+		// Apply the pending seeds and fill each frontier chunk, every task only writes its own chunk
+		ParallelFor(Frontier.Num(), [&](const int32 FrontierIndex)
+		{
+			const int32 ChunkIndex = Frontier[FrontierIndex];
+			bool bSeeded = false;
+
+			for(const TPair<int32, uint64>& PendingSeed : PendingSeeds[ChunkIndex])
+			{
+				const uint64 NewBits = PendingSeed.Value & ~OccupiedWords[PendingSeed.Key] & ~ReachableWords[PendingSeed.Key];
+				ReachableWords[PendingSeed.Key] |= NewBits;
+				bSeeded |= NewBits != 0;
+			}
+
+			PendingSeeds[ChunkIndex].Reset();
+
+			if(bSeeded)
+			{
+				FillChunk(InOccupancy, Reachable, InOccupancy.GetChunkCoordinate(ChunkIndex));
+				ChangedChunks[ChunkIndex] = 1;
+			}
+		});
+
+		// The next frontier is every chunk touching a chunk that changed
+		CandidateChunks.Reset();
+		CandidateChunks.SetNumZeroed(NumChunks);
+
+		for(const int32 ChunkIndex : Frontier)
+		{
+			if(!ChangedChunks[ChunkIndex])
+			{
+				continue;
+			}
+
+			const FIntVector ChunkCoordinate = InOccupancy.GetChunkCoordinate(ChunkIndex);
+
+			for(int32 Axis = 0; Axis < 3; Axis++)
+			{
+				for(int32 Direction = -1; Direction <= 1; Direction += 2)
+				{
+					FIntVector Neighbour = ChunkCoordinate;
+					Neighbour[Axis] += Direction;
+
+					if(Neighbour[Axis] >= 0 && Neighbour[Axis] < ChunkCount[Axis])
+					{
+						CandidateChunks[InOccupancy.GetChunkIndex(Neighbour)] = 1;
+					}
+				}
+			}
+		}
+
+		TArray<int32> Candidates;
+
+		for(int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+		{
+			if(CandidateChunks[ChunkIndex])
+			{
+				Candidates.Add(ChunkIndex);
+			}
+		}
+
+		// Pull seeds across the faces of changed neighbours, nothing writes reachable words in this phase
+		ParallelFor(Candidates.Num(), [&](const int32 CandidateIndex)
+		{
+			const int32 ChunkIndex = Candidates[CandidateIndex];
+			GatherChunkSeeds(InOccupancy, Reachable, InOccupancy.GetChunkCoordinate(ChunkIndex), ChangedChunks, PendingSeeds[ChunkIndex]);
+		});
+
+		Frontier.Reset();
+
+		for(const int32 ChunkIndex : Candidates)
+		{
+			if(!PendingSeeds[ChunkIndex].IsEmpty())
+			{
+				Frontier.Add(ChunkIndex);
+			}
+		}
+	}
+
+	return Reachable;
+}
+
+/**
+ * Gets every empty voxel connected to the seeds through face neighbours
+ * Seeds that are outside the grid or inside occupied voxels are ignored
+ * @param InOccupancy The occupancy to fill through
+ * @param InSeedLocations The world locations to start from, e.g. player spawns
+ * @return The reachable voxels, in the same layout as the occupancy
+ */
+FVoxelOccupancy FVoxelFloodFill::GetReachable(const FVoxelOccupancy& InOccupancy, const TArray<FVector>& InSeedLocations)
+{
+	const FVoxelGrid& Grid = InOccupancy.GetGrid();
+
+	TArray<FIntVector> Seeds;
+	Seeds.Reserve(InSeedLocations.Num());
+
+	for(const FVector& SeedLocation : InSeedLocations)
+	{
+		if(Grid.IsLocationInBounds(SeedLocation))
+		{
+			const FIntVector Seed = Grid.GetVoxelCoordinate(SeedLocation);
+
+			// The far faces of the bounds are inside the bounds but past the last voxel
+			if(Grid.IsVoxelCoordinateValid(Seed))
+			{
+				Seeds.Add(Seed);
+			}
+		}
+	}
+
+	return GetReachable(InOccupancy, Seeds);
+}
+
+/**
+ * Spreads the reachable bits of a chunk until nothing changes, without leaving the chunk
+ * Rows are swept forwards then backwards so both directions along Y and Z propagate every pass
+ * @param InOccupancy The occupancy to fill through
+ * @param Reachable The reachable bits, only the chunk's own words are written
+ * @param InChunkCoordinate The chunk to fill
+ * @return true if any bit changed
+ */
+bool FVoxelFloodFill::FillChunk(const FVoxelOccupancy& InOccupancy, FVoxelOccupancy& Reachable, const FIntVector& InChunkCoordinate)
+{
+	FIntVector Min, Max;
+	InOccupancy.GetChunkVoxelRange(InChunkCoordinate, Min, Max);
+
+	const uint64 RowMask = GetRowMask(Max.X - Min.X);
+	const int32 StrideY = InOccupancy.GetWordsPerRow();
+	const int32 StrideZ = StrideY * InOccupancy.GetGrid().GetVectorVoxelCount().Y;
+
+	const uint64* OccupiedWords = InOccupancy.GetWords().GetData();
+	uint64* ReachableWords = Reachable.GetWords().GetData();
+
+	auto UpdateRow = [&](const int32 Y, const int32 Z) -> bool
+	{
+		const int32 WordIndex = InOccupancy.GetRowWordIndex(Y, Z) + InChunkCoordinate.X;
+		const uint64 Passable = ~OccupiedWords[WordIndex] & RowMask;
+
+		uint64 Word = ReachableWords[WordIndex];
+
+		if(Y > Min.Y) { Word |= ReachableWords[WordIndex - StrideY] & Passable; }
+		if(Y < Max.Y - 1) { Word |= ReachableWords[WordIndex + StrideY] & Passable; }
+		if(Z > Min.Z) { Word |= ReachableWords[WordIndex - StrideZ] & Passable; }
+		if(Z < Max.Z - 1) { Word |= ReachableWords[WordIndex + StrideZ] & Passable; }
+
+		if(Word == 0)
+		{
+			return false;
+		}
+
+		Word = FillRow(Word, Passable);
+
+		if(Word == ReachableWords[WordIndex])
+		{
+			return false;
+		}
+
+		ReachableWords[WordIndex] = Word;
+		return true;
+	};
+
+	bool bAnyChanged = false;
+	bool bChanged = true;
+
+	while(bChanged)
+	{
+		bChanged = false;
+
+		for(int32 Z = Min.Z; Z < Max.Z; Z++)
+		{
+			for(int32 Y = Min.Y; Y < Max.Y; Y++)
+			{
+				bChanged |= UpdateRow(Y, Z);
+			}
+		}
+
+		for(int32 Z = Max.Z - 1; Z >= Min.Z; Z--)
+		{
+			for(int32 Y = Max.Y - 1; Y >= Min.Y; Y--)
+			{
+				bChanged |= UpdateRow(Y, Z);
+			}
+		}
+
+		bAnyChanged |= bChanged;
+	}
+
+	return bAnyChanged;
+}
+
+/**
+ * Collects the bits a chunk gains from the faces of its changed neighbours
+ * @param InOccupancy The occupancy to fill through
+ * @param Reachable The reachable bits, read only
+ * @param InChunkCoordinate The chunk to gather seeds for
+ * @param InChangedChunks Flags for the chunks that changed in the last round
+ * @param OutSeeds The new (word index, bits) pairs for the chunk
+ */
+void FVoxelFloodFill::GatherChunkSeeds(const FVoxelOccupancy& InOccupancy, const FVoxelOccupancy& Reachable,
+	const FIntVector& InChunkCoordinate, const TArray<uint8>& InChangedChunks, TArray<TPair<int32, uint64>>& OutSeeds)
+{
+	const FIntVector ChunkCount = InOccupancy.GetChunkCount();
+
+	FIntVector Min, Max;
+	InOccupancy.GetChunkVoxelRange(InChunkCoordinate, Min, Max);
+
+	const uint64 RowMask = GetRowMask(Max.X - Min.X);
+	const uint64* OccupiedWords = InOccupancy.GetWords().GetData();
+	const uint64* ReachableWords = Reachable.GetWords().GetData();
+
+	auto IsNeighbourChanged = [&](const FIntVector& InOffset) -> bool
+	{
+		const FIntVector Neighbour = InChunkCoordinate + InOffset;
+
+		return Neighbour.X >= 0 && Neighbour.X < ChunkCount.X &&
+			Neighbour.Y >= 0 && Neighbour.Y < ChunkCount.Y &&
+			Neighbour.Z >= 0 && Neighbour.Z < ChunkCount.Z &&
+			InChangedChunks[InOccupancy.GetChunkIndex(Neighbour)];
+	};
+
+	auto AddSeed = [&](const int32 WordIndex, const uint64 Bits)
+	{
+		const uint64 NewBits = Bits & ~OccupiedWords[WordIndex] & ~ReachableWords[WordIndex] & RowMask;
+
+		if(NewBits != 0)
+		{
+			OutSeeds.Emplace(WordIndex, NewBits);
+		}
+	};
+
+	const bool bLeft = IsNeighbourChanged(FIntVector(-1, 0, 0));
+	const bool bRight = IsNeighbourChanged(FIntVector(1, 0, 0));
+
+	if(bLeft || bRight)
+	{
+		for(int32 Z = Min.Z; Z < Max.Z; Z++)
+		{
+			for(int32 Y = Min.Y; Y < Max.Y; Y++)
+			{
+				const int32 WordIndex = InOccupancy.GetRowWordIndex(Y, Z) + InChunkCoordinate.X;
+
+				// Bit 63 of the word to the left touches bit 0, bit 0 of the word to the right touches bit 63
+				const uint64 Bits = (bLeft ? ReachableWords[WordIndex - 1] >> 63 : 0) |
+					(bRight ? ReachableWords[WordIndex + 1] << 63 : 0);
+
+				AddSeed(WordIndex, Bits);
+			}
+		}
+	}
+
+	auto GatherFace = [&](const FIntVector& InOffset, const int32 InAxis, const int32 InOwnPlane, const int32 InNeighbourPlane)
+	{
+		if(!IsNeighbourChanged(InOffset))
+		{
+			return;
+		}
+
+		// Walk the rows of the face, InAxis is 1 for a Y face and 2 for a Z face
+		const int32 OtherMin = InAxis == 1 ? Min.Z : Min.Y;
+		const int32 OtherMax = InAxis == 1 ? Max.Z : Max.Y;
+
+		for(int32 Other = OtherMin; Other < OtherMax; Other++)
+		{
+			const int32 OwnWordIndex = (InAxis == 1 ? InOccupancy.GetRowWordIndex(InOwnPlane, Other) : InOccupancy.GetRowWordIndex(Other, InOwnPlane)) + InChunkCoordinate.X;
+			const int32 NeighbourWordIndex = (InAxis == 1 ? InOccupancy.GetRowWordIndex(InNeighbourPlane, Other) : InOccupancy.GetRowWordIndex(Other, InNeighbourPlane)) + InChunkCoordinate.X;
+
+			AddSeed(OwnWordIndex, ReachableWords[NeighbourWordIndex]);
+		}
+	};
+
+	GatherFace(FIntVector(0, -1, 0), 1, Min.Y, Min.Y - 1);
+	GatherFace(FIntVector(0, 1, 0), 1, Max.Y - 1, Max.Y);
+	GatherFace(FIntVector(0, 0, -1), 2, Min.Z, Min.Z - 1);
+	GatherFace(FIntVector(0, 0, 1), 2, Max.Z - 1, Max.Z);
+}
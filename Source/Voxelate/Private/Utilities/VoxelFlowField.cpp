@@ -0,0 +1,469 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelFlowField.h"
+
+#include "Async/ParallelFor.h"
+#include "Data/VoxelNeighbourhood.h"
+#include "Utilities/VoxelCostField.h"
+
+namespace
+{
+	/**
+	 * Gets the unit vector of a direction
+	 * @param InDirectionBit The direction's neighbourhood mask bit
+	 * @return The unit vector, zero for NoDirection
+	 */
+	const FVector& GetUnitDirection(const uint8 InDirectionBit)
+	{
+		static const TArray<FVector> UnitDirections = []()
+		{
+			TArray<FVector> Result;
+
+			for(uint8 Bit = 0; Bit < 27; Bit++)
+			{
+				Result.Add(FVector(FVoxelFlowField::GetDirectionOffset(Bit)).GetSafeNormal());
+			}
+
+			return Result;
+		}();
+
+		return UnitDirections[InDirectionBit];
+	}
+}
+
+/**
+ * Class constructor, builds the integration and direction fields
+ * @param InTraversable The voxels agents can be in, e.g. a walkable layer for walking agents
+ * @param InGoal The goal's voxel in the traversable voxels' grid
+ * @param InRegion The voxels the field covers, clamped to the grid
+ * @param InDirections The directions agents are steered along
+ * @param InStepCosts The cost of a step into each voxel on the traversable voxels' grid, null for uniform costs
+ */
+FVoxelFlowField::FVoxelFlowField(const FVoxelOccupancy& InTraversable, const FIntVector& InGoal, const FVoxelBox& InRegion,
+	const EVoxelFlowDirections InDirections, const TVoxelAttribute<uint8>* InStepCosts)
+	: Goal(InGoal)
+{
+	const bool bIsPlanar = InDirections == EVoxelFlowDirections::Planar8;
+
+	// Walking agents step up and down one voxel along an axis, which are edge neighbours on a walkable layer,
+	// so only steps along X and Y together are kept from squeezing between blocked voxels
+	const EVoxelConnectivity Connectivity = bIsPlanar ? EVoxelConnectivity::Edge : EVoxelConnectivity::Vertex;
+	const EVoxelCornerCutting CornerCutting = bIsPlanar ? EVoxelCornerCutting::PreventHorizontal : EVoxelCornerCutting::Prevent;
+
+	FVoxelCostField CostField(InTraversable, InRegion, Connectivity, InStepCosts, CornerCutting);
+	CostField.AddSource(InGoal);
+	CostField.Update();
+
+	Region = CostField.GetRegion();
+	Grid = CostField.GetCosts().GetGrid();
+
+	const FIntVector Size = Region.GetSize();
+
+	ChunkCount = FIntVector(
+		FMath::DivideAndRoundUp(Size.X, FVoxelOccupancy::ChunkSize),
+		FMath::DivideAndRoundUp(Size.Y, FVoxelOccupancy::ChunkSize),
+		FMath::DivideAndRoundUp(Size.Z, FVoxelOccupancy::ChunkSize));
+
+	Chunks.SetNum(ChunkCount.X * ChunkCount.Y * ChunkCount.Z);
+
+	// The steps the wavefront takes, planar directions leave out the steps straight up and down
+	const uint32 ConnectivityMask = FVoxelNeighbourhood::GetConnectivityMask(Connectivity);
+
+	TArray<FIntVector, TFixedAllocator<26>> Offsets;
+
+	for(uint8 Bit = 0; Bit < 27; Bit++)
+	{
+		const FIntVector Offset = GetDirectionOffset(Bit);
+
+		if((ConnectivityMask & (1u << Bit)) && (!bIsPlanar || Offset.X != 0 || Offset.Y != 0))
+		{
+			Offsets.Add(Offset);
+		}
+	}
+
+	// Every task only writes its own chunk
+	ParallelFor(Chunks.Num(), [this, &CostField, bIsPlanar, &Offsets](const int32 ChunkIndex)
+	{
+		ResolveChunk(CostField, ChunkIndex, bIsPlanar, Offsets);
+	});
+}
+
+const FIntVector& FVoxelFlowField::GetGoal() const
+{
+	return Goal;
+}
+
+const FVoxelBox& FVoxelFlowField::GetRegion() const
+{
+	return Region;
+}
+
+/**
+ * Gets the memory held by the field's chunks
+ * @return The number of bytes
+ */
+SIZE_T FVoxelFlowField::GetAllocatedSize() const
+{
+	SIZE_T Size = Chunks.GetAllocatedSize();
+
+	for(const FChunk& Chunk : Chunks)
+	{
+		Size += Chunk.Integration.GetAllocatedSize() + Chunk.Directions.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+/**
+ * Gets the step cost distance of a voxel to the goal
+ * @param InCoordinate The voxel coordinate in the traversable voxels' grid
+ * @return The distance, FVoxelCostField::Unreachable outside the region and where the goal can't be reached from
+ */
+uint16 FVoxelFlowField::GetCost(const FIntVector& InCoordinate) const
+{
+	int32 ChunkIndex, Index;
+
+	return FindVoxel(InCoordinate, ChunkIndex, Index) ? Chunks[ChunkIndex].Integration[Index] : FVoxelCostField::Unreachable;
+}
+
+/**
+ * Gets the direction of a voxel
+ * @param InCoordinate The voxel coordinate in the traversable voxels' grid
+ * @return The direction's neighbourhood mask bit, NoDirection outside the region and where the goal can't be reached from
+ */
+uint8 FVoxelFlowField::GetDirectionBit(const FIntVector& InCoordinate) const
+{
+	int32 ChunkIndex, Index;
+
+	return FindVoxel(InCoordinate, ChunkIndex, Index) ? Chunks[ChunkIndex].Directions[Index] : NoDirection;
+}
+
+/**
+ * Gets the direction an agent should move in
+ * @param InLocation The agent's world location
+ * @return The unit direction, zero at the goal, outside the region and where the goal can't be reached from
+ */
+FVector FVoxelFlowField::GetDirection(const FVector& InLocation) const
+{
+	if(!Grid.IsLocationInBounds(InLocation))
+	{
+		return FVector::ZeroVector;
+	}
+
+	const FIntVector Coordinate = Grid.GetVoxelCoordinate(InLocation);
+
+	return Grid.IsVoxelCoordinateValid(Coordinate) ? GetUnitDirection(GetDirectionBit(Region.Min + Coordinate)) : FVector::ZeroVector;
+}
+
+/**
+ * Gets the neighbour offset of a direction
+ * @param InDirectionBit The direction's neighbourhood mask bit
+ * @return The offset, zero for NoDirection
+ */
+FIntVector FVoxelFlowField::GetDirectionOffset(const uint8 InDirectionBit)
+{
+	checkf(InDirectionBit < 27, TEXT("Invalid direction %d"), InDirectionBit);
+
+	return FIntVector(InDirectionBit % 3 - 1, (InDirectionBit / 3) % 3 - 1, InDirectionBit / 9 - 1);
+}
+
+/**
+ * Points every reachable voxel of a chunk at the neighbour closest to the goal that it can step to
+ * Only the steps the wavefront could take are considered, planar directions drop the step's vertical part
+ * The chunk is left empty when the goal can't be reached from any of its voxels
+ * @param InCostField The wavefront's distances to the goal
+ * @param InChunkIndex The chunk
+ * @param bIsPlanar Whether agents are steered along the 8 compass directions
+ * @param InOffsets The steps to consider
+ */
+void FVoxelFlowField::ResolveChunk(const FVoxelCostField& InCostField, const int32 InChunkIndex, const bool bIsPlanar,
+	TConstArrayView<FIntVector> InOffsets)
+{
+	const TVoxelAttribute<uint16>& Costs = InCostField.GetCosts();
+	const FVoxelBox ChunkBox = GetChunkBox(InChunkIndex);
+
+	bool bIsReachable = false;
+
+	ChunkBox.ForEach([&Costs, &bIsReachable](const FIntVector& Coordinate)
+	{
+		bIsReachable |= Costs[Coordinate] != FVoxelCostField::Unreachable;
+	});
+
+	if(!bIsReachable)
+	{
+		return;
+	}
+
+	FChunk& Chunk = Chunks[InChunkIndex];
+	Chunk.Integration.SetNumUninitialized(ChunkBox.Num());
+	Chunk.Directions.Init(NoDirection, ChunkBox.Num());
+
+	int32 Index = 0;
+
+	ChunkBox.ForEach([&](const FIntVector& Coordinate)
+	{
+		const uint16 Cost = Costs[Coordinate];
+		Chunk.Integration[Index] = Cost;
+
+		// The goal and voxels it can't be reached from keep no direction
+		if(Cost != 0 && Cost != FVoxelCostField::Unreachable)
+		{
+			uint16 BestCost = Cost;
+			FIntVector BestOffset = FIntVector::ZeroValue;
+
+			for(const FIntVector& Offset : InOffsets)
+			{
+				const FIntVector Neighbour = Coordinate + Offset;
+
+				if(Grid.IsVoxelCoordinateValid(Neighbour) && Costs[Neighbour] < BestCost && InCostField.CanStep(Coordinate, Offset))
+				{
+					BestCost = Costs[Neighbour];
+					BestOffset = Offset;
+				}
+			}
+
+			if(bIsPlanar)
+			{
+				BestOffset.Z = 0;
+			}
+
+			Chunk.Directions[Index] = uint8(FVoxelNeighbourhood::GetMaskBit(BestOffset));
+		}
+
+		Index++;
+	});
+}
+
+/**
+ * Gets the voxels of a chunk of the region
+ * @param InChunkIndex The chunk
+ * @return The chunk's voxels in the region's grid, clamped to the region
+ */
+FVoxelBox FVoxelFlowField::GetChunkBox(const int32 InChunkIndex) const
+{
+	const FIntVector ChunkCoordinate(InChunkIndex % ChunkCount.X, (InChunkIndex / ChunkCount.X) % ChunkCount.Y, InChunkIndex / (ChunkCount.X * ChunkCount.Y));
+	const FIntVector Min = ChunkCoordinate * FVoxelOccupancy::ChunkSize;
+
+	return FVoxelBox(Min, Min + FIntVector(FVoxelOccupancy::ChunkSize)).Intersect(Grid.GetVoxelBox());
+}
+
+/**
+ * Finds where a voxel is stored
+ * @param InCoordinate The voxel coordinate in the traversable voxels' grid
+ * @param OutChunkIndex The voxel's chunk
+ * @param OutIndex The voxel's index in its chunk, X fastest
+ * @return false if the voxel is outside the region or its chunk isn't stored
+ */
+bool FVoxelFlowField::FindVoxel(const FIntVector& InCoordinate, int32& OutChunkIndex, int32& OutIndex) const
+{
+	if(!Region.Contains(InCoordinate))
+	{
+		return false;
+	}
+
+	const FIntVector Local = InCoordinate - Region.Min;
+	const FIntVector ChunkCoordinate = Local / FVoxelOccupancy::ChunkSize;
+
+	OutChunkIndex = ChunkCoordinate.X + (ChunkCoordinate.Y + ChunkCoordinate.Z * ChunkCount.Y) * ChunkCount.X;
+
+	if(Chunks[OutChunkIndex].Directions.IsEmpty())
+	{
+		return false;
+	}
+
+	const FVoxelBox ChunkBox = GetChunkBox(OutChunkIndex);
+	const FIntVector ChunkSize = ChunkBox.GetSize();
+	const FIntVector InChunk = Local - ChunkBox.Min;
+
+	OutIndex = InChunk.X + (InChunk.Y + InChunk.Z * ChunkSize.Y) * ChunkSize.X;
+
+	return true;
+}
+
+/**
+ * Class constructor
+ * @param InTraversable The voxels agents can be in, must outlive the cache
+ * @param InDirections The directions agents are steered along
+ * @param InChunkRadius The number of chunks a field covers on each side of its goal's chunk, INDEX_NONE for the whole grid
+ * @param InMaxFields The number of goals to keep fields for, the least recently used field is dropped first
+ * @param InStepCosts The cost of a step into each voxel on the traversable voxels' grid, null for uniform costs, must outlive the cache
+ */
+FVoxelFlowFieldCache::FVoxelFlowFieldCache(const FVoxelOccupancy& InTraversable, const EVoxelFlowDirections InDirections,
+	const int32 InChunkRadius, const int32 InMaxFields, const TVoxelAttribute<uint8>* InStepCosts)
+	: Traversable(InTraversable), StepCosts(InStepCosts), Directions(InDirections), ChunkRadius(InChunkRadius),
+	MaxFields(FMath::Max(InMaxFields, 1))
+{
+}
+
+/**
+ * Gets the flow field towards a goal, building it if it isn't cached
+ * Fields are built outside the lock, two threads asking for the same new goal may both build it, one of them is kept,
+ * a field whose build overlapped an invalidation is thrown away and built again
+ * @param InGoal The goal's voxel in the traversable voxels' grid
+ * @return The field
+ */
+FVoxelFlowFieldCache::FFieldPtr FVoxelFlowFieldCache::GetField(const FIntVector& InGoal)
+{
+	while(true)
+	{
+		uint64 StartGeneration;
+
+		{
+			FScopeLock ScopeLock(&Lock);
+
+			if(FEntry* Entry = Fields.Find(InGoal))
+			{
+				Entry->LastUsed = ++UseCount;
+				return Entry->Field;
+			}
+
+			StartGeneration = Generation;
+		}
+
+		const FFieldPtr Built = MakeShared<FVoxelFlowField, ESPMode::ThreadSafe>(Traversable, InGoal, GetRegion(InGoal), Directions, StepCosts);
+
+		FScopeLock ScopeLock(&Lock);
+
+		// The traversable voxels were invalidated while building, the field may hold voxels from before the edit
+		if(Generation != StartGeneration)
+		{
+			continue;
+		}
+
+		FEntry& Entry = Fields.FindOrAdd(InGoal);
+
+		if(!Entry.Field)
+		{
+			Entry.Field = Built;
+		}
+
+		Entry.LastUsed = ++UseCount;
+
+		const FFieldPtr Result = Entry.Field;
+		Trim();
+
+		return Result;
+	}
+}
+
+/**
+ * Gets the flow field towards the voxel holding a location, building it if it isn't cached
+ * @param InGoalLocation The goal's world location
+ * @return The field, null if the location is outside the grid
+ */
+FVoxelFlowFieldCache::FFieldPtr FVoxelFlowFieldCache::GetField(const FVector& InGoalLocation)
+{
+	const FVoxelGrid& Grid = Traversable.GetGrid();
+
+	if(!Grid.IsLocationInBounds(InGoalLocation))
+	{
+		return FFieldPtr();
+	}
+
+	const FIntVector Goal = Grid.GetVoxelCoordinate(InGoalLocation);
+
+	return Grid.IsVoxelCoordinateValid(Goal) ? GetField(Goal) : FFieldPtr();
+}
+
+/**
+ * Drops every field covering changed voxels, agents holding a dropped field keep using it until they ask again
+ * @param InChangedBox The voxels that changed in the traversable voxels' grid
+ */
+void FVoxelFlowFieldCache::Invalidate(const FVoxelBox& InChangedBox)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	Generation++;
+
+	for(auto It = Fields.CreateIterator(); It; ++It)
+	{
+		if(It.Value().Field->GetRegion().Intersects(InChangedBox))
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FVoxelFlowFieldCache::Empty()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	Generation++;
+	Fields.Empty();
+}
+
+int32 FVoxelFlowFieldCache::Num() const
+{
+	FScopeLock ScopeLock(&Lock);
+
+	return Fields.Num();
+}
+
+/**
+ * Gets the voxels a field towards a goal covers
+ * @param InGoal The goal's voxel in the traversable voxels' grid
+ * @return The region
+ */
+FVoxelBox FVoxelFlowFieldCache::GetRegion(const FIntVector& InGoal) const
+{
+	const FVoxelGrid& Grid = Traversable.GetGrid();
+
+	if(ChunkRadius == INDEX_NONE)
+	{
+		return Grid.GetVoxelBox();
+	}
+
+	if(!Grid.IsVoxelCoordinateValid(InGoal))
+	{
+		return FVoxelBox();
+	}
+
+	return FVoxelCostField::GetRegionAround(Traversable, {Grid.GetVoxelBounds(InGoal).GetCenter()}, ChunkRadius);
+}
+
+/**
+ * Drops the least recently used fields until the cache is within its size, the lock must be held
+ */
+void FVoxelFlowFieldCache::Trim()
+{
+	while(Fields.Num() > MaxFields)
+	{
+		const FIntVector* Oldest = nullptr;
+		uint64 OldestUse = MAX_uint64;
+
+		for(const TPair<FIntVector, FEntry>& Pair : Fields)
+		{
+			if(Pair.Value.LastUsed < OldestUse)
+			{
+				Oldest = &Pair.Key;
+				OldestUse = Pair.Value.LastUsed;
+			}
+		}
+
+		const FIntVector OldestGoal = *Oldest;
+		Fields.Remove(OldestGoal);
+	}
+}
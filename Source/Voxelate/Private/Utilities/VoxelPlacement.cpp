@@ -0,0 +1,194 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelPlacement.h"
+
+/**
+ * Finds the nearest voxel center where an axis aligned box fits without touching any occupied voxel
+ * @param InVolume The summed volume table of the occupancy
+ * @param InSeedLocation Where to search from, clamped to the grid
+ * @param InExtent Half size of the box
+ * @param InMaxRadius Farthest shell to search, in voxels from the seed voxel
+ * @param OutLocation Receives the center of the placed box
+ * @param bRequireSupport Only accept placements with at least one occupied voxel right below the box
+ * @return true if a placement was found
+ */
+bool FVoxelPlacement::FindNearestFree(const FVoxelSummedVolume& InVolume, const FVector& InSeedLocation, const FVector& InExtent,
+	const int32 InMaxRadius, FVector& OutLocation, const bool bRequireSupport)
+{
+	const FVoxelGrid& Grid = InVolume.GetGrid();
+	const FVoxelBox GridBox = Grid.GetVoxelBox();
+
+	if(GridBox.IsEmpty())
+	{
+		return false;
+	}
+
+	const FIntVector HalfSize = GetHalfSize(Grid, InExtent);
+	const FIntVector Lattice = Grid.GetLatticeCoordinate(InSeedLocation) - Grid.GetLatticeOrigin();
+	const FIntVector Seed(
+		FMath::Clamp(Lattice.X, GridBox.Min.X, GridBox.Max.X - 1),
+		FMath::Clamp(Lattice.Y, GridBox.Min.Y, GridBox.Max.Y - 1),
+		FMath::Clamp(Lattice.Z, GridBox.Min.Z, GridBox.Max.Z - 1));
+
+	const double MinVoxelSize = Grid.GetVoxelSize().GetMin();
+
+	// A seed outside the grid is clamped to the nearest voxel, shells are only that much closer to it
+	const double SeedDistance = FMath::Sqrt(Grid.GetVoxelBounds(Seed).ComputeSquaredDistanceToPoint(InSeedLocation));
+
+	double BestDistanceSquared = TNumericLimits<double>::Max();
+	bool bFound = false;
+
+	for(int32 Radius = 0; Radius <= InMaxRadius; Radius++)
+	{
+		// Centers in this shell or beyond are at least this far from anywhere in the seed voxel, less the seed's distance to that voxel
+		const double ShellDistance = FMath::Max((Radius - 0.5) * MinVoxelSize - SeedDistance, 0.0);
+
+		if(bFound && ShellDistance * ShellDistance > BestDistanceSquared)
+		{
+			break;
+		}
+
+		ForEachShellCoordinate(Seed, Radius, [&](const FIntVector& Coordinate)
+		{
+			if(!GridBox.Contains(Coordinate))
+			{
+				return;
+			}
+
+			const FVector Center = Grid.GetVoxelBounds(Coordinate).GetCenter();
+			const double DistanceSquared = FVector::DistSquared(Center, InSeedLocation);
+
+			if(DistanceSquared < BestDistanceSquared && Fits(InVolume, Coordinate, HalfSize, bRequireSupport))
+			{
+				BestDistanceSquared = DistanceSquared;
+				OutLocation = Center;
+				bFound = true;
+			}
+		});
+	}
+
+	return bFound;
+}
+
+/**
+ * Finds the nearest place an oriented box fits, keeping its orientation
+ * The box is checked through its axis aligned bounds, so placements are conservative
+ * @param InVolume The summed volume table of the occupancy
+ * @param InBox The box, its center is the seed
+ * @param InMaxRadius Farthest shell to search, in voxels from the seed voxel
+ * @param OutLocation Receives the new center of the box
+ * @param bRequireSupport Only accept placements with at least one occupied voxel right below the box
+ * @return true if a placement was found
+ */
+bool FVoxelPlacement::FindNearestFree(const FVoxelSummedVolume& InVolume, const FOOBBoxProxy& InBox,
+	const int32 InMaxRadius, FVector& OutLocation, const bool bRequireSupport)
+{
+	return FindNearestFree(InVolume, InBox.Center, GetExtent(InBox), InMaxRadius, OutLocation, bRequireSupport);
+}
+
+/**
+ * Finds the nearest place a capsule fits, keeping its orientation
+ * The capsule is checked through its axis aligned bounds, so placements are conservative
+ * @param InVolume The summed volume table of the occupancy
+ * @param InCapsule The capsule, the middle of its segment is the seed
+ * @param InMaxRadius Farthest shell to search, in voxels from the seed voxel
+ * @param OutLocation Receives the new middle of the capsule's segment
+ * @param bRequireSupport Only accept placements with at least one occupied voxel right below the capsule
+ * @return true if a placement was found
+ */
+bool FVoxelPlacement::FindNearestFree(const FVoxelSummedVolume& InVolume, const FCapsuleProxy& InCapsule,
+	const int32 InMaxRadius, FVector& OutLocation, const bool bRequireSupport)
+{
+	return FindNearestFree(InVolume, (InCapsule.Start + InCapsule.End) * 0.5, GetExtent(InCapsule), InMaxRadius, OutLocation, bRequireSupport);
+}
+
+/**
+ * Gets the half size of an oriented box's axis aligned bounds
+ * @param InBox The box
+ * @return The half size
+ */
+FVector FVoxelPlacement::GetExtent(const FOOBBoxProxy& InBox)
+{
+	FVector AxisX, AxisY, AxisZ;
+	InBox.GetAxis(AxisX, AxisY, AxisZ);
+
+	return AxisX.GetAbs() * InBox.Extents.X + AxisY.GetAbs() * InBox.Extents.Y + AxisZ.GetAbs() * InBox.Extents.Z;
+}
+
+/**
+ * Gets the half size of a capsule's axis aligned bounds
+ * @param InCapsule The capsule
+ * @return The half size
+ */
+FVector FVoxelPlacement::GetExtent(const FCapsuleProxy& InCapsule)
+{
+	return (InCapsule.End - InCapsule.Start).GetAbs() * 0.5 + FVector(InCapsule.Radius);
+}
+
+/**
+ * Gets the number of voxels a box centered on a voxel covers on each side of that voxel
+ * @param InGrid The grid
+ * @param InExtent Half size of the box
+ * @return The voxels on each side
+ */
+FIntVector FVoxelPlacement::GetHalfSize(const FVoxelGrid& InGrid, const FVector& InExtent)
+{
+	const FVector VoxelSize = InGrid.GetVoxelSize();
+
+	// The center voxel already covers half a voxel on each side
+	return FIntVector(
+		FMath::Max(FMath::CeilToInt((InExtent.X - VoxelSize.X * 0.5) / VoxelSize.X - UE_KINDA_SMALL_NUMBER), 0),
+		FMath::Max(FMath::CeilToInt((InExtent.Y - VoxelSize.Y * 0.5) / VoxelSize.Y - UE_KINDA_SMALL_NUMBER), 0),
+		FMath::Max(FMath::CeilToInt((InExtent.Z - VoxelSize.Z * 0.5) / VoxelSize.Z - UE_KINDA_SMALL_NUMBER), 0));
+}
+
+/**
+ * Checks if a box centered on a voxel is inside the grid and free
+ * @param InVolume The summed volume table of the occupancy
+ * @param InCoordinate The center voxel
+ * @param InHalfSize The voxels the box covers on each side of the center voxel
+ * @param bRequireSupport Also require at least one occupied voxel in the layer right below the box
+ * @return true if the box fits
+ */
+bool FVoxelPlacement::Fits(const FVoxelSummedVolume& InVolume, const FIntVector& InCoordinate, const FIntVector& InHalfSize,
+	const bool bRequireSupport)
+{
+	const FVoxelBox Box(InCoordinate - InHalfSize, InCoordinate + InHalfSize + FIntVector(1));
+
+	if(!InVolume.GetGrid().GetVoxelBox().Contains(Box) || !InVolume.IsFree(Box))
+	{
+		return false;
+	}
+
+	if(!bRequireSupport)
+	{
+		return true;
+	}
+
+	const FVoxelBox Support(FIntVector(Box.Min.X, Box.Min.Y, Box.Min.Z - 1), FIntVector(Box.Max.X, Box.Max.Y, Box.Min.Z));
+
+	return Support.Min.Z >= 0 && InVolume.CountOccupied(Support) > 0;
+}
@@ -0,0 +1,243 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelQueryBatch.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/**
+	 * Spreads the low 21 bits of a value so there are two zero bits between each of them
+	 * @param Value The value to spread
+	 * @return The spread bits
+	 */
+	uint64 SpreadBits(const uint32 Value)
+	{
+		uint64 Bits = Value & 0x1fffff;
+		Bits = (Bits | Bits << 32) & 0x1f00000000ffffull;
+		Bits = (Bits | Bits << 16) & 0x1f0000ff0000ffull;
+		Bits = (Bits | Bits << 8) & 0x100f00f00f00f00full;
+		Bits = (Bits | Bits << 4) & 0x10c30c30c30c30c3ull;
+		Bits = (Bits | Bits << 2) & 0x1249249249249249ull;
+
+		return Bits;
+	}
+}
+
+/**
+ * Class constructor
+ * @param InGrid The grid requests are made against, the occupancy the batch is executed on must share it
+ */
+FVoxelQueryBatch::FVoxelQueryBatch(const FVoxelGrid& InGrid) : Grid(InGrid)
+{
+}
+
+/**
+ * Removes every request and result, keeping the memory for the next batch
+ */
+void FVoxelQueryBatch::Reset()
+{
+	Boxes.Reset();
+	Keys.Reset();
+	Counts.Reset();
+}
+
+void FVoxelQueryBatch::Reserve(const int32 InNumRequests)
+{
+	Boxes.Reserve(InNumRequests);
+	Keys.Reserve(InNumRequests);
+	Counts.Reserve(InNumRequests);
+}
+
+int32 FVoxelQueryBatch::Num() const
+{
+	return Boxes.Num();
+}
+
+/**
+ * Adds a query for the occupancy of a single voxel
+ * @param InCoordinate The voxel coordinate, voxels outside the grid are empty
+ * @return The request, used to read the result after Execute
+ */
+int32 FVoxelQueryBatch::AddPoint(const FIntVector& InCoordinate)
+{
+	return AddBox(FVoxelBox::FromCoordinate(InCoordinate));
+}
+
+/**
+ * Adds a query for the occupancy of the voxel holding a location
+ * @param InLocation The location in world space, locations outside the grid are empty
+ * @return The request, used to read the result after Execute
+ */
+int32 FVoxelQueryBatch::AddPoint(const FVector& InLocation)
+{
+	return AddPoint(Grid.GetLatticeCoordinate(InLocation) - Grid.GetLatticeOrigin());
+}
+
+/**
+ * Adds a query for the number of occupied voxels in a box
+ * @param InVoxelBox The voxel box, the part outside the grid counts as empty
+ * @return The request, used to read the result after Execute
+ */
+int32 FVoxelQueryBatch::AddBox(const FVoxelBox& InVoxelBox)
+{
+	Keys.Add(GetMortonKey(InVoxelBox.Min));
+	Counts.Add(0);
+
+	return Boxes.Add(InVoxelBox);
+}
+
+/**
+ * Adds a query for the number of occupied voxels overlapping some bounds
+ * @param InBounds The bounds in world space, rounded out to whole voxels
+ * @return The request, used to read the result after Execute
+ */
+int32 FVoxelQueryBatch::AddBox(const FBox& InBounds)
+{
+	return AddBox(Grid.GetVoxelBox(InBounds));
+}
+
+/**
+ * Answers every request
+ * @param InOccupancy The occupancy to query
+ * @param InVolume Optional summed volume table of the occupancy, boxes are counted in constant time with it
+ */
+void FVoxelQueryBatch::Execute(const FVoxelOccupancy& InOccupancy, const FVoxelSummedVolume* InVolume)
+{
+	checkf(InOccupancy.GetGrid() == Grid, TEXT("Occupancy doesn't match the query batch's grid"));
+	checkf(!InVolume || InVolume->GetGrid() == Grid, TEXT("Summed volume doesn't match the query batch's grid"));
+
+	const FVoxelBox GridBox = Grid.GetVoxelBox();
+
+	ExecuteRequests([&InOccupancy, InVolume, &GridBox](const FVoxelBox& Box)
+	{
+		if(Box.Num() == 1)
+		{
+			return GridBox.Contains(Box.Min) && InOccupancy.IsOccupied(Box.Min) ? 1 : 0;
+		}
+
+		return InVolume ? static_cast<int32>(InVolume->CountOccupied(Box)) : InOccupancy.CountOccupied(Box);
+	});
+}
+
+/**
+ * Answers every request against the store's current version
+ * A single epoch is pinned for the whole batch, reads take no lock and the version can't be freed until the batch is done
+ * @param InStore The store to query
+ */
+void FVoxelQueryBatch::Execute(const FVoxelChunkStore& InStore)
+{
+	const FVoxelChunkStore::FReadScope Scope(InStore);
+	const FVoxelChunkMap& Map = Scope.Get();
+
+	checkf(Map.GetGrid() == Grid, TEXT("Chunk store doesn't match the query batch's grid"));
+
+	const FVoxelBox GridBox = Grid.GetVoxelBox();
+
+	ExecuteRequests([&Map, &GridBox](const FVoxelBox& Box)
+	{
+		if(Box.Num() == 1)
+		{
+			return GridBox.Contains(Box.Min) && Map.IsOccupied(Box.Min) ? 1 : 0;
+		}
+
+		return Map.CountOccupied(Box);
+	});
+}
+
+/**
+ * Gets the number of occupied voxels a request found
+ * @param InRequest The request
+ * @return The count, 0 or 1 for points
+ */
+int32 FVoxelQueryBatch::GetCount(const int32 InRequest) const
+{
+	return Counts[InRequest];
+}
+
+/**
+ * Checks if a request found any occupied voxel
+ * @param InRequest The request
+ * @return true if anything was occupied
+ */
+bool FVoxelQueryBatch::IsOccupied(const int32 InRequest) const
+{
+	return Counts[InRequest] > 0;
+}
+
+/**
+ * Gets the results of every request
+ * @return The counts, in request order
+ */
+const TArray<int32>& FVoxelQueryBatch::GetCounts() const
+{
+	return Counts;
+}
+
+/**
+ * Gets the Morton code of a coordinate, interleaving 21 bits of each axis
+ * Every aligned chunk of voxels is a contiguous range of codes, so sorting by it groups requests by chunk
+ * @param InCoordinate The coordinate, negative axes are clamped to 0
+ * @return The code
+ */
+uint64 FVoxelQueryBatch::GetMortonKey(const FIntVector& InCoordinate)
+{
+	return SpreadBits(FMath::Max(InCoordinate.X, 0)) |
+		SpreadBits(FMath::Max(InCoordinate.Y, 0)) << 1 |
+		SpreadBits(FMath::Max(InCoordinate.Z, 0)) << 2;
+}
+
+/**
+ * Visits the requests in Morton order, split into parallel batches, each request only writes its own result
+ * @param CountBox Counts the occupied voxels of a request's box, called from worker threads
+ */
+void FVoxelQueryBatch::ExecuteRequests(TFunctionRef<int32(const FVoxelBox&)> CountBox)
+{
+	TArray<int32> Order;
+	Order.SetNumUninitialized(Boxes.Num());
+
+	for(int32 Request = 0; Request < Order.Num(); Request++)
+	{
+		Order[Request] = Request;
+	}
+
+	Order.Sort([this](const int32 A, const int32 B)
+	{
+		return Keys[A] < Keys[B];
+	});
+
+	const int32 NumBatches = FMath::DivideAndRoundUp(Order.Num(), BatchSize);
+
+	ParallelFor(NumBatches, [this, &Order, &CountBox](const int32 Batch)
+	{
+		for(int32 Sorted = Batch * BatchSize; Sorted < FMath::Min((Batch + 1) * BatchSize, Order.Num()); Sorted++)
+		{
+			const int32 Request = Order[Sorted];
+
+			Counts[Request] = CountBox(Boxes[Request]);
+		}
+	});
+}
@@ -0,0 +1,917 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelSurfaceExtractor.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/**
+	 * Cell corner I is at offset (I & 1, (I >> 1) & 1, (I >> 2) & 1), a case sets bit I when corner I is inside
+	 * Edges 0 to 3 run along X, 4 to 7 along Y and 8 to 11 along Z, see EdgeCorners
+	 */
+	constexpr int32 EdgeCorners[12][2] = {
+		{0, 1}, {2, 3}, {4, 5}, {6, 7},
+		{0, 2}, {1, 3}, {4, 6}, {5, 7},
+		{0, 4}, {1, 5}, {2, 6}, {3, 7}
+	};
+
+	// Edges crossed by the surface for every case
+	constexpr uint16 EdgeTable[256] = {
+		0x000, 0x111, 0x221, 0x330, 0x412, 0x503, 0x633, 0x722,
+		0x822, 0x933, 0xa03, 0xb12, 0xc30, 0xd21, 0xe11, 0xf00,
+		0x144, 0x055, 0x365, 0x274, 0x556, 0x447, 0x777, 0x666,
+		0x966, 0x877, 0xb47, 0xa56, 0xd74, 0xc65, 0xf55, 0xe44,
+		0x284, 0x395, 0x0a5, 0x1b4, 0x696, 0x787, 0x4b7, 0x5a6,
+		0xaa6, 0xbb7, 0x887, 0x996, 0xeb4, 0xfa5, 0xc95, 0xd84,
+		0x3c0, 0x2d1, 0x1e1, 0x0f0, 0x7d2, 0x6c3, 0x5f3, 0x4e2,
+		0xbe2, 0xaf3, 0x9c3, 0x8d2, 0xff0, 0xee1, 0xdd1, 0xcc0,
+		0x448, 0x559, 0x669, 0x778, 0x05a, 0x14b, 0x27b, 0x36a,
+		0xc6a, 0xd7b, 0xe4b, 0xf5a, 0x878, 0x969, 0xa59, 0xb48,
+		0x50c, 0x41d, 0x72d, 0x63c, 0x11e, 0x00f, 0x33f, 0x22e,
+		0xd2e, 0xc3f, 0xf0f, 0xe1e, 0x93c, 0x82d, 0xb1d, 0xa0c,
+		0x6cc, 0x7dd, 0x4ed, 0x5fc, 0x2de, 0x3cf, 0x0ff, 0x1ee,
+		0xeee, 0xfff, 0xccf, 0xdde, 0xafc, 0xbed, 0x8dd, 0x9cc,
+		0x788, 0x699, 0x5a9, 0x4b8, 0x39a, 0x28b, 0x1bb, 0x0aa,
+		0xfaa, 0xebb, 0xd8b, 0xc9a, 0xbb8, 0xaa9, 0x999, 0x888,
+		0x888, 0x999, 0xaa9, 0xbb8, 0xc9a, 0xd8b, 0xebb, 0xfaa,
+		0x0aa, 0x1bb, 0x28b, 0x39a, 0x4b8, 0x5a9, 0x699, 0x788,
+		0x9cc, 0x8dd, 0xbed, 0xafc, 0xdde, 0xccf, 0xfff, 0xeee,
+		0x1ee, 0x0ff, 0x3cf, 0x2de, 0x5fc, 0x4ed, 0x7dd, 0x6cc,
+		0xa0c, 0xb1d, 0x82d, 0x93c, 0xe1e, 0xf0f, 0xc3f, 0xd2e,
+		0x22e, 0x33f, 0x00f, 0x11e, 0x63c, 0x72d, 0x41d, 0x50c,
+		0xb48, 0xa59, 0x969, 0x878, 0xf5a, 0xe4b, 0xd7b, 0xc6a,
+		0x36a, 0x27b, 0x14b, 0x05a, 0x778, 0x669, 0x559, 0x448,
+		0xcc0, 0xdd1, 0xee1, 0xff0, 0x8d2, 0x9c3, 0xaf3, 0xbe2,
+		0x4e2, 0x5f3, 0x6c3, 0x7d2, 0x0f0, 0x1e1, 0x2d1, 0x3c0,
+		0xd84, 0xc95, 0xfa5, 0xeb4, 0x996, 0x887, 0xbb7, 0xaa6,
+		0x5a6, 0x4b7, 0x787, 0x696, 0x1b4, 0x0a5, 0x395, 0x284,
+		0xe44, 0xf55, 0xc65, 0xd74, 0xa56, 0xb47, 0x877, 0x966,
+		0x666, 0x777, 0x447, 0x556, 0x274, 0x365, 0x055, 0x144,
+		0xf00, 0xe11, 0xd21, 0xc30, 0xb12, 0xa03, 0x933, 0x822,
+		0x722, 0x633, 0x503, 0x412, 0x330, 0x221, 0x111, 0x000
+	};
+
+	/**
+	 * Triangles of every case as triples of edges, terminated by -1
+	 * Faces with two diagonal inside corners always separate them, so neighbouring cells agree on every shared face,
+	 * and no triangle edge lies inside a cell face, so the surface is closed and manifold
+	 */
+	constexpr int8 TriangleTable[256][16] = {
+		{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 0, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{5, 0, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 5, 4, 8, 9, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{4, 1, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 1, 10, 8, 0, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{4, 1, 10, 5, 0, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 1, 10, 8, 5, 1, 8, 9, 5, -1, -1, -1, -1, -1, -1, -1},
+		{11, 1, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 0, 4, 11, 1, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{11, 0, 9, 11, 1, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 1, 4, 8, 11, 1, 8, 9, 11, -1, -1, -1, -1, -1, -1, -1},
+		{4, 11, 10, 4, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 11, 10, 8, 5, 11, 8, 0, 5, -1, -1, -1, -1, -1, -1, -1},
+		{4, 11, 10, 4, 9, 11, 4, 0, 9, -1, -1, -1, -1, -1, -1, -1},
+		{8, 11, 10, 8, 9, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 2, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 0, 4, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 2, 8, 5, 0, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 5, 4, 6, 9, 5, 6, 2, 9, -1, -1, -1, -1, -1, -1, -1},
+		{6, 2, 8, 4, 1, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 1, 10, 6, 0, 1, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1},
+		{6, 2, 8, 4, 1, 10, 5, 0, 9, -1, -1, -1, -1, -1, -1, -1},
+		{6, 1, 10, 6, 5, 1, 6, 9, 5, 6, 2, 9, -1, -1, -1, -1},
+		{6, 2, 8, 11, 1, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 0, 4, 6, 2, 0, 11, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+		{6, 2, 8, 11, 0, 9, 11, 1, 0, -1, -1, -1, -1, -1, -1, -1},
+		{6, 1, 4, 6, 11, 1, 6, 9, 11, 6, 2, 9, -1, -1, -1, -1},
+		{6, 2, 8, 4, 11, 10, 4, 5, 11, -1, -1, -1, -1, -1, -1, -1},
+		{6, 11, 10, 6, 5, 11, 6, 0, 5, 6, 2, 0, -1, -1, -1, -1},
+		{6, 2, 8, 4, 11, 10, 4, 9, 11, 4, 0, 9, -1, -1, -1, -1},
+		{6, 11, 10, 6, 9, 11, 6, 2, 9, -1, -1, -1, -1, -1, -1, -1},
+		{9, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 0, 4, 9, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{5, 2, 7, 5, 0, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 5, 4, 8, 7, 5, 8, 2, 7, -1, -1, -1, -1, -1, -1, -1},
+		{4, 1, 10, 9, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 1, 10, 8, 0, 1, 9, 2, 7, -1, -1, -1, -1, -1, -1, -1},
+		{4, 1, 10, 5, 2, 7, 5, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+		{8, 1, 10, 8, 5, 1, 8, 7, 5, 8, 2, 7, -1, -1, -1, -1},
+		{11, 1, 5, 9, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 0, 4, 11, 1, 5, 9, 2, 7, -1, -1, -1, -1, -1, -1, -1},
+		{11, 2, 7, 11, 0, 2, 11, 1, 0, -1, -1, -1, -1, -1, -1, -1},
+		{8, 1, 4, 8, 11, 1, 8, 7, 11, 8, 2, 7, -1, -1, -1, -1},
+		{4, 11, 10, 4, 5, 11, 9, 2, 7, -1, -1, -1, -1, -1, -1, -1},
+		{8, 11, 10, 8, 5, 11, 8, 0, 5, 9, 2, 7, -1, -1, -1, -1},
+		{4, 11, 10, 4, 7, 11, 4, 2, 7, 4, 0, 2, -1, -1, -1, -1},
+		{8, 11, 10, 8, 7, 11, 8, 2, 7, -1, -1, -1, -1, -1, -1, -1},
+		{6, 9, 8, 6, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 0, 4, 6, 9, 0, 6, 7, 9, -1, -1, -1, -1, -1, -1, -1},
+		{6, 0, 8, 6, 5, 0, 6, 7, 5, -1, -1, -1, -1, -1, -1, -1},
+		{6, 5, 4, 6, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 9, 8, 6, 7, 9, 4, 1, 10, -1, -1, -1, -1, -1, -1, -1},
+		{6, 1, 10, 6, 0, 1, 6, 9, 0, 6, 7, 9, -1, -1, -1, -1},
+		{6, 0, 8, 6, 5, 0, 6, 7, 5, 4, 1, 10, -1, -1, -1, -1},
+		{6, 1, 10, 6, 5, 1, 6, 7, 5, -1, -1, -1, -1, -1, -1, -1},
+		{6, 9, 8, 6, 7, 9, 11, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+		{6, 0, 4, 6, 9, 0, 6, 7, 9, 11, 1, 5, -1, -1, -1, -1},
+		{6, 0, 8, 6, 1, 0, 6, 11, 1, 6, 7, 11, -1, -1, -1, -1},
+		{6, 1, 4, 6, 11, 1, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1},
+		{6, 9, 8, 6, 7, 9, 4, 11, 10, 4, 5, 11, -1, -1, -1, -1},
+		{6, 11, 10, 6, 5, 11, 6, 0, 5, 6, 9, 0, 6, 7, 9, -1},
+		{0, 10, 4, 0, 11, 10, 0, 7, 11, 0, 6, 7, 0, 8, 6, -1},
+		{6, 11, 10, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, 8, 0, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, 5, 0, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, 8, 5, 4, 8, 9, 5, -1, -1, -1, -1, -1, -1, -1},
+		{4, 3, 6, 4, 1, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 3, 6, 8, 1, 3, 8, 0, 1, -1, -1, -1, -1, -1, -1, -1},
+		{4, 3, 6, 4, 1, 3, 5, 0, 9, -1, -1, -1, -1, -1, -1, -1},
+		{8, 3, 6, 8, 1, 3, 8, 5, 1, 8, 9, 5, -1, -1, -1, -1},
+		{10, 3, 6, 11, 1, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, 8, 0, 4, 11, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, 11, 0, 9, 11, 1, 0, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, 8, 1, 4, 8, 11, 1, 8, 9, 11, -1, -1, -1, -1},
+		{4, 3, 6, 4, 11, 3, 4, 5, 11, -1, -1, -1, -1, -1, -1, -1},
+		{8, 3, 6, 8, 11, 3, 8, 5, 11, 8, 0, 5, -1, -1, -1, -1},
+		{4, 3, 6, 4, 11, 3, 4, 9, 11, 4, 0, 9, -1, -1, -1, -1},
+		{8, 3, 6, 8, 11, 3, 8, 9, 11, -1, -1, -1, -1, -1, -1, -1},
+		{10, 2, 8, 10, 3, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 0, 4, 10, 2, 0, 10, 3, 2, -1, -1, -1, -1, -1, -1, -1},
+		{10, 2, 8, 10, 3, 2, 5, 0, 9, -1, -1, -1, -1, -1, -1, -1},
+		{10, 5, 4, 10, 9, 5, 10, 2, 9, 10, 3, 2, -1, -1, -1, -1},
+		{4, 2, 8, 4, 3, 2, 4, 1, 3, -1, -1, -1, -1, -1, -1, -1},
+		{0, 3, 2, 0, 1, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{4, 2, 8, 4, 3, 2, 4, 1, 3, 5, 0, 9, -1, -1, -1, -1},
+		{5, 2, 9, 5, 3, 2, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1},
+		{10, 2, 8, 10, 3, 2, 11, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+		{10, 0, 4, 10, 2, 0, 10, 3, 2, 11, 1, 5, -1, -1, -1, -1},
+		{10, 2, 8, 10, 3, 2, 11, 0, 9, 11, 1, 0, -1, -1, -1, -1},
+		{4, 11, 1, 4, 9, 11, 4, 2, 9, 4, 3, 2, 4, 10, 3, -1},
+		{4, 2, 8, 4, 3, 2, 4, 11, 3, 4, 5, 11, -1, -1, -1, -1},
+		{11, 0, 5, 11, 2, 0, 11, 3, 2, -1, -1, -1, -1, -1, -1, -1},
+		{4, 2, 8, 4, 3, 2, 4, 11, 3, 4, 9, 11, 4, 0, 9, -1},
+		{11, 2, 9, 11, 3, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, 9, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, 8, 0, 4, 9, 2, 7, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, 5, 2, 7, 5, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, 8, 5, 4, 8, 7, 5, 8, 2, 7, -1, -1, -1, -1},
+		{4, 3, 6, 4, 1, 3, 9, 2, 7, -1, -1, -1, -1, -1, -1, -1},
+		{8, 3, 6, 8, 1, 3, 8, 0, 1, 9, 2, 7, -1, -1, -1, -1},
+		{4, 3, 6, 4, 1, 3, 5, 2, 7, 5, 0, 2, -1, -1, -1, -1},
+		{8, 3, 6, 8, 1, 3, 8, 5, 1, 8, 7, 5, 8, 2, 7, -1},
+		{10, 3, 6, 11, 1, 5, 9, 2, 7, -1, -1, -1, -1, -1, -1, -1},
+		{10, 3, 6, 8, 0, 4, 11, 1, 5, 9, 2, 7, -1, -1, -1, -1},
+		{10, 3, 6, 11, 2, 7, 11, 0, 2, 11, 1, 0, -1, -1, -1, -1},
+		{10, 3, 6, 8, 1, 4, 8, 11, 1, 8, 7, 11, 8, 2, 7, -1},
+		{4, 3, 6, 4, 11, 3, 4, 5, 11, 9, 2, 7, -1, -1, -1, -1},
+		{8, 3, 6, 8, 11, 3, 8, 5, 11, 8, 0, 5, 9, 2, 7, -1},
+		{4, 3, 6, 4, 11, 3, 4, 7, 11, 4, 2, 7, 4, 0, 2, -1},
+		{8, 3, 6, 8, 11, 3, 8, 7, 11, 8, 2, 7, -1, -1, -1, -1},
+		{10, 9, 8, 10, 7, 9, 10, 3, 7, -1, -1, -1, -1, -1, -1, -1},
+		{10, 0, 4, 10, 9, 0, 10, 7, 9, 10, 3, 7, -1, -1, -1, -1},
+		{10, 0, 8, 10, 5, 0, 10, 7, 5, 10, 3, 7, -1, -1, -1, -1},
+		{10, 5, 4, 10, 7, 5, 10, 3, 7, -1, -1, -1, -1, -1, -1, -1},
+		{4, 9, 8, 4, 7, 9, 4, 3, 7, 4, 1, 3, -1, -1, -1, -1},
+		{9, 3, 7, 9, 1, 3, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 5, 0, 8, 7, 5, 8, 3, 7, 8, 1, 3, 8, 4, 1, -1},
+		{5, 3, 7, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 9, 8, 10, 7, 9, 10, 3, 7, 11, 1, 5, -1, -1, -1, -1},
+		{10, 0, 4, 10, 9, 0, 10, 7, 9, 10, 3, 7, 11, 1, 5, -1},
+		{8, 1, 0, 8, 11, 1, 8, 7, 11, 8, 3, 7, 8, 10, 3, -1},
+		{4, 11, 1, 4, 7, 11, 4, 3, 7, 4, 10, 3, -1, -1, -1, -1},
+		{4, 9, 8, 4, 7, 9, 4, 3, 7, 4, 11, 3, 4, 5, 11, -1},
+		{0, 7, 9, 0, 3, 7, 0, 11, 3, 0, 5, 11, -1, -1, -1, -1},
+		{4, 0, 8, 11, 3, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{11, 3, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{7, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 0, 4, 7, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{5, 0, 9, 7, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 5, 4, 8, 9, 5, 7, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+		{4, 1, 10, 7, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 1, 10, 8, 0, 1, 7, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+		{4, 1, 10, 5, 0, 9, 7, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+		{8, 1, 10, 8, 5, 1, 8, 9, 5, 7, 3, 11, -1, -1, -1, -1},
+		{7, 1, 5, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 0, 4, 7, 1, 5, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+		{7, 0, 9, 7, 1, 0, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 1, 4, 8, 3, 1, 8, 7, 3, 8, 9, 7, -1, -1, -1, -1},
+		{4, 3, 10, 4, 7, 3, 4, 5, 7, -1, -1, -1, -1, -1, -1, -1},
+		{8, 3, 10, 8, 7, 3, 8, 5, 7, 8, 0, 5, -1, -1, -1, -1},
+		{4, 3, 10, 4, 7, 3, 4, 9, 7, 4, 0, 9, -1, -1, -1, -1},
+		{8, 3, 10, 8, 7, 3, 8, 9, 7, -1, -1, -1, -1, -1, -1, -1},
+		{6, 2, 8, 7, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 0, 4, 6, 2, 0, 7, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+		{6, 2, 8, 5, 0, 9, 7, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+		{6, 5, 4, 6, 9, 5, 6, 2, 9, 7, 3, 11, -1, -1, -1, -1},
+		{6, 2, 8, 4, 1, 10, 7, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+		{6, 1, 10, 6, 0, 1, 6, 2, 0, 7, 3, 11, -1, -1, -1, -1},
+		{6, 2, 8, 4, 1, 10, 5, 0, 9, 7, 3, 11, -1, -1, -1, -1},
+		{6, 1, 10, 6, 5, 1, 6, 9, 5, 6, 2, 9, 7, 3, 11, -1},
+		{6, 2, 8, 7, 1, 5, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 0, 4, 6, 2, 0, 7, 1, 5, 7, 3, 1, -1, -1, -1, -1},
+		{6, 2, 8, 7, 0, 9, 7, 1, 0, 7, 3, 1, -1, -1, -1, -1},
+		{4, 3, 1, 4, 7, 3, 4, 9, 7, 4, 2, 9, 4, 6, 2, -1},
+		{6, 2, 8, 4, 3, 10, 4, 7, 3, 4, 5, 7, -1, -1, -1, -1},
+		{10, 7, 3, 10, 5, 7, 10, 0, 5, 10, 2, 0, 10, 6, 2, -1},
+		{6, 2, 8, 4, 3, 10, 4, 7, 3, 4, 9, 7, 4, 0, 9, -1},
+		{10, 7, 3, 10, 9, 7, 10, 2, 9, 10, 6, 2, -1, -1, -1, -1},
+		{9, 3, 11, 9, 2, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 0, 4, 9, 3, 11, 9, 2, 3, -1, -1, -1, -1, -1, -1, -1},
+		{5, 3, 11, 5, 2, 3, 5, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+		{8, 5, 4, 8, 11, 5, 8, 3, 11, 8, 2, 3, -1, -1, -1, -1},
+		{4, 1, 10, 9, 3, 11, 9, 2, 3, -1, -1, -1, -1, -1, -1, -1},
+		{8, 1, 10, 8, 0, 1, 9, 3, 11, 9, 2, 3, -1, -1, -1, -1},
+		{4, 1, 10, 5, 3, 11, 5, 2, 3, 5, 0, 2, -1, -1, -1, -1},
+		{8, 1, 10, 8, 5, 1, 8, 11, 5, 8, 3, 11, 8, 2, 3, -1},
+		{9, 1, 5, 9, 3, 1, 9, 2, 3, -1, -1, -1, -1, -1, -1, -1},
+		{8, 0, 4, 9, 1, 5, 9, 3, 1, 9, 2, 3, -1, -1, -1, -1},
+		{2, 1, 0, 2, 3, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 1, 4, 8, 3, 1, 8, 2, 3, -1, -1, -1, -1, -1, -1, -1},
+		{4, 3, 10, 4, 2, 3, 4, 9, 2, 4, 5, 9, -1, -1, -1, -1},
+		{10, 2, 3, 10, 9, 2, 10, 5, 9, 10, 0, 5, 10, 8, 0, -1},
+		{4, 3, 10, 4, 2, 3, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+		{8, 3, 10, 8, 2, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 9, 8, 6, 11, 9, 6, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+		{6, 0, 4, 6, 9, 0, 6, 11, 9, 6, 3, 11, -1, -1, -1, -1},
+		{6, 0, 8, 6, 5, 0, 6, 11, 5, 6, 3, 11, -1, -1, -1, -1},
+		{6, 5, 4, 6, 11, 5, 6, 3, 11, -1, -1, -1, -1, -1, -1, -1},
+		{6, 9, 8, 6, 11, 9, 6, 3, 11, 4, 1, 10, -1, -1, -1, -1},
+		{6, 1, 10, 6, 0, 1, 6, 9, 0, 6, 11, 9, 6, 3, 11, -1},
+		{6, 0, 8, 6, 5, 0, 6, 11, 5, 6, 3, 11, 4, 1, 10, -1},
+		{6, 1, 10, 6, 5, 1, 6, 11, 5, 6, 3, 11, -1, -1, -1, -1},
+		{6, 9, 8, 6, 5, 9, 6, 1, 5, 6, 3, 1, -1, -1, -1, -1},
+		{6, 0, 4, 6, 9, 0, 6, 5, 9, 6, 1, 5, 6, 3, 1, -1},
+		{6, 0, 8, 6, 1, 0, 6, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+		{6, 1, 4, 6, 3, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{9, 4, 5, 9, 10, 4, 9, 3, 10, 9, 6, 3, 9, 8, 6, -1},
+		{6, 3, 10, 9, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{0, 10, 4, 0, 3, 10, 0, 6, 3, 0, 8, 6, -1, -1, -1, -1},
+		{6, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 7, 6, 10, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 7, 6, 10, 11, 7, 8, 0, 4, -1, -1, -1, -1, -1, -1, -1},
+		{10, 7, 6, 10, 11, 7, 5, 0, 9, -1, -1, -1, -1, -1, -1, -1},
+		{10, 7, 6, 10, 11, 7, 8, 5, 4, 8, 9, 5, -1, -1, -1, -1},
+		{4, 7, 6, 4, 11, 7, 4, 1, 11, -1, -1, -1, -1, -1, -1, -1},
+		{8, 7, 6, 8, 11, 7, 8, 1, 11, 8, 0, 1, -1, -1, -1, -1},
+		{4, 7, 6, 4, 11, 7, 4, 1, 11, 5, 0, 9, -1, -1, -1, -1},
+		{8, 7, 6, 8, 11, 7, 8, 1, 11, 8, 5, 1, 8, 9, 5, -1},
+		{10, 7, 6, 10, 5, 7, 10, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+		{10, 7, 6, 10, 5, 7, 10, 1, 5, 8, 0, 4, -1, -1, -1, -1},
+		{10, 7, 6, 10, 9, 7, 10, 0, 9, 10, 1, 0, -1, -1, -1, -1},
+		{7, 8, 9, 7, 4, 8, 7, 1, 4, 7, 10, 1, 7, 6, 10, -1},
+		{4, 7, 6, 4, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 7, 6, 8, 5, 7, 8, 0, 5, -1, -1, -1, -1, -1, -1, -1},
+		{4, 7, 6, 4, 9, 7, 4, 0, 9, -1, -1, -1, -1, -1, -1, -1},
+		{8, 7, 6, 8, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 2, 8, 10, 7, 2, 10, 11, 7, -1, -1, -1, -1, -1, -1, -1},
+		{10, 0, 4, 10, 2, 0, 10, 7, 2, 10, 11, 7, -1, -1, -1, -1},
+		{10, 2, 8, 10, 7, 2, 10, 11, 7, 5, 0, 9, -1, -1, -1, -1},
+		{10, 5, 4, 10, 9, 5, 10, 2, 9, 10, 7, 2, 10, 11, 7, -1},
+		{4, 2, 8, 4, 7, 2, 4, 11, 7, 4, 1, 11, -1, -1, -1, -1},
+		{7, 1, 11, 7, 0, 1, 7, 2, 0, -1, -1, -1, -1, -1, -1, -1},
+		{4, 2, 8, 4, 7, 2, 4, 11, 7, 4, 1, 11, 5, 0, 9, -1},
+		{2, 11, 7, 2, 1, 11, 2, 5, 1, 2, 9, 5, -1, -1, -1, -1},
+		{10, 2, 8, 10, 7, 2, 10, 5, 7, 10, 1, 5, -1, -1, -1, -1},
+		{10, 0, 4, 10, 2, 0, 10, 7, 2, 10, 5, 7, 10, 1, 5, -1},
+		{10, 2, 8, 10, 7, 2, 10, 9, 7, 10, 0, 9, 10, 1, 0, -1},
+		{10, 1, 4, 7, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{4, 2, 8, 4, 7, 2, 4, 5, 7, -1, -1, -1, -1, -1, -1, -1},
+		{7, 0, 5, 7, 2, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{4, 2, 8, 4, 7, 2, 4, 9, 7, 4, 0, 9, -1, -1, -1, -1},
+		{7, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 2, 6, 10, 9, 2, 10, 11, 9, -1, -1, -1, -1, -1, -1, -1},
+		{10, 2, 6, 10, 9, 2, 10, 11, 9, 8, 0, 4, -1, -1, -1, -1},
+		{10, 2, 6, 10, 0, 2, 10, 5, 0, 10, 11, 5, -1, -1, -1, -1},
+		{2, 4, 8, 2, 5, 4, 2, 11, 5, 2, 10, 11, 2, 6, 10, -1},
+		{4, 2, 6, 4, 9, 2, 4, 11, 9, 4, 1, 11, -1, -1, -1, -1},
+		{6, 9, 2, 6, 11, 9, 6, 1, 11, 6, 0, 1, 6, 8, 0, -1},
+		{6, 0, 2, 6, 5, 0, 6, 11, 5, 6, 1, 11, 6, 4, 1, -1},
+		{8, 2, 6, 5, 1, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 2, 6, 10, 9, 2, 10, 5, 9, 10, 1, 5, -1, -1, -1, -1},
+		{10, 2, 6, 10, 9, 2, 10, 5, 9, 10, 1, 5, 8, 0, 4, -1},
+		{10, 2, 6, 10, 0, 2, 10, 1, 0, -1, -1, -1, -1, -1, -1, -1},
+		{2, 4, 8, 2, 1, 4, 2, 10, 1, 2, 6, 10, -1, -1, -1, -1},
+		{4, 2, 6, 4, 9, 2, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1},
+		{6, 9, 2, 6, 5, 9, 6, 0, 5, 6, 8, 0, -1, -1, -1, -1},
+		{4, 2, 6, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 9, 8, 10, 11, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 0, 4, 10, 9, 0, 10, 11, 9, -1, -1, -1, -1, -1, -1, -1},
+		{10, 0, 8, 10, 5, 0, 10, 11, 5, -1, -1, -1, -1, -1, -1, -1},
+		{10, 5, 4, 10, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{4, 9, 8, 4, 11, 9, 4, 1, 11, -1, -1, -1, -1, -1, -1, -1},
+		{9, 1, 11, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{8, 5, 0, 8, 11, 5, 8, 1, 11, 8, 4, 1, -1, -1, -1, -1},
+		{5, 1, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 9, 8, 10, 5, 9, 10, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+		{10, 0, 4, 10, 9, 0, 10, 5, 9, 10, 1, 5, -1, -1, -1, -1},
+		{10, 0, 8, 10, 1, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{10, 1, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{4, 9, 8, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{9, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{4, 0, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+		{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}
+	};
+
+	FORCEINLINE FIntVector GetCornerOffset(const int32 Corner)
+	{
+		return FIntVector(Corner & 1, (Corner >> 1) & 1, (Corner >> 2) & 1);
+	}
+
+	/**
+	 * Values of a chunk's cells and a margin around them, sampled once per chunk
+	 */
+	struct FSampleBlock
+	{
+		FIntVector Min = FIntVector::ZeroValue;
+		FIntVector Size = FIntVector::ZeroValue;
+		TArray<float> Values;
+
+		FSampleBlock(const FVoxelGrid& Grid, const FVoxelBox& Box, TFunctionRef<float(const FIntVector&)> Sample)
+			: Min(Box.Min), Size(Box.GetSize())
+		{
+			Values.SetNumUninitialized(Box.Num());
+
+			const FVoxelBox GridBox = Grid.GetVoxelBox();
+			int32 Index = 0;
+
+			Box.ForEach([&](const FIntVector& Coordinate)
+			{
+				Values[Index++] = GridBox.Contains(Coordinate) ? Sample(Coordinate) : 0.0f;
+			});
+		}
+
+		FORCEINLINE float Get(const FIntVector& Coordinate) const
+		{
+			const FIntVector Local = Coordinate - Min;
+			checkSlow(Local.X >= 0 && Local.X < Size.X && Local.Y >= 0 && Local.Y < Size.Y && Local.Z >= 0 && Local.Z < Size.Z);
+
+			return Values[Local.X + (Local.Y + Local.Z * Size.Y) * Size.X];
+		}
+
+		// Direction the values decrease in, which points out of the solid
+		FORCEINLINE FVector GetOutward(const FIntVector& Coordinate) const
+		{
+			return FVector(
+				Get(Coordinate - FIntVector(1, 0, 0)) - Get(Coordinate + FIntVector(1, 0, 0)),
+				Get(Coordinate - FIntVector(0, 1, 0)) - Get(Coordinate + FIntVector(0, 1, 0)),
+				Get(Coordinate - FIntVector(0, 0, 1)) - Get(Coordinate + FIntVector(0, 0, 1)));
+		}
+	};
+
+	/**
+	 * Where the surface crosses a lattice edge
+	 */
+	struct FEdgeCrossing
+	{
+		// Location in lattice units, voxel centers are at whole numbers
+		FVector Location;
+		FVector Normal;
+	};
+
+	/**
+	 * Gets where the surface crosses the edge from a lattice point to its next point along an axis
+	 * Only the edge's own values are used, so both chunks sharing an edge get the exact same crossing
+	 */
+	FEdgeCrossing GetEdgeCrossing(const FSampleBlock& Block, const FIntVector& Start, const int32 Axis, const float IsoValue)
+	{
+		FIntVector End = Start;
+		End[Axis]++;
+
+		const float StartValue = Block.Get(Start);
+		const float EndValue = Block.Get(End);
+		const double Alpha = FMath::Clamp((IsoValue - StartValue) / (EndValue - StartValue), 0.0f, 1.0f);
+
+		FEdgeCrossing Crossing;
+		Crossing.Location = FVector(Start);
+		Crossing.Location[Axis] += Alpha;
+		Crossing.Normal = FMath::Lerp(Block.GetOutward(Start), Block.GetOutward(End), Alpha).GetSafeNormal();
+
+		return Crossing;
+	}
+
+	/**
+	 * Quadratic error function of the planes through a cell's edge crossings
+	 */
+	struct FQef
+	{
+		// Upper triangle of A^T A: XX, XY, XZ, YY, YZ, ZZ
+		double AtA[6] = {};
+		FVector AtB = FVector::ZeroVector;
+		FVector MassPoint = FVector::ZeroVector;
+		int32 Count = 0;
+
+		void Add(const FVector& Location, const FVector& Normal)
+		{
+			AtA[0] += Normal.X * Normal.X;
+			AtA[1] += Normal.X * Normal.Y;
+			AtA[2] += Normal.X * Normal.Z;
+			AtA[3] += Normal.Y * Normal.Y;
+			AtA[4] += Normal.Y * Normal.Z;
+			AtA[5] += Normal.Z * Normal.Z;
+			AtB += Normal * Normal.Dot(Location);
+			MassPoint += Location;
+			Count++;
+		}
+
+		/**
+		 * Minimizes the error around the mass point with a truncated pseudo inverse
+		 * Directions the planes don't constrain, like along a crease, stay at the mass point
+		 */
+		FVector Solve(const double SingularThreshold) const
+		{
+			const FVector Center = MassPoint / FMath::Max(Count, 1);
+
+			double Matrix[3][3] = {
+				{AtA[0], AtA[1], AtA[2]},
+				{AtA[1], AtA[3], AtA[4]},
+				{AtA[2], AtA[4], AtA[5]}
+			};
+			double Vectors[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+			const FVector Rhs = AtB - FVector(
+				Matrix[0][0] * Center.X + Matrix[0][1] * Center.Y + Matrix[0][2] * Center.Z,
+				Matrix[1][0] * Center.X + Matrix[1][1] * Center.Y + Matrix[1][2] * Center.Z,
+				Matrix[2][0] * Center.X + Matrix[2][1] * Center.Y + Matrix[2][2] * Center.Z);
+
+			// Cyclic Jacobi rotations, a few sweeps are plenty for a 3x3 symmetric matrix
+			for(int32 Sweep = 0; Sweep < 6; Sweep++)
+			{
+				for(int32 P = 0; P < 2; P++)
+				{
+					for(int32 Q = P + 1; Q < 3; Q++)
+					{
+						if(FMath::Abs(Matrix[P][Q]) < UE_DOUBLE_SMALL_NUMBER)
+						{
+							continue;
+						}
+
+						const double Theta = (Matrix[Q][Q] - Matrix[P][P]) / (2.0 * Matrix[P][Q]);
+						const double T = FMath::Sign(Theta) / (FMath::Abs(Theta) + FMath::Sqrt(Theta * Theta + 1.0)) + (Theta == 0.0 ? 1.0 : 0.0);
+						const double C = 1.0 / FMath::Sqrt(T * T + 1.0);
+						const double S = T * C;
+
+						for(int32 K = 0; K < 3; K++)
+						{
+							const double MKP = Matrix[K][P];
+							const double MKQ = Matrix[K][Q];
+							Matrix[K][P] = C * MKP - S * MKQ;
+							Matrix[K][Q] = S * MKP + C * MKQ;
+						}
+
+						for(int32 K = 0; K < 3; K++)
+						{
+							const double MPK = Matrix[P][K];
+							const double MQK = Matrix[Q][K];
+							Matrix[P][K] = C * MPK - S * MQK;
+							Matrix[Q][K] = S * MPK + C * MQK;
+						}
+
+						for(int32 K = 0; K < 3; K++)
+						{
+							const double VKP = Vectors[K][P];
+							const double VKQ = Vectors[K][Q];
+							Vectors[K][P] = C * VKP - S * VKQ;
+							Vectors[K][Q] = S * VKP + C * VKQ;
+						}
+					}
+				}
+			}
+
+			const double MaxEigenvalue = FMath::Max3(FMath::Abs(Matrix[0][0]), FMath::Abs(Matrix[1][1]), FMath::Abs(Matrix[2][2]));
+			FVector Offset = FVector::ZeroVector;
+
+			for(int32 Eigen = 0; Eigen < 3; Eigen++)
+			{
+				const double Eigenvalue = Matrix[Eigen][Eigen];
+
+				if(Eigenvalue <= SingularThreshold * MaxEigenvalue || Eigenvalue < UE_DOUBLE_SMALL_NUMBER)
+				{
+					continue;
+				}
+
+				const FVector Axis(Vectors[0][Eigen], Vectors[1][Eigen], Vectors[2][Eigen]);
+				Offset += Axis * (Axis.Dot(Rhs) / Eigenvalue);
+			}
+
+			return Center + Offset;
+		}
+	};
+
+	/**
+	 * Builds a chunk's mesh in lattice space, vertices are converted to world space at the end
+	 */
+	struct FMeshBuilder
+	{
+		FVoxelSurfaceMesh& Mesh;
+		const FVector Origin;
+		const FVector VoxelSize;
+
+		int32 AddVertex(const FVector& Location, const FVector& Normal)
+		{
+			Mesh.Normals.Add(FVector3f((Normal / VoxelSize).GetSafeNormal()));
+
+			return Mesh.Positions.Add(Origin + Location * VoxelSize);
+		}
+
+		void AddTriangle(const int32 A, const int32 B, const int32 C)
+		{
+			Mesh.Indices.Add(A);
+			Mesh.Indices.Add(B);
+			Mesh.Indices.Add(C);
+		}
+	};
+
+	/**
+	 * Marching cubes over a chunk's cells, slice by slice along Z
+	 * Every cell owns the three edges leaving its first corner, their vertices are cached for the slice's two planes of
+	 * lattice points, so each vertex is created once and shared by up to four cells
+	 */
+	void MarchCells(const FSampleBlock& Block, const FVoxelBox& Cells, const float IsoValue, FMeshBuilder& Builder)
+	{
+		const FIntVector PlaneSize = Cells.GetSize() + FIntVector(1);
+
+		TArray<int32> Planes[2];
+		Planes[0].Init(INDEX_NONE, PlaneSize.X * PlaneSize.Y * 3);
+		Planes[1].Init(INDEX_NONE, PlaneSize.X * PlaneSize.Y * 3);
+
+		for(int32 Z = Cells.Min.Z; Z < Cells.Max.Z; Z++)
+		{
+			// The plane above this slice was two slices ago's lower plane
+			TArray<int32>& Lower = Planes[(Z - Cells.Min.Z) & 1];
+			TArray<int32>& Upper = Planes[(Z - Cells.Min.Z + 1) & 1];
+
+			for(int32& Vertex : Upper)
+			{
+				Vertex = INDEX_NONE;
+			}
+
+			auto GetEdgeVertex = [&](const FIntVector& Start, const int32 Axis)
+			{
+				TArray<int32>& Plane = Start.Z == Z ? Lower : Upper;
+				int32& Vertex = Plane[((Start.X - Cells.Min.X) + (Start.Y - Cells.Min.Y) * PlaneSize.X) * 3 + Axis];
+
+				if(Vertex == INDEX_NONE)
+				{
+					const FEdgeCrossing Crossing = GetEdgeCrossing(Block, Start, Axis, IsoValue);
+					Vertex = Builder.AddVertex(Crossing.Location, Crossing.Normal);
+				}
+
+				return Vertex;
+			};
+
+			for(int32 Y = Cells.Min.Y; Y < Cells.Max.Y; Y++)
+			{
+				for(int32 X = Cells.Min.X; X < Cells.Max.X; X++)
+				{
+					const FIntVector Cell(X, Y, Z);
+
+					int32 Case = 0;
+
+					for(int32 Corner = 0; Corner < 8; Corner++)
+					{
+						Case |= Block.Get(Cell + GetCornerOffset(Corner)) >= IsoValue ? 1 << Corner : 0;
+					}
+
+					if(EdgeTable[Case] == 0)
+					{
+						continue;
+					}
+
+					int32 Vertices[12];
+
+					for(int32 Edge = 0; Edge < 12; Edge++)
+					{
+						if(EdgeTable[Case] & (1 << Edge))
+						{
+							Vertices[Edge] = GetEdgeVertex(Cell + GetCornerOffset(EdgeCorners[Edge][0]), Edge >> 2);
+						}
+					}
+
+					for(int32 Index = 0; TriangleTable[Case][Index] != -1; Index += 3)
+					{
+						Builder.AddTriangle(Vertices[TriangleTable[Case][Index]], Vertices[TriangleTable[Case][Index + 1]], Vertices[TriangleTable[Case][Index + 2]]);
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * Dual contouring over a chunk's edges, every crossed edge joins the vertices of the four cells around it
+	 * Cell vertices are created on first use, including the cells of the margin before the chunk, which neighbouring
+	 * chunks compute the same way
+	 */
+	void ContourEdges(const FSampleBlock& Block, const FVoxelBox& Cells, const float IsoValue, const double SingularThreshold, FMeshBuilder& Builder)
+	{
+		// Cells before the chunk share edges with it, so vertices are needed from one cell earlier on every axis
+		const FVoxelBox VertexCells(Cells.Min - FIntVector(1), Cells.Max);
+		const FIntVector VertexSize = VertexCells.GetSize();
+
+		TArray<int32> CellVertices;
+		CellVertices.Init(INDEX_NONE, VertexCells.Num());
+
+		auto GetCellVertex = [&](const FIntVector& Cell)
+		{
+			const FIntVector Local = Cell - VertexCells.Min;
+			int32& Vertex = CellVertices[Local.X + (Local.Y + Local.Z * VertexSize.Y) * VertexSize.X];
+
+			if(Vertex != INDEX_NONE)
+			{
+				return Vertex;
+			}
+
+			int32 Case = 0;
+
+			for(int32 Corner = 0; Corner < 8; Corner++)
+			{
+				Case |= Block.Get(Cell + GetCornerOffset(Corner)) >= IsoValue ? 1 << Corner : 0;
+			}
+
+			FQef Qef;
+			FVector Normal = FVector::ZeroVector;
+
+			for(int32 Edge = 0; Edge < 12; Edge++)
+			{
+				if(EdgeTable[Case] & (1 << Edge))
+				{
+					const FEdgeCrossing Crossing = GetEdgeCrossing(Block, Cell + GetCornerOffset(EdgeCorners[Edge][0]), Edge >> 2, IsoValue);
+					Qef.Add(Crossing.Location - FVector(Cell), Crossing.Normal);
+					Normal += Crossing.Normal;
+				}
+			}
+
+			// Keep the vertex inside its cell, the QEF can overshoot where the planes are nearly parallel
+			const FVector Location = FVector(Cell) + Qef.Solve(SingularThreshold).BoundToBox(FVector::ZeroVector, FVector::OneVector);
+
+			Vertex = Builder.AddVertex(Location, Normal);
+
+			return Vertex;
+		};
+
+		for(int32 Axis = 0; Axis < 3; Axis++)
+		{
+			const int32 AxisB = (Axis + 1) % 3;
+			const int32 AxisC = (Axis + 2) % 3;
+
+			FIntVector StepB = FIntVector::ZeroValue;
+			FIntVector StepC = FIntVector::ZeroValue;
+			StepB[AxisB] = 1;
+			StepC[AxisC] = 1;
+
+			Cells.ForEach([&](const FIntVector& Start)
+			{
+				// Edges on the grid's low border only touch outside voxels, which are empty
+				if(Start[AxisB] < 0 || Start[AxisC] < 0)
+				{
+					return;
+				}
+
+				FIntVector End = Start;
+				End[Axis]++;
+
+				const bool bStartInside = Block.Get(Start) >= IsoValue;
+
+				if(bStartInside == (Block.Get(End) >= IsoValue))
+				{
+					return;
+				}
+
+				// Counter clockwise around the axis, which faces along it, so flip when the inside is at the end
+				const int32 Quad[4] = {
+					GetCellVertex(Start),
+					GetCellVertex(Start - StepB),
+					GetCellVertex(Start - StepB - StepC),
+					GetCellVertex(Start - StepC)
+				};
+
+				if(bStartInside)
+				{
+					Builder.AddTriangle(Quad[0], Quad[1], Quad[2]);
+					Builder.AddTriangle(Quad[0], Quad[2], Quad[3]);
+				}
+				else
+				{
+					Builder.AddTriangle(Quad[0], Quad[2], Quad[1]);
+					Builder.AddTriangle(Quad[0], Quad[3], Quad[2]);
+				}
+			});
+		}
+	}
+}
+
+/**
+ * Checks if the mesh has no triangles
+ * @return true if the mesh is empty
+ */
+bool FVoxelSurfaceMesh::IsEmpty() const
+{
+	return Indices.Num() == 0;
+}
+
+int32 FVoxelSurfaceMesh::NumTriangles() const
+{
+	return Indices.Num() / 3;
+}
+
+/**
+ * Gets the indices as 16 bit indices, halving the index buffer of all but the densest chunks
+ * @param OutIndices The indices
+ * @return false if the mesh has too many vertices for 16 bit indices
+ */
+bool FVoxelSurfaceMesh::GetCompactIndices(TArray<uint16>& OutIndices) const
+{
+	OutIndices.Reset();
+
+	if(Positions.Num() > TNumericLimits<uint16>::Max() + 1)
+	{
+		return false;
+	}
+
+	OutIndices.SetNumUninitialized(Indices.Num());
+
+	for(int32 Index = 0; Index < Indices.Num(); Index++)
+	{
+		OutIndices[Index] = static_cast<uint16>(Indices[Index]);
+	}
+
+	return true;
+}
+
+/**
+ * Struct constructor
+ * @param InMethod How the surface is placed inside each cell
+ * @param InIsoValue Values at or above this are inside
+ */
+FVoxelSurfaceExtractor::FVoxelSurfaceExtractor(const EVoxelSurfaceMethod InMethod, const float InIsoValue)
+	: Method(InMethod), IsoValue(InIsoValue)
+{
+}
+
+/**
+ * Extracts the surface of an occupancy, occupied voxels have value 1 and empty voxels 0
+ * @param InOccupancy The occupancy
+ * @return The meshes of every chunk the surface passes through
+ */
+TArray<FVoxelSurfaceMesh> FVoxelSurfaceExtractor::Extract(const FVoxelOccupancy& InOccupancy) const
+{
+	return ExtractChunks(InOccupancy.GetGrid(), [&InOccupancy](const FIntVector& Coordinate)
+	{
+		return InOccupancy.IsOccupied(Coordinate) ? 1.0f : 0.0f;
+	});
+}
+
+/**
+ * Extracts the surface of coverage values, the fraction of each voxel covered by geometry
+ * @param InCoverage The coverage values
+ * @return The meshes of every chunk the surface passes through
+ */
+TArray<FVoxelSurfaceMesh> FVoxelSurfaceExtractor::Extract(const TVoxelAttribute<float>& InCoverage) const
+{
+	return ExtractChunks(InCoverage.GetGrid(), [&InCoverage](const FIntVector& Coordinate)
+	{
+		return InCoverage[Coordinate];
+	});
+}
+
+/**
+ * Extracts the surface of a single chunk of an occupancy, to remesh only the chunks an edit reached
+ * @param InOccupancy The occupancy
+ * @param InChunkCoordinate The chunk coordinate
+ * @return The chunk's mesh
+ */
+FVoxelSurfaceMesh FVoxelSurfaceExtractor::ExtractChunk(const FVoxelOccupancy& InOccupancy, const FIntVector& InChunkCoordinate) const
+{
+	return ExtractChunk(InOccupancy.GetGrid(), InChunkCoordinate, [&InOccupancy](const FIntVector& Coordinate)
+	{
+		return InOccupancy.IsOccupied(Coordinate) ? 1.0f : 0.0f;
+	});
+}
+
+/**
+ * Extracts the surface of a single chunk of coverage values, to remesh only the chunks an edit reached
+ * @param InCoverage The coverage values
+ * @param InChunkCoordinate The chunk coordinate
+ * @return The chunk's mesh
+ */
+FVoxelSurfaceMesh FVoxelSurfaceExtractor::ExtractChunk(const TVoxelAttribute<float>& InCoverage, const FIntVector& InChunkCoordinate) const
+{
+	return ExtractChunk(InCoverage.GetGrid(), InChunkCoordinate, [&InCoverage](const FIntVector& Coordinate)
+	{
+		return InCoverage[Coordinate];
+	});
+}
+
+/**
+ * Extracts every chunk in parallel
+ * @param InGrid The grid the values cover
+ * @param Sample Gets the value of a voxel inside the grid, called from worker threads
+ * @return The meshes of every chunk the surface passes through
+ */
+TArray<FVoxelSurfaceMesh> FVoxelSurfaceExtractor::ExtractChunks(const FVoxelGrid& InGrid, TFunctionRef<float(const FIntVector&)> Sample) const
+{
+	constexpr int32 ChunkSize = FVoxelOccupancy::ChunkSize;
+
+	const FIntVector VoxelCount = InGrid.GetVectorVoxelCount();
+	const FIntVector ChunkCount(
+		FMath::DivideAndRoundUp(VoxelCount.X, ChunkSize),
+		FMath::DivideAndRoundUp(VoxelCount.Y, ChunkSize),
+		FMath::DivideAndRoundUp(VoxelCount.Z, ChunkSize));
+
+	TArray<FVoxelSurfaceMesh> Meshes;
+	Meshes.SetNum(ChunkCount.X * ChunkCount.Y * ChunkCount.Z);
+
+	ParallelFor(Meshes.Num(), [this, &InGrid, &Sample, &ChunkCount, &Meshes](const int32 ChunkIndex)
+	{
+		const FIntVector ChunkCoordinate(ChunkIndex % ChunkCount.X, (ChunkIndex / ChunkCount.X) % ChunkCount.Y, ChunkIndex / (ChunkCount.X * ChunkCount.Y));
+
+		Meshes[ChunkIndex] = ExtractChunk(InGrid, ChunkCoordinate, Sample);
+	});
+
+	Meshes.RemoveAll([](const FVoxelSurfaceMesh& Mesh)
+	{
+		return Mesh.IsEmpty();
+	});
+
+	return Meshes;
+}
+
+/**
+ * Extracts the surface of the cells a chunk owns
+ * A cell starts at a voxel center and is owned by that voxel's chunk, the cells before the grid's first voxels belong
+ * to the first chunks, so the surface is closed at the grid's border
+ * @param InGrid The grid the values cover
+ * @param InChunkCoordinate The chunk coordinate
+ * @param Sample Gets the value of a voxel inside the grid
+ * @return The chunk's mesh
+ */
+FVoxelSurfaceMesh FVoxelSurfaceExtractor::ExtractChunk(const FVoxelGrid& InGrid, const FIntVector& InChunkCoordinate,
+	TFunctionRef<float(const FIntVector&)> Sample) const
+{
+	constexpr int32 ChunkSize = FVoxelOccupancy::ChunkSize;
+
+	checkf(IsoValue > 0.0f, TEXT("Iso value must be above 0, the outside of the grid is empty"));
+
+	const FIntVector VoxelCount = InGrid.GetVectorVoxelCount();
+
+	FVoxelBox Cells;
+
+	for(int32 Axis = 0; Axis < 3; Axis++)
+	{
+		const int32 First = InChunkCoordinate[Axis] * ChunkSize;
+		const int32 Last = FMath::Min(First + ChunkSize, VoxelCount[Axis]);
+
+		Cells.Min[Axis] = First == 0 ? -1 : First;
+		Cells.Max[Axis] = Last;
+	}
+
+	FVoxelSurfaceMesh Mesh;
+	Mesh.ChunkCoordinate = InChunkCoordinate;
+
+	if(Cells.IsEmpty())
+	{
+		return Mesh;
+	}
+
+	// Corners reach one past the cells, gradients one more and dual contouring's margin cells one before
+	const FSampleBlock Block(InGrid, FVoxelBox(Cells.Min - FIntVector(KernelRadius), Cells.Max + FIntVector(KernelRadius)), Sample);
+
+	FMeshBuilder Builder{Mesh, InGrid.GetBounds().Min + InGrid.GetVoxelSize() * 0.5, InGrid.GetVoxelSize()};
+
+	if(Method == EVoxelSurfaceMethod::MarchingCubes)
+	{
+		MarchCells(Block, Cells, IsoValue, Builder);
+	}
+	else
+	{
+		ContourEdges(Block, Cells, IsoValue, SingularThreshold, Builder);
+	}
+
+	return Mesh;
+}
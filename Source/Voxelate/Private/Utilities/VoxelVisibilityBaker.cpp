@@ -0,0 +1,240 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelVisibilityBaker.h"
+
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/**
+	 * Gets a stride through a set of samples that visits every sample once before repeating
+	 * @param InNum The number of samples
+	 * @return A stride near the golden ratio of the count that shares no factor with it
+	 */
+	int32 GetCoprimeStride(const int32 InNum)
+	{
+		const auto GreatestCommonDivisor = [](int32 A, int32 B)
+		{
+			while(B != 0)
+			{
+				const int32 Remainder = A % B;
+				A = B;
+				B = Remainder;
+			}
+
+			return A;
+		};
+
+		int32 Stride = FMath::Max(FMath::RoundToInt32(InNum * 0.618), 1);
+
+		while(GreatestCommonDivisor(Stride, InNum) != 1)
+		{
+			Stride++;
+		}
+
+		return Stride;
+	}
+}
+
+FVoxelVisibilityBaker::FVoxelVisibilityBaker(const int32 InRaysPerChunkPair, const int32 InMaxChunkDistance)
+	: RaysPerChunkPair(InRaysPerChunkPair), MaxChunkDistance(InMaxChunkDistance)
+{
+}
+
+/**
+ * Bakes the potentially visible set for every chunk of the occupancy
+ * Chunk pairs are tested once on worker threads, each task only writes the bitset of its own chunk
+ * and the lower triangle is mirrored afterwards, in parallel too
+ * @param InOccupancy The occupancy to cast rays through
+ * @return The visibility between all chunks
+ */
+FVoxelVisibility FVoxelVisibilityBaker::Bake(const FVoxelOccupancy& InOccupancy) const
+{
+	const int32 NumChunks = InOccupancy.GetNumChunks();
+
+	FVoxelVisibility Result(NumChunks);
+
+	// Empty voxels to start and end rays from, a chunk without any can't see or be seen
+	TArray<TArray<FVector>> Samples;
+	Samples.SetNum(NumChunks);
+
+	ParallelFor(NumChunks, [&](const int32 ChunkIndex)
+	{
+		Samples[ChunkIndex] = GetChunkSamples(InOccupancy, ChunkIndex);
+	});
+
+	ParallelFor(NumChunks, [&](const int32 ChunkA)
+	{
+		if(Samples[ChunkA].IsEmpty())
+		{
+			return;
+		}
+
+		Result.SetVisible(ChunkA, ChunkA);
+
+		const FIntVector CoordinateA = InOccupancy.GetChunkCoordinate(ChunkA);
+
+		for(int32 ChunkB = ChunkA + 1; ChunkB < NumChunks; ChunkB++)
+		{
+			if(Samples[ChunkB].IsEmpty())
+			{
+				continue;
+			}
+
+			const FIntVector Offset = InOccupancy.GetChunkCoordinate(ChunkB) - CoordinateA;
+			const int32 Distance = FMath::Max3(FMath::Abs(Offset.X), FMath::Abs(Offset.Y), FMath::Abs(Offset.Z));
+
+			if(MaxChunkDistance > 0 && Distance > MaxChunkDistance)
+			{
+				continue;
+			}
+
+			// Touching chunks are always potentially visible, sampling them would only risk false negatives
+			if(Distance <= 1 || IsChunkPairVisible(InOccupancy, Samples[ChunkA], Samples[ChunkB]))
+			{
+				Result.SetVisible(ChunkA, ChunkB);
+			}
+		}
+	});
+
+	// Visibility is symmetric, copy the upper triangle into the lower one
+	// A row's words hold bits of both triangles, so the lower one is gathered apart and merged after, each task writing its own row
+	FVoxelVisibility Lower(NumChunks);
+
+	ParallelFor(NumChunks, [&Result, &Lower](const int32 ChunkB)
+	{
+		for(int32 ChunkA = 0; ChunkA < ChunkB; ChunkA++)
+		{
+			if(Result.IsVisible(ChunkA, ChunkB))
+			{
+				Lower.SetVisible(ChunkB, ChunkA);
+			}
+		}
+	});
+
+	ParallelFor(NumChunks, [&Result, &Lower](const int32 ChunkB)
+	{
+		const TConstArrayView<uint64> LowerSet = Lower.GetVisibleSet(ChunkB);
+
+		for(int32 WordIndex = 0; WordIndex < LowerSet.Num(); WordIndex++)
+		{
+			for(uint64 Word = LowerSet[WordIndex]; Word != 0; Word &= Word - 1)
+			{
+				Result.SetVisible(ChunkB, WordIndex * 64 + FMath::CountTrailingZeros64(Word));
+			}
+		}
+	});
+
+	return Result;
+}
+
+/**
+ * Picks random empty points inside a chunk, in voxel space
+ * Falls back to scanning the chunk's words when random picks keep landing in occupied voxels
+ * @param InOccupancy The occupancy the chunk belongs to
+ * @param InChunkIndex The chunk to sample
+ * @return Up to RaysPerChunkPair points inside empty voxels
+ */
+TArray<FVector> FVoxelVisibilityBaker::GetChunkSamples(const FVoxelOccupancy& InOccupancy, const int32 InChunkIndex) const
+{
+	const FIntVector ChunkCoordinate = InOccupancy.GetChunkCoordinate(InChunkIndex);
+
+	FIntVector Min, Max;
+	InOccupancy.GetChunkVoxelRange(ChunkCoordinate, Min, Max);
+
+	FRandomStream RandomStream(Seed + InChunkIndex);
+
+	TArray<FVector> Result;
+	Result.Reserve(RaysPerChunkPair);
+
+	for(int32 Attempt = 0; Attempt < RaysPerChunkPair * 4 && Result.Num() < RaysPerChunkPair; Attempt++)
+	{
+		const FIntVector Voxel(
+			RandomStream.RandRange(Min.X, Max.X - 1),
+			RandomStream.RandRange(Min.Y, Max.Y - 1),
+			RandomStream.RandRange(Min.Z, Max.Z - 1));
+
+		if(!InOccupancy.IsOccupied(Voxel))
+		{
+			Result.Add(FVector(Voxel) + FVector(RandomStream.FRand(), RandomStream.FRand(), RandomStream.FRand()));
+		}
+	}
+
+	if(!Result.IsEmpty())
+	{
+		return Result;
+	}
+
+	// Mostly solid chunk, collect whatever empty voxels exist so small cavities aren't missed
+	const int32 ChunkWidth = Max.X - Min.X;
+	const uint64 RowMask = ChunkWidth == 64 ? ~uint64(0) : (uint64(1) << ChunkWidth) - 1;
+	const TArray<uint64>& Words = InOccupancy.GetWords();
+
+	for(int32 Z = Min.Z; Z < Max.Z && Result.Num() < RaysPerChunkPair; Z++)
+	{
+		for(int32 Y = Min.Y; Y < Max.Y && Result.Num() < RaysPerChunkPair; Y++)
+		{
+			uint64 EmptyBits = ~Words[InOccupancy.GetRowWordIndex(Y, Z) + ChunkCoordinate.X] & RowMask;
+
+			while(EmptyBits != 0 && Result.Num() < RaysPerChunkPair)
+			{
+				const int32 X = Min.X + FMath::CountTrailingZeros64(EmptyBits);
+				Result.Add(FVector(X, Y, Z) + FVector(0.5));
+				EmptyBits &= EmptyBits - 1;
+			}
+		}
+	}
+
+	return Result;
+}
+
+/**
+ * Casts a batch of rays between the samples of two chunks
+ * @param InOccupancy The occupancy to cast rays through
+ * @param InSamplesA The samples of the first chunk
+ * @param InSamplesB The samples of the second chunk
+ * @return true as soon as a single ray gets through
+ */
+bool FVoxelVisibilityBaker::IsChunkPairVisible(const FVoxelOccupancy& InOccupancy, const TArray<FVector>& InSamplesA,
+	const TArray<FVector>& InSamplesB) const
+{
+	// Stride through the second set so rays fan out, every sample is used once before any repeats
+	// and each pass over the first set is shifted so the same pairs aren't cast again
+	const int32 StrideB = GetCoprimeStride(InSamplesB.Num());
+
+	for(int32 RayIndex = 0; RayIndex < RaysPerChunkPair; RayIndex++)
+	{
+		const FVector& Start = InSamplesA[RayIndex % InSamplesA.Num()];
+		const FVector& End = InSamplesB[(int64(RayIndex) * StrideB + RayIndex / InSamplesA.Num()) % InSamplesB.Num()];
+
+		if(!InOccupancy.LineTraceVoxels(Start, End))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
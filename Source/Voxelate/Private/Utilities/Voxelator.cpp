@@ -25,40 +25,720 @@
 
 #include "Utilities/Voxelator.h"
 
+#include "LandscapeHeightfieldCollisionComponent.h"
+#include "StaticMeshResources.h"
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "PhysicsEngine/BodySetup.h"
+
+namespace
+{
+	/**
+	 * Rasterization target writing into bit packed occupancy, layer masks are ignored
+	 */
+	struct FOccupancyTarget
+	{
+		FVoxelOccupancy& Occupancy;
+
+		FORCEINLINE const FVoxelGrid& GetGrid() const
+		{
+			return Occupancy.GetGrid();
+		}
+
+		FORCEINLINE bool Contains(const FIntVector& Coordinate, const uint16 LayerMask) const
+		{
+			return Occupancy.IsOccupied(Coordinate);
+		}
+
+		FORCEINLINE void Add(const FIntVector& Coordinate, const uint16 LayerMask)
+		{
+			Occupancy.SetOccupied(Coordinate, true);
+		}
+	};
+
+	/**
+	 * Rasterization target ORing layer masks into interleaved per voxel masks
+	 */
+	struct FLayersTarget
+	{
+		FVoxelLayers& Layers;
+
+		FORCEINLINE const FVoxelGrid& GetGrid() const
+		{
+			return Layers.GetGrid();
+		}
+
+		FORCEINLINE bool Contains(const FIntVector& Coordinate, const uint16 LayerMask) const
+		{
+			return (Layers[Coordinate] & LayerMask) == LayerMask;
+		}
+
+		FORCEINLINE void Add(const FIntVector& Coordinate, const uint16 LayerMask)
+		{
+			Layers[Coordinate] |= LayerMask;
+		}
+	};
+
+	/**
+	 * Adds every voxel of a box that a shape intersects to a target
+	 * @param Target The target to write to
+	 * @param VoxelBox The voxels to test, must be inside the grid
+	 * @param LayerMask The layers the shape belongs to
+	 * @param Intersects Called with a voxel's world bounds, returns true if the shape touches it
+	 */
+	template<typename TargetType, typename IntersectsType>
+	void RasterizeVoxels(TargetType& Target, const FVoxelBox& VoxelBox, const uint16 LayerMask, IntersectsType&& Intersects)
+	{
+		const FVoxelGrid& Grid = Target.GetGrid();
+
+		VoxelBox.ForEach([&Target, &Grid, LayerMask, &Intersects](const FIntVector& Coordinate)
+		{
+			if(!Target.Contains(Coordinate, LayerMask) && Intersects(Grid.GetVoxelBounds(Coordinate)))
+			{
+				Target.Add(Coordinate, LayerMask);
+			}
+		});
+	}
+
+	/**
+	 * Adds every voxel of a box that is below a landscape's surface to a target
+	 * Heights were sampled once per column at the column's center when the shapes were gathered
+	 * @param Target The target to write to
+	 * @param VoxelBox The voxels to fill, must be inside the grid
+	 * @param LayerMask The layers the landscape belongs to
+	 * @param Heightfield The landscape's sampled heights
+	 */
+	template<typename TargetType>
+	void RasterizeLandscape(TargetType& Target, const FVoxelBox& VoxelBox, const uint16 LayerMask, const FVoxelatorHeightfield& Heightfield)
+	{
+		const FVoxelGrid& Grid = Target.GetGrid();
+		const FIntVector LatticeOrigin = Grid.GetLatticeOrigin();
+
+		for(int32 Y = VoxelBox.Min.Y; Y < VoxelBox.Max.Y; Y++)
+		{
+			const int32 ColumnY = LatticeOrigin.Y + Y - Heightfield.LatticeMin.Y;
+
+			for(int32 X = VoxelBox.Min.X; X < VoxelBox.Max.X; X++)
+			{
+				const int32 ColumnX = LatticeOrigin.X + X - Heightfield.LatticeMin.X;
+
+				if(ColumnX < 0 || ColumnY < 0 || ColumnX >= Heightfield.Size.X || ColumnY >= Heightfield.Size.Y)
+				{
+					continue;
+				}
+
+				const float Height = Heightfield.Heights[ColumnX + ColumnY * Heightfield.Size.X];
+
+				for(int32 Z = VoxelBox.Min.Z; Z < VoxelBox.Max.Z; Z++)
+				{
+					const FIntVector Coordinate(X, Y, Z);
+
+					if(Grid.GetVoxelBounds(Coordinate).Min.Z > Height)
+					{
+						break;
+					}
+
+					Target.Add(Coordinate, LayerMask);
+				}
+			}
+		}
+	}
+
+	/**
+	 * Rasterizes the shapes overlapping a chunk
+	 * @param Shapes The shapes
+	 * @param Entries The entries of the shapes overlapping the chunk
+	 * @param ChunkBox The chunk's voxels
+	 * @param Target The target to write to, only the chunk's voxels are written
+	 */
+	template<typename TargetType>
+	void RasterizeChunk(const FVoxelatorShapes& Shapes, const TArray<int32>& Entries, const FVoxelBox& ChunkBox, TargetType& Target)
+	{
+		const FVoxelGrid& Grid = Target.GetGrid();
+
+		for(const int32 EntryIndex : Entries)
+		{
+			const FVoxelatorShapes::FEntry& Entry = Shapes.Entries[EntryIndex];
+			const FVoxelBox VoxelBox = Grid.GetVoxelBox(Entry.Bounds).Intersect(ChunkBox);
+
+			switch(Entry.Shape)
+			{
+			case EVoxelatorShape::Box:
+				RasterizeVoxels(Target, VoxelBox, Entry.LayerMask, [&Box = Shapes.Boxes[Entry.Index]](const FBox& Voxel) { return Box.Intersect(Voxel); });
+				break;
+			case EVoxelatorShape::Sphere:
+				RasterizeVoxels(Target, VoxelBox, Entry.LayerMask, [&Sphere = Shapes.Spheres[Entry.Index]](const FBox& Voxel) { return Sphere.Intersects(Voxel); });
+				break;
+			case EVoxelatorShape::Capsule:
+				RasterizeVoxels(Target, VoxelBox, Entry.LayerMask, [&Capsule = Shapes.Capsules[Entry.Index]](const FBox& Voxel) { return Capsule.Intersects(Voxel); });
+				break;
+			case EVoxelatorShape::Triangle:
+				RasterizeVoxels(Target, VoxelBox, Entry.LayerMask, [&Triangle = Shapes.Triangles[Entry.Index]](const FBox& Voxel) { return Triangle.Intersects(Voxel); });
+				break;
+			case EVoxelatorShape::Landscape:
+				RasterizeLandscape(Target, VoxelBox, Entry.LayerMask, Shapes.Landscapes[Entry.Index]);
+				break;
+			}
+		}
+	}
+
+	/**
+	 * Rasterizes shapes into a target
+	 * Shapes are binned by the occupancy chunks they overlap, then chunks are rasterized in parallel
+	 * Every chunk only writes its own voxels, so no synchronisation is needed
+	 * @param Shapes The shapes to rasterize
+	 * @param Target The target to write to
+	 * @param NumWorkers Number of tasks the chunks are split into, 0 for one per chunk
+	 */
+	template<typename TargetType>
+	void RasterizeShapes(const FVoxelatorShapes& Shapes, TargetType& Target, const int32 NumWorkers)
+	{
+		constexpr int32 ChunkSize = FVoxelOccupancy::ChunkSize;
+
+		const FVoxelGrid& Grid = Target.GetGrid();
+		const FIntVector VoxelCount = Grid.GetVectorVoxelCount();
+		const FIntVector ChunkCount(
+			FMath::DivideAndRoundUp(VoxelCount.X, ChunkSize),
+			FMath::DivideAndRoundUp(VoxelCount.Y, ChunkSize),
+			FMath::DivideAndRoundUp(VoxelCount.Z, ChunkSize));
+		const int32 NumChunks = ChunkCount.X * ChunkCount.Y * ChunkCount.Z;
+
+		TArray<TArray<int32>> ChunkEntries;
+		ChunkEntries.SetNum(NumChunks);
+
+		for(int32 Entry = 0; Entry < Shapes.Entries.Num(); Entry++)
+		{
+			const FVoxelBox VoxelBox = Grid.GetVoxelBox(Shapes.Entries[Entry].Bounds);
+
+			if(VoxelBox.IsEmpty())
+			{
+				continue;
+			}
+
+			FVoxelBox(VoxelBox.Min / ChunkSize, (VoxelBox.Max - FIntVector(1)) / ChunkSize + FIntVector(1)).ForEach(
+				[&ChunkEntries, &ChunkCount, Entry](const FIntVector& ChunkCoordinate)
+			{
+				ChunkEntries[ChunkCoordinate.X + (ChunkCoordinate.Y + ChunkCoordinate.Z * ChunkCount.Y) * ChunkCount.X].Add(Entry);
+			});
+		}
+
+		const int32 NumTasks = NumWorkers > 0 ? FMath::Min(NumWorkers, NumChunks) : NumChunks;
+
+		ParallelFor(NumTasks, [&Shapes, &Target, &Grid, &ChunkEntries, &ChunkCount, NumChunks, NumTasks](const int32 Task)
+		{
+			for(int32 Chunk = NumChunks * Task / NumTasks; Chunk < NumChunks * (Task + 1) / NumTasks; Chunk++)
+			{
+				if(ChunkEntries[Chunk].Num() == 0)
+				{
+					continue;
+				}
+
+				const FIntVector ChunkCoordinate(Chunk % ChunkCount.X, (Chunk / ChunkCount.X) % ChunkCount.Y, Chunk / (ChunkCount.X * ChunkCount.Y));
+				const FIntVector ChunkMin = ChunkCoordinate * ChunkSize;
+				const FVoxelBox ChunkBox = FVoxelBox(ChunkMin, ChunkMin + FIntVector(ChunkSize)).Intersect(Grid.GetVoxelBox());
+
+				RasterizeChunk(Shapes, ChunkEntries[Chunk], ChunkBox, Target);
+			}
+		});
+	}
+}
+
+void FVoxelatorShapes::AddBox(const FOOBBoxProxy& InBox)
+{
+	TArray<FVector> Corners;
+	InBox.GetCorners(Corners);
+
+	Entries.Add({EVoxelatorShape::Box, Boxes.Add(InBox), FBox(Corners)});
+}
+
+void FVoxelatorShapes::AddSphere(const FSphereProxy& InSphere)
+{
+	Entries.Add({EVoxelatorShape::Sphere, Spheres.Add(InSphere), FBox(InSphere.Center - InSphere.Radius, InSphere.Center + InSphere.Radius)});
+}
+
+void FVoxelatorShapes::AddCapsule(const FCapsuleProxy& InCapsule)
+{
+	const FBox Bounds = FBox(InCapsule.Start.ComponentMin(InCapsule.End), InCapsule.Start.ComponentMax(InCapsule.End)).ExpandBy(InCapsule.Radius);
+
+	Entries.Add({EVoxelatorShape::Capsule, Capsules.Add(InCapsule), Bounds});
+}
+
+void FVoxelatorShapes::AddTriangle(const FTriangleProxy& InTriangle)
+{
+	Entries.Add({EVoxelatorShape::Triangle, Triangles.Add(InTriangle), FBox(InTriangle.V, 3)});
+}
+
+void FVoxelatorShapes::AddLandscape(const ALandscapeProxy* InLandscape, const FBox& InBounds)
+{
+	FVoxelatorHeightfield Heightfield;
+	Heightfield.Landscape = InLandscape;
+
+	Entries.Add({EVoxelatorShape::Landscape, Landscapes.Add(MoveTemp(Heightfield)), InBounds});
+}
+
+/**
+ * Appends another set of shapes, offsetting its entries into this set's arrays
+ * @param Other The shapes to append
+ */
+void FVoxelatorShapes::Append(const FVoxelatorShapes& Other)
+{
+	const int32 Offsets[] = { Boxes.Num(), Spheres.Num(), Capsules.Num(), Triangles.Num(), Landscapes.Num() };
+
+	Boxes.Append(Other.Boxes);
+	Spheres.Append(Other.Spheres);
+	Capsules.Append(Other.Capsules);
+	Triangles.Append(Other.Triangles);
+	Landscapes.Append(Other.Landscapes);
+
+	Entries.Reserve(Entries.Num() + Other.Entries.Num());
+
+	for(const FEntry& Entry : Other.Entries)
+	{
+		Entries.Add({Entry.Shape, Entry.Index + Offsets[static_cast<int32>(Entry.Shape)], Entry.Bounds, Entry.LayerMask});
+	}
+}
+
+/**
+ * Samples the height of every landscape once per voxel column of a grid, at the column's center
+ * Landscapes can only be queried on the game thread, so this is done up front and rasterizing only reads the heights
+ * @param InVoxelGrid The grid the shapes will be rasterized into
+ */
+void FVoxelatorShapes::SampleLandscapes(const FVoxelGrid& InVoxelGrid)
+{
+	checkf(IsInGameThread(), TEXT("Landscapes can only be sampled on the game thread"));
+
+	for(const FEntry& Entry : Entries)
+	{
+		if(Entry.Shape != EVoxelatorShape::Landscape)
+		{
+			continue;
+		}
+
+		FVoxelatorHeightfield& Heightfield = Landscapes[Entry.Index];
+		const FVoxelBox VoxelBox = InVoxelGrid.GetVoxelBox(Entry.Bounds);
+
+		if(VoxelBox.IsEmpty())
+		{
+			Heightfield.Size = FIntPoint::ZeroValue;
+			Heightfield.Heights.Reset();
+			continue;
+		}
+
+		const FIntVector LatticeMin = InVoxelGrid.GetLatticeOrigin() + VoxelBox.Min;
+		Heightfield.LatticeMin = FIntPoint(LatticeMin.X, LatticeMin.Y);
+		Heightfield.Size = FIntPoint(VoxelBox.Max.X - VoxelBox.Min.X, VoxelBox.Max.Y - VoxelBox.Min.Y);
+		Heightfield.Heights.Init(TNumericLimits<float>::Lowest(), Heightfield.Size.X * Heightfield.Size.Y);
+
+		for(int32 Y = 0; Y < Heightfield.Size.Y; Y++)
+		{
+			for(int32 X = 0; X < Heightfield.Size.X; X++)
+			{
+				const FIntVector Column(VoxelBox.Min.X + X, VoxelBox.Min.Y + Y, VoxelBox.Min.Z);
+				const TOptional<float> Height = Heightfield.Landscape->GetHeightAtLocation(InVoxelGrid.GetVoxelBounds(Column).GetCenter());
+
+				if(Height.IsSet())
+				{
+					Heightfield.Heights[X + Y * Heightfield.Size.X] = Height.GetValue();
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Struct constructor
+ * @param InName The layer's name
+ * @param InFilter Decides which components the layer holds
+ */
+FVoxelatorLayer::FVoxelatorLayer(const FName InName, const FVoxelComponentFilter& InFilter) : Name(InName), Filter(InFilter)
+{
+}
+
 FVoxelator::FVoxelator(UWorld* InWorld) : World(InWorld)
 {
 }
 
+/**
+ * Struct constructor
+ * @param InWorld The world to voxelate
+ * @param InNumWorkers Number of tasks parallel work is split into, 0 for as many as the task graph likes
+ */
+FVoxelator::FVoxelator(UWorld* InWorld, const int32 InNumWorkers) : World(InWorld), NumWorkers(FMath::Max(InNumWorkers, 0))
+{
+}
+
+/**
+ * Struct constructor
+ * @param InWorld The world to voxelate
+ * @param InNumWorkers Number of tasks parallel work is split into, 0 for as many as the task graph likes
+ * @param InFilter Decides which components are voxelated
+ */
+FVoxelator::FVoxelator(UWorld* InWorld, const int32 InNumWorkers, const FVoxelComponentFilter& InFilter)
+	: World(InWorld), NumWorkers(FMath::Max(InNumWorkers, 0)), Filter(InFilter)
+{
+}
+
+/**
+ * Voxelates the navigable geometry
+ * @param InVoxelGrid The grid to voxelate
+ * @return Whether each voxel of the grid is occupied
+ */
 TArray<bool> FVoxelator::VoxelateNavigableGeometry(const FVoxelGrid& InVoxelGrid)
 {
-	return TArray<bool>();
+	return Voxelate(InVoxelGrid).ToArray();
 }
 
-void FVoxelator::ProcessPrimitiveComponent(UPrimitiveComponent* InPrimitiveComponent, const FVoxelGrid& InVoxelGrid)
+/**
+ * Voxelates the navigable geometry into bit packed occupancy
+ * @param InVoxelGrid The grid to voxelate
+ * @return The occupancy
+ */
+FVoxelOccupancy FVoxelator::Voxelate(const FVoxelGrid& InVoxelGrid)
 {
+	FVoxelOccupancy Occupancy(InVoxelGrid);
+
+	Rasterize(GatherShapes(InVoxelGrid), Occupancy);
+
+	return Occupancy;
+}
+
+/**
+ * Voxelates several layers in a single pass, each with its own component filter
+ * Components are gathered and rasterized once, each shape ORs the mask of every layer its component passes
+ * @param InVoxelGrid The grid to voxelate
+ * @param InLayers The layers, at most FVoxelLayers::MaxLayers
+ * @return The interleaved occupancy of every layer
+ */
+FVoxelLayers FVoxelator::VoxelateLayers(const FVoxelGrid& InVoxelGrid, const TArray<FVoxelatorLayer>& InLayers)
+{
+	TArray<FName> LayerNames;
+
+	for(const FVoxelatorLayer& Layer : InLayers)
+	{
+		LayerNames.Add(Layer.Name);
+	}
+
+	FVoxelLayers Layers(InVoxelGrid, LayerNames);
+
+	Rasterize(GatherShapes(InVoxelGrid, InLayers), Layers);
+
+	return Layers;
+}
+
+/**
+ * Gathers the collision of every candidate component overlapping a grid as world space shapes
+ * Must be called on the game thread while the world isn't ticking, components are read from worker threads
+ * @param InVoxelGrid The grid to gather for
+ * @return The shapes, in the order of the candidate components
+ */
+FVoxelatorShapes FVoxelator::GatherShapes(const FVoxelGrid& InVoxelGrid) const
+{
+	return GatherShapes(InVoxelGrid, { FVoxelatorLayer(NAME_None, Filter) });
+}
+
+/**
+ * Gathers the collision of every component overlapping a grid that passes any layer's filter
+ * Every component is tested against all layers at once in parallel, the shapes carry the mask of the layers it passed
+ * Must be called on the game thread while the world isn't ticking, components are read from worker threads
+ * and landscapes are sampled afterwards on the game thread
+ * @param InVoxelGrid The grid to gather for
+ * @param InLayers The layers, at most FVoxelLayers::MaxLayers
+ * @return The shapes, in the order of the candidate components
+ */
+FVoxelatorShapes FVoxelator::GatherShapes(const FVoxelGrid& InVoxelGrid, const TArray<FVoxelatorLayer>& InLayers) const
+{
+	checkf(InLayers.Num() <= FVoxelLayers::MaxLayers, TEXT("%d layers requested, at most %d are supported"),
+		InLayers.Num(), FVoxelLayers::MaxLayers);
+
+	TArray<UPrimitiveComponent*> Candidates = FVoxelComponentFilter::GatherComponents(World);
+	const FBox Bounds = InVoxelGrid.GetBounds();
+
+	TArray<uint16> LayerMasks;
+	LayerMasks.SetNumZeroed(Candidates.Num());
+
+	ParallelFor(Candidates.Num(), [&Candidates, &LayerMasks, &InLayers, &Bounds](const int32 Index)
+	{
+		const UPrimitiveComponent* Component = Candidates[Index];
+
+		if(!IsValid(Component) || !Component->Bounds.GetBox().Intersect(Bounds))
+		{
+			return;
+		}
+
+		for(int32 Layer = 0; Layer < InLayers.Num(); Layer++)
+		{
+			if(InLayers[Layer].Filter.PassesFilter(Component))
+			{
+				LayerMasks[Index] |= static_cast<uint16>(1 << Layer);
+			}
+		}
+	});
+
+	int32 NumCandidates = 0;
+
+	for(int32 Index = 0; Index < Candidates.Num(); Index++)
+	{
+		if(LayerMasks[Index] != 0)
+		{
+			Candidates[NumCandidates] = Candidates[Index];
+			LayerMasks[NumCandidates++] = LayerMasks[Index];
+		}
+	}
+
+	Candidates.SetNum(NumCandidates);
+	LayerMasks.SetNum(NumCandidates);
+
+	TArray<FVoxelatorShapes> CandidateShapes;
+	CandidateShapes.SetNum(Candidates.Num());
+
+	ParallelFor(Candidates.Num(), [this, &Candidates, &LayerMasks, &CandidateShapes](const int32 Index)
+	{
+		ProcessPrimitiveComponent(Candidates[Index], CandidateShapes[Index]);
+
+		for(FVoxelatorShapes::FEntry& Entry : CandidateShapes[Index].Entries)
+		{
+			Entry.LayerMask = LayerMasks[Index];
+		}
+	});
+
+	FVoxelatorShapes Shapes;
+
+	for(const FVoxelatorShapes& Other : CandidateShapes)
+	{
+		Shapes.Append(Other);
+	}
+
+	Shapes.SampleLandscapes(InVoxelGrid);
+
+	return Shapes;
+}
+
+/**
+ * Rasterizes shapes into occupancy, ignoring their layers
+ * @param InShapes The shapes to rasterize
+ * @param OutOccupancy The occupancy to write to, voxels are only ever set
+ */
+void FVoxelator::Rasterize(const FVoxelatorShapes& InShapes, FVoxelOccupancy& OutOccupancy) const
+{
+	FOccupancyTarget Target{OutOccupancy};
+	RasterizeShapes(InShapes, Target, NumWorkers);
+}
+
+/**
+ * Rasterizes shapes into interleaved layers, each voxel a shape touches gets the shape's layer mask ORed in
+ * @param InShapes The shapes to rasterize
+ * @param OutLayers The layers to write to, bits are only ever set
+ */
+void FVoxelator::Rasterize(const FVoxelatorShapes& InShapes, FVoxelLayers& OutLayers) const
+{
+	FLayersTarget Target{OutLayers};
+	RasterizeShapes(InShapes, Target, NumWorkers);
 }
 
-void FVoxelator::ProcessLandscape(ULandscapeHeightfieldCollisionComponent& LandscapeComponent,
-	const FVoxelGrid& LocalVoxelGrid, const FTransform& InstanceTransform)
+/**
+ * Gathers the collision of a component
+ * Simple collision is used when there is any, static meshes without it fall back to their render triangles
+ * Instanced static meshes add the shapes of every instance
+ * @param InPrimitiveComponent The component to gather
+ * @param OutShapes The shapes to add to
+ */
+void FVoxelator::ProcessPrimitiveComponent(UPrimitiveComponent* InPrimitiveComponent, FVoxelatorShapes& OutShapes) const
 {
+	if(const ULandscapeHeightfieldCollisionComponent* LandscapeComponent = Cast<ULandscapeHeightfieldCollisionComponent>(InPrimitiveComponent))
+	{
+		ProcessLandscape(*LandscapeComponent, OutShapes);
+		return;
+	}
+
+	const UBodySetup* BodySetup = InPrimitiveComponent->GetBodySetup();
+
+	if(!BodySetup)
+	{
+		return;
+	}
+
+	const UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(InPrimitiveComponent);
+	const UStaticMesh* StaticMesh = StaticMeshComponent ? StaticMeshComponent->GetStaticMesh() : nullptr;
+	const bool bUseRenderTriangles = StaticMesh &&
+		(BodySetup->CollisionTraceFlag == CTF_UseComplexAsSimple || BodySetup->AggGeom.GetElementCount() == 0);
+
+	TArray<FTransform> InstanceTransforms;
+
+	if(const UInstancedStaticMeshComponent* InstancedComponent = Cast<UInstancedStaticMeshComponent>(InPrimitiveComponent))
+	{
+		InstanceTransforms.Reserve(InstancedComponent->GetInstanceCount());
+
+		for(int32 Instance = 0; Instance < InstancedComponent->GetInstanceCount(); Instance++)
+		{
+			FTransform InstanceTransform;
+
+			if(InstancedComponent->GetInstanceTransform(Instance, InstanceTransform, true))
+			{
+				InstanceTransforms.Add(InstanceTransform);
+			}
+		}
+	}
+	else
+	{
+		InstanceTransforms.Add(InPrimitiveComponent->GetComponentTransform());
+	}
+
+	if(bUseRenderTriangles)
+	{
+		ProcessStaticMesh(*StaticMesh, InstanceTransforms, OutShapes);
+		return;
+	}
+
+	for(const FTransform& InstanceTransform : InstanceTransforms)
+	{
+		ProcessBodySetup(*BodySetup, InstanceTransform, OutShapes);
+	}
 }
 
-void FVoxelator::ProcessCollisionBox(const FKBoxElem& BoxElement, const FVoxelGrid& LocalVoxelGrid,
-	const FTransform& InstanceTransform)
+/**
+ * Gathers the simple collision of a body setup
+ * @param BodySetup The body setup
+ * @param InstanceTransform The world transform of the instance
+ * @param OutShapes The shapes to add to
+ */
+void FVoxelator::ProcessBodySetup(const UBodySetup& BodySetup, const FTransform& InstanceTransform, FVoxelatorShapes& OutShapes) const
 {
+	const FKAggregateGeom& AggregateGeometry = BodySetup.AggGeom;
+
+	for(const FKBoxElem& BoxElement : AggregateGeometry.BoxElems)
+	{
+		ProcessCollisionBox(BoxElement, InstanceTransform, OutShapes);
+	}
+
+	for(const FKSphereElem& SphereElement : AggregateGeometry.SphereElems)
+	{
+		ProcessCollisionSphere(SphereElement, InstanceTransform, OutShapes);
+	}
+
+	for(const FKSphylElem& CapsuleElement : AggregateGeometry.SphylElems)
+	{
+		ProcessCollisionCapsule(CapsuleElement, InstanceTransform, OutShapes);
+	}
+
+	for(const FKConvexElem& ConvexElement : AggregateGeometry.ConvexElems)
+	{
+		ProcessCollisionConvex(ConvexElement, InstanceTransform, OutShapes);
+	}
 }
 
-void FVoxelator::ProcessCollisionSphere(const FKSphereElem& SphereElement, const FVoxelGrid& LocalVoxelGrid,
-	const FTransform& InstanceTransform)
+/**
+ * Gathers the triangles of a static mesh's first LOD for every instance
+ * The index and vertex buffers are read once, only the transform is applied per instance
+ * Cooked meshes need CPU access enabled, otherwise the mesh is skipped
+ * @param StaticMesh The static mesh
+ * @param InstanceTransforms The world transform of every instance
+ * @param OutShapes The shapes to add to
+ */
+void FVoxelator::ProcessStaticMesh(const UStaticMesh& StaticMesh, TConstArrayView<FTransform> InstanceTransforms, FVoxelatorShapes& OutShapes) const
 {
+	const FStaticMeshRenderData* RenderData = StaticMesh.GetRenderData();
+
+	if(!RenderData || RenderData->LODResources.Num() == 0 || (!GIsEditor && !StaticMesh.bAllowCPUAccess))
+	{
+		return;
+	}
+
+	const FStaticMeshLODResources& LODResources = RenderData->LODResources[0];
+	const FPositionVertexBuffer& PositionBuffer = LODResources.VertexBuffers.PositionVertexBuffer;
+
+	TArray<FVector> LocalVertices;
+	LocalVertices.SetNumUninitialized(PositionBuffer.GetNumVertices());
+
+	for(int32 Vertex = 0; Vertex < LocalVertices.Num(); Vertex++)
+	{
+		LocalVertices[Vertex] = FVector(PositionBuffer.VertexPosition(Vertex));
+	}
+
+	TArray<uint32> Indices;
+	LODResources.IndexBuffer.GetCopy(Indices);
+
+	const int32 NumTriangles = Indices.Num() / 3;
+	OutShapes.Triangles.Reserve(OutShapes.Triangles.Num() + NumTriangles * InstanceTransforms.Num());
+	OutShapes.Entries.Reserve(OutShapes.Entries.Num() + NumTriangles * InstanceTransforms.Num());
+
+	TArray<FVector> Vertices;
+	Vertices.SetNumUninitialized(LocalVertices.Num());
+
+	for(const FTransform& InstanceTransform : InstanceTransforms)
+	{
+		for(int32 Vertex = 0; Vertex < Vertices.Num(); Vertex++)
+		{
+			Vertices[Vertex] = InstanceTransform.TransformPosition(LocalVertices[Vertex]);
+		}
+
+		for(int32 Index = 0; Index + 2 < Indices.Num(); Index += 3)
+		{
+			OutShapes.AddTriangle(FTriangleProxy(Vertices[Indices[Index]], Vertices[Indices[Index + 1]], Vertices[Indices[Index + 2]]));
+		}
+	}
+}
+
+/**
+ * Gathers a landscape component, its heights are sampled per voxel column once every shape is gathered
+ * @param LandscapeComponent The landscape's collision component
+ * @param OutShapes The shapes to add to
+ */
+void FVoxelator::ProcessLandscape(const ULandscapeHeightfieldCollisionComponent& LandscapeComponent, FVoxelatorShapes& OutShapes) const
+{
+	if(const ALandscapeProxy* Landscape = LandscapeComponent.GetLandscapeProxy())
+	{
+		OutShapes.AddLandscape(Landscape, LandscapeComponent.Bounds.GetBox());
+	}
+}
+
+void FVoxelator::ProcessCollisionBox(const FKBoxElem& BoxElement, const FTransform& InstanceTransform, FVoxelatorShapes& OutShapes) const
+{
+	OutShapes.AddBox(FOOBBoxProxy(BoxElement, InstanceTransform));
 }
 
-void FVoxelator::ProcessCollisionCapsule(const FKSphylElem& CapsuleElement, const FVoxelGrid& LocalVoxelGrid,
-	const FTransform& InstanceTransform)
+void FVoxelator::ProcessCollisionSphere(const FKSphereElem& SphereElement, const FTransform& InstanceTransform, FVoxelatorShapes& OutShapes) const
 {
+	OutShapes.AddSphere(FSphereProxy(SphereElement, InstanceTransform));
 }
 
-void FVoxelator::ProcessCollisionConvex(const FKConvexElem& ConvexElement, const FVoxelGrid& LocalVoxelGrid,
-	const FTransform& InstanceTransform)
+void FVoxelator::ProcessCollisionCapsule(const FKSphylElem& CapsuleElement, const FTransform& InstanceTransform, FVoxelatorShapes& OutShapes) const
+{
+	OutShapes.AddCapsule(FCapsuleProxy(CapsuleElement, InstanceTransform));
+}
+
+/**
+ * Gathers the hull triangles of a convex element
+ * Elements without index data fall back to their oriented bounding box
+ * @param ConvexElement The convex element in the component's local space
+ * @param InstanceTransform The world transform of the instance
+ * @param OutShapes The shapes to add to
+ */
+void FVoxelator::ProcessCollisionConvex(const FKConvexElem& ConvexElement, const FTransform& InstanceTransform, FVoxelatorShapes& OutShapes) const
 {
+	const FTransform ElementTransform = ConvexElement.GetTransform() * InstanceTransform;
+
+	if(ConvexElement.IndexData.Num() < 3)
+	{
+		if(ConvexElement.VertexData.Num() > 0)
+		{
+			OutShapes.AddBox(FOOBBoxProxy(ConvexElement.ElemBox, ElementTransform));
+		}
+
+		return;
+	}
+
+	TArray<FVector> Vertices;
+	Vertices.SetNumUninitialized(ConvexElement.VertexData.Num());
+
+	for(int32 Vertex = 0; Vertex < Vertices.Num(); Vertex++)
+	{
+		Vertices[Vertex] = ElementTransform.TransformPosition(ConvexElement.VertexData[Vertex]);
+	}
+
+	for(const FTriangleProxy& Triangle : FTriangleProxy::GetTriangles(Vertices, ConvexElement.IndexData))
+	{
+		OutShapes.AddTriangle(Triangle);
+	}
 }
@@ -45,6 +45,8 @@ public:
 	FCapsuleProxy(const FVector& InStart, const FVector& InEnd, const double InRadius);
 	FCapsuleProxy(const FKSphylElem& InCapsuleElement, const FTransform& InTransform);
 
+	static TArray<FCapsuleProxy> GetCapsules(const TArray<FKSphylElem>& CapsuleElements, const FTransform& InTransform);
+
 	bool Intersects(const FBox& Other) const;
 
 protected:
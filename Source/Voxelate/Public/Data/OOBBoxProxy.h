@@ -25,6 +25,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "PhysicsEngine/BoxElem.h"
 #include "OOBBoxProxy.generated.h"
 
 
@@ -45,11 +46,18 @@ struct VOXELATE_API FOOBBoxProxy
 	FQuat Orientation = FQuat::Identity;
 	// Choose to keep the current rotation or handle rotation interpolation
 	bool bSlerpRotation = false;
+	// Rows of the rotation matrix built from Orientation, i.e. the OBB's axes in world space
+	// Must be refreshed with UpdateAxes whenever Orientation is changed directly
+	FVector Axes[3] = { FVector::XAxisVector, FVector::YAxisVector, FVector::ZAxisVector };
 	
 	FOOBBoxProxy() = default;
 	FOOBBoxProxy(const FBoxSphereBounds& LocalBounds, const FTransform& InstanceTransform, const bool& InSlerpRotation = false);
 	FOOBBoxProxy(const FBox& LocalBounds, const FTransform& InstanceTransform, const bool& InSlerpRotation = false);
+	FOOBBoxProxy(const FKBoxElem& BoxElement, const FTransform& InstanceTransform);
+
+	static TArray<FOOBBoxProxy> GetBoxes(const TArray<FKBoxElem>& BoxElements, const FTransform& InstanceTransform);
 	
+	void UpdateAxes();
 	void GetAxis(FVector& OutAxisX, FVector& OutAxisY, FVector& OutAxisZ) const;
 	void GetCorners(TArray<FVector>& OutCorners) const;
 	
@@ -43,6 +43,9 @@ public:
 	FSphereProxy() = default;
 	FSphereProxy(const FVector& InCenter, const double& InRadius);
 	FSphereProxy(const FKSphereElem& SphereElement);
+	FSphereProxy(const FKSphereElem& SphereElement, const FTransform& InTransform);
+
+	static TArray<FSphereProxy> GetSpheres(const TArray<FKSphereElem>& SphereElements, const FTransform& InTransform);
 
 	bool Intersects(const FBox& Other) const;
 };
@@ -0,0 +1,175 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelCustomVersion.h"
+#include "Data/VoxelGrid.h"
+
+/**
+ * A dense attribute channel holding one value per voxel of a voxel grid
+ * Values are stored in voxel index order, the same order FVoxelGrid::GetVoxelIndex uses
+ */
+template<typename ElementType>
+struct TVoxelAttribute
+{
+protected:
+	FVoxelGrid Grid;
+
+	TArray<ElementType> Values;
+
+public:
+	TVoxelAttribute() = default;
+
+	/**
+	 * Struct constructor
+	 * @param InGrid The voxel grid the channel covers
+	 * @param InDefaultValue The value every voxel starts with
+	 */
+	explicit TVoxelAttribute(const FVoxelGrid& InGrid, const ElementType& InDefaultValue = ElementType())
+	{
+		Init(InGrid, InDefaultValue);
+	}
+
+	/**
+	 * Initializes the channel for a grid
+	 * @param InGrid The voxel grid the channel covers
+	 * @param InDefaultValue The value every voxel starts with
+	 */
+	void Init(const FVoxelGrid& InGrid, const ElementType& InDefaultValue = ElementType())
+	{
+		Grid = InGrid;
+		Values.Init(InDefaultValue, Grid.GetVoxelCount());
+	}
+
+	/**
+	 * Gets the voxel grid the channel covers
+	 * @return The voxel grid
+	 */
+	const FVoxelGrid& GetGrid() const
+	{
+		return Grid;
+	}
+
+	/**
+	 * Gets the values of every voxel, in voxel index order
+	 * @return The values
+	 */
+	TArray<ElementType>& GetValues()
+	{
+		return Values;
+	}
+
+	/**
+	 * Gets the values of every voxel, in voxel index order
+	 * @return The values
+	 */
+	const TArray<ElementType>& GetValues() const
+	{
+		return Values;
+	}
+
+	FORCEINLINE ElementType& operator[](const int32 InIndex)
+	{
+		return Values[InIndex];
+	}
+
+	FORCEINLINE const ElementType& operator[](const int32 InIndex) const
+	{
+		return Values[InIndex];
+	}
+
+	FORCEINLINE ElementType& operator[](const FIntVector& InCoordinate)
+	{
+		return Values[Grid.GetVoxelIndex(InCoordinate)];
+	}
+
+	FORCEINLINE const ElementType& operator[](const FIntVector& InCoordinate) const
+	{
+		return Values[Grid.GetVoxelIndex(InCoordinate)];
+	}
+
+	/**
+	 * Serializes the channel in binary, the values go to the archive as a single bulk copy
+	 * so the element type must be bulk serializable, a malformed archive sets the archive's error flag
+	 * @param Ar The archive to serialize with
+	 * @param InAttribute The channel to serialize
+	 * @return The archive
+	 */
+	friend FArchive& operator<<(FArchive& Ar, TVoxelAttribute& InAttribute)
+	{
+		Ar.UsingCustomVersion(FVoxelCustomVersion::GUID);
+
+		Ar << InAttribute.Grid;
+
+		// The grid comes straight from the archive, nothing is allocated for it until it's checked
+		if(Ar.IsLoading() && (Ar.IsError() || !IsLoadedGridValid(Ar, InAttribute.Grid)))
+		{
+			Ar.SetError();
+			InAttribute.Init(FVoxelGrid());
+			return Ar;
+		}
+
+		InAttribute.Values.BulkSerialize(Ar);
+
+		if(Ar.IsLoading() && (Ar.IsError() || InAttribute.Values.Num() != InAttribute.Grid.GetVoxelCount()))
+		{
+			Ar.SetError();
+			InAttribute.Init(FVoxelGrid());
+		}
+
+		return Ar;
+	}
+
+protected:
+	/**
+	 * Checks a loaded grid before any values are allocated for it
+	 * @param Ar The archive being loaded from
+	 * @param InGrid The loaded grid
+	 * @return true if the grid is sane and the rest of the archive is large enough to hold its values
+	 */
+	static bool IsLoadedGridValid(FArchive& Ar, const FVoxelGrid& InGrid)
+	{
+		const FVector VoxelSize = InGrid.GetVoxelSize();
+		const FIntVector Count = InGrid.GetVectorVoxelCount();
+
+		if(!(VoxelSize.X > 0.0 && VoxelSize.Y > 0.0 && VoxelSize.Z > 0.0) || Count.X < 0 || Count.Y < 0 || Count.Z < 0)
+		{
+			return false;
+		}
+
+		const int64 NumValues = int64(Count.X) * Count.Y * Count.Z;
+
+		if(NumValues > MAX_int32)
+		{
+			return false;
+		}
+
+		// A bulk copy holds its element size, its array count and every value, archives that don't know their size only get the count checks
+		const int64 TotalSize = Ar.TotalSize();
+
+		return TotalSize < 0 || 2 * int64(sizeof(int32)) + NumValues * int64(sizeof(ElementType)) <= TotalSize - Ar.Tell();
+	}
+};
@@ -0,0 +1,95 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelBox.generated.h"
+
+/**
+ * An axis aligned box of voxel coordinates
+ * Min is inclusive and Max is exclusive, so a box is empty when Max <= Min on any axis
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelBox
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FIntVector Min = FIntVector::ZeroValue;
+
+	UPROPERTY()
+	FIntVector Max = FIntVector::ZeroValue;
+
+public:
+	FVoxelBox() = default;
+	FVoxelBox(const FIntVector& InMin, const FIntVector& InMax);
+
+	static FVoxelBox FromCoordinate(const FIntVector& InCoordinate);
+
+	bool IsEmpty() const;
+	FIntVector GetSize() const;
+	int32 Num() const;
+
+	bool Contains(const FIntVector& InCoordinate) const;
+	bool Contains(const FVoxelBox& Other) const;
+	bool Intersects(const FVoxelBox& Other) const;
+
+	FVoxelBox Intersect(const FVoxelBox& Other) const;
+	FVoxelBox Union(const FVoxelBox& Other) const;
+	FVoxelBox Expand(const int32 InAmount) const;
+	FVoxelBox Expand(const FIntVector& InAmount) const;
+	FVoxelBox Translate(const FIntVector& InOffset) const;
+
+	bool operator==(const FVoxelBox& Other) const;
+	bool operator!=(const FVoxelBox& Other) const;
+
+	FString ToString() const;
+
+	friend FArchive& operator<<(FArchive& Ar, FVoxelBox& InBox)
+	{
+		Ar << InBox.Min;
+		Ar << InBox.Max;
+		return Ar;
+	}
+
+	/**
+	 * Calls a function for every coordinate in the box, X fastest
+	 * @param Function Called with each coordinate
+	 */
+	template<typename FunctionType>
+	void ForEach(FunctionType&& Function) const
+	{
+		for(int32 Z = Min.Z; Z < Max.Z; Z++)
+		{
+			for(int32 Y = Min.Y; Y < Max.Y; Y++)
+			{
+				for(int32 X = Min.X; X < Max.X; X++)
+				{
+					Function(FIntVector(X, Y, Z));
+				}
+			}
+		}
+	}
+};
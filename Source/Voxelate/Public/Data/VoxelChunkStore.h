@@ -0,0 +1,194 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelBox.h"
+#include "Data/VoxelEpochManager.h"
+#include "Data/VoxelGrid.h"
+#include "Data/VoxelOccupancy.h"
+
+/**
+ * Occupancy of a single chunk, one word per row along X, rows laid out Y then Z
+ * Rows and bits past the grid's far border are always zero
+ */
+struct VOXELATE_API FVoxelChunk
+{
+	static constexpr int32 ChunkSize = FVoxelOccupancy::ChunkSize;
+
+	uint64 Words[ChunkSize * ChunkSize] = {};
+
+	bool IsEmpty() const;
+
+	/**
+	 * Checks if a voxel is occupied
+	 * @param InLocal The coordinate relative to the chunk's first voxel
+	 * @return true if the voxel is occupied
+	 */
+	FORCEINLINE bool IsOccupied(const FIntVector& InLocal) const
+	{
+		checkSlow(InLocal.X >= 0 && InLocal.X < ChunkSize && InLocal.Y >= 0 && InLocal.Y < ChunkSize && InLocal.Z >= 0 && InLocal.Z < ChunkSize);
+
+		return (Words[InLocal.Y + InLocal.Z * ChunkSize] >> InLocal.X) & 1;
+	}
+
+	/**
+	 * Sets or clears the occupancy of a voxel
+	 * @param InLocal The coordinate relative to the chunk's first voxel
+	 * @param bOccupied The new occupancy
+	 */
+	FORCEINLINE void SetOccupied(const FIntVector& InLocal, const bool bOccupied)
+	{
+		checkSlow(InLocal.X >= 0 && InLocal.X < ChunkSize && InLocal.Y >= 0 && InLocal.Y < ChunkSize && InLocal.Z >= 0 && InLocal.Z < ChunkSize);
+
+		uint64& Word = Words[InLocal.Y + InLocal.Z * ChunkSize];
+		const uint64 Mask = uint64(1) << InLocal.X;
+		Word = bOccupied ? Word | Mask : Word & ~Mask;
+	}
+};
+
+/**
+ * One version of a chunked occupancy, a table of ref counted chunks where a null chunk is empty
+ * Published versions are immutable and shared between readers, chunks are shared between versions
+ * A version being edited clones a chunk the first time it is written, so older versions never see the change
+ */
+class VOXELATE_API FVoxelChunkMap
+{
+	friend class FVoxelChunkStore;
+
+public:
+	using FChunkPtr = TSharedPtr<FVoxelChunk, ESPMode::ThreadSafe>;
+
+protected:
+	FVoxelGrid Grid;
+	FIntVector ChunkCount = FIntVector::ZeroValue;
+	int64 Version = 0;
+
+	TArray<FChunkPtr> Chunks;
+
+	// Chunks this version cloned and may still write to, separate bools so chunks can be edited in parallel
+	TArray<bool> OwnedChunks;
+	bool bPublished = false;
+
+	// The version an edit started from, released once the edit is published
+	TSharedPtr<const FVoxelChunkMap, ESPMode::ThreadSafe> BaseVersion;
+
+public:
+	explicit FVoxelChunkMap(const FVoxelGrid& InGrid);
+
+	const FVoxelGrid& GetGrid() const;
+	int64 GetVersion() const;
+	const TSharedPtr<const FVoxelChunkMap, ESPMode::ThreadSafe>& GetBaseVersion() const;
+	FIntVector GetChunkCount() const;
+	int32 GetNumChunks() const;
+	int32 GetChunkIndex(const FIntVector& InChunkCoordinate) const;
+	FIntVector GetChunkCoordinate(const int32 InChunkIndex) const;
+	FVoxelBox GetChunkBox(const FIntVector& InChunkCoordinate) const;
+
+	const FVoxelChunk* GetChunk(const FIntVector& InChunkCoordinate) const;
+	FVoxelChunk& GetMutableChunk(const FIntVector& InChunkCoordinate);
+	void ClearChunk(const FIntVector& InChunkCoordinate);
+
+	bool IsOccupied(const FIntVector& InCoordinate) const;
+	void SetOccupied(const FIntVector& InCoordinate, const bool bOccupied);
+	int32 CountOccupied(const FVoxelBox& InVoxelBox) const;
+
+	void CopyFrom(const FVoxelOccupancy& InOccupancy);
+	FVoxelOccupancy ToOccupancy() const;
+	void CopyChunkTo(const FIntVector& InChunkCoordinate, FVoxelOccupancy& OutOccupancy) const;
+	TArray<FIntVector> GetChangedChunks(const FVoxelChunkMap& Other) const;
+};
+
+/**
+ * Chunked occupancy shared between reader and writer threads through copy on write versions
+ * Readers take a snapshot, a pointer to the current immutable version, and keep reading it for as long as they like
+ * Writers begin an edit on a copy of the current chunk table, clone only the chunks they touch and commit,
+ * which publishes the edit as the new current version in a single pointer swap
+ * Replaced versions are kept as undo history, which costs only the chunks that differ between versions
+ *
+ * Short lived readers, like a frame's query batch, use a read scope instead of a snapshot,
+ * which pins an epoch and reads the current version through a plain pointer, without locks or reference counting
+ * A replaced version is retired rather than released, so it stays alive until every reader pinned before it has finished
+ */
+class VOXELATE_API FVoxelChunkStore : public FNoncopyable
+{
+public:
+	using FMapPtr = TSharedPtr<const FVoxelChunkMap, ESPMode::ThreadSafe>;
+	using FEditPtr = TSharedRef<FVoxelChunkMap, ESPMode::ThreadSafe>;
+
+	/**
+	 * Reads the current version without locking, the version stays valid for as long as the scope is alive
+	 * Meant for one batch of queries, a scope held for long delays freeing every version replaced meanwhile
+	 */
+	class VOXELATE_API FReadScope : public FNoncopyable
+	{
+	protected:
+		FVoxelEpochManager::FPin Pin;
+		const FVoxelChunkMap* Map = nullptr;
+
+	public:
+		explicit FReadScope(const FVoxelChunkStore& InStore);
+
+		const FVoxelChunkMap& Get() const;
+		const FVoxelChunkMap* operator->() const;
+	};
+
+protected:
+	// Guards the pointers below, only held for the time it takes to swap or copy them
+	mutable FCriticalSection Lock;
+
+	FMapPtr Current;
+	TArray<FMapPtr> UndoHistory;
+	TArray<FMapPtr> RedoHistory;
+
+	int32 MaxHistory = 16;
+	int64 NextVersion = 1;
+
+	// Readers pin epochs here, replaced versions are retired here
+	mutable FVoxelEpochManager Epochs;
+
+	// The current version for read scopes, kept alive by Current or, once replaced, by its retire entry
+	std::atomic<const FVoxelChunkMap*> CurrentMap{nullptr};
+
+public:
+	explicit FVoxelChunkStore(const FVoxelGrid& InGrid, const int32 InMaxHistory = 16);
+	explicit FVoxelChunkStore(const FVoxelOccupancy& InOccupancy, const int32 InMaxHistory = 16);
+
+	FMapPtr GetSnapshot() const;
+	int64 GetVersion() const;
+
+	FEditPtr BeginEdit() const;
+	bool Commit(const FEditPtr& InEdit);
+
+	bool Undo();
+	bool Redo();
+	int32 GetNumUndo() const;
+	int32 GetNumRedo() const;
+
+	int32 Reclaim();
+
+protected:
+	void Publish(const FMapPtr& InMap);
+};
@@ -0,0 +1,94 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ * Epoch based reclamation, lets readers use shared data without locks or reference counting
+ * A reader pins the current epoch for as long as it reads, a writer that replaces data retires the old data
+ * under the current epoch and advances it, retired data is reclaimed once every pinned reader has moved past that epoch
+ *
+ * Readers only ever write to their own cache line, so pinning doesn't contend with other readers
+ */
+class VOXELATE_API FVoxelEpochManager : public FNoncopyable
+{
+public:
+	// Number of readers that can be pinned at once, further readers wait for a free slot
+	static constexpr int32 MaxReaders = 128;
+
+	/**
+	 * Keeps an epoch pinned for as long as it is alive
+	 */
+	class VOXELATE_API FPin : public FNoncopyable
+	{
+		friend class FVoxelEpochManager;
+
+	protected:
+		FVoxelEpochManager* Manager = nullptr;
+		int32 Slot = INDEX_NONE;
+
+		FPin(FVoxelEpochManager* InManager, const int32 InSlot);
+
+	public:
+		FPin(FPin&& Other);
+		~FPin();
+
+		void Release();
+	};
+
+protected:
+	// A reader's pinned epoch, 0 when the slot is free, one cache line each
+	struct alignas(PLATFORM_CACHE_LINE_SIZE) FSlot
+	{
+		std::atomic<uint64> Epoch{0};
+	};
+
+	struct FRetired
+	{
+		uint64 Epoch = 0;
+		TFunction<void()> Reclaim;
+	};
+
+	std::atomic<uint64> GlobalEpoch{1};
+	FSlot Slots[MaxReaders];
+
+	FCriticalSection RetiredLock;
+	TArray<FRetired> Retired;
+
+public:
+	FVoxelEpochManager() = default;
+	~FVoxelEpochManager();
+
+	FPin Pin();
+
+	void Retire(TFunction<void()>&& InReclaim);
+	int32 Reclaim();
+	int32 GetNumRetired();
+
+protected:
+	uint64 GetMinPinnedEpoch() const;
+};
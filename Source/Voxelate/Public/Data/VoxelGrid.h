@@ -25,11 +25,14 @@
 #pragma once
 
 #include "CoreMinimal.h"
-
+#include "Data/VoxelBox.h"
+#include "VoxelGrid.generated.h"
 
 /**
  * This struct handles the logic for working with a voxel grid
  * It does not handle the actual voxel data, just the grid itself
+ * Every grid with the same voxel size sits on one global lattice anchored at the world origin,
+ * so sub grids and chunks line up with their parent exactly
  */
 USTRUCT()
 struct VOXELATE_API FVoxelGrid
@@ -46,12 +49,21 @@ protected:
 	UPROPERTY()
 	FIntVector VoxelCount = FIntVector::ZeroValue;
 
+	// Lattice coordinate of the first voxel, in voxels from the world origin
+	UPROPERTY()
+	FIntVector LatticeOrigin = FIntVector::ZeroValue;
+
 public:
 	FVoxelGrid() = default;
 	FVoxelGrid(const FVector& InVoxelSize, const FBox& InBounds);
+	FVoxelGrid(const FVector& InVoxelSize, const FIntVector& InLatticeOrigin, const FIntVector& InVoxelCount);
 	void Init(const FVector& InVoxelSize, const FBox& InBounds);
+	void Init(const FVector& InVoxelSize, const FIntVector& InLatticeOrigin, const FIntVector& InVoxelCount);
 
 	FBox GetBounds() const;
+	FVector GetVoxelSize() const;
+	FIntVector GetLatticeOrigin() const;
+	FIntVector GetLatticeCoordinate(const FVector& InLocation) const;
 	
 	int32 GetVoxelCount() const;
 	FIntVector GetVectorVoxelCount() const;
@@ -70,8 +82,33 @@ public:
 	FBox GetVoxelBounds(const FIntVector& InCoordinate) const;
 	FBox GetVoxelBounds(const FVector& InLocation) const;
 	
+	FVoxelBox GetVoxelBox() const;
+	FVoxelBox GetVoxelBox(const FBox& InBounds) const;
+	FBox GetBounds(const FVoxelBox& InVoxelBox) const;
+	
 	TArray<int32> GetVoxelIndicesFromBounds(const FBox& InBounds) const;
 	TArray<FIntVector> GetVoxelCoordinatesFromBounds(const FBox& InBounds) const;
 	
 	FVoxelGrid GetSubGrid(const FBox& InBounds) const;
+	FVoxelGrid GetSubGrid(const FIntVector& InOffset, const FIntVector& InVoxelCount) const;
+
+	bool operator==(const FVoxelGrid& Other) const;
+	bool operator!=(const FVoxelGrid& Other) const;
+
+	bool Serialize(FArchive& Ar);
+
+	friend FArchive& operator<<(FArchive& Ar, FVoxelGrid& InGrid)
+	{
+		InGrid.Serialize(Ar);
+		return Ar;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FVoxelGrid> : public TStructOpsTypeTraitsBase2<FVoxelGrid>
+{
+	enum
+	{
+		WithSerializer = true
+	};
 };
\ No newline at end of file
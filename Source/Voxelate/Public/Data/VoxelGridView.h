@@ -0,0 +1,129 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelGrid.h"
+#include "VoxelGridView.generated.h"
+
+/**
+ * A window into a parent voxel grid, defined by an integer offset and voxel count on the parent's lattice
+ * The view doesn't own any voxel data, it maps its local coordinates and indices to the parent's
+ * so workers can read and write their slice of the parent's storage in place
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelGridView
+{
+	GENERATED_BODY()
+
+protected:
+	UPROPERTY()
+	FVoxelGrid ParentGrid;
+
+	UPROPERTY()
+	FIntVector Offset = FIntVector::ZeroValue;
+
+	UPROPERTY()
+	FIntVector VoxelCount = FIntVector::ZeroValue;
+
+	// Index strides of the parent grid along Y and Z, properties so reflected copies and serialization keep them
+	UPROPERTY()
+	int32 ParentStrideY = 0;
+
+	UPROPERTY()
+	int32 ParentStrideZ = 0;
+
+public:
+	FVoxelGridView() = default;
+	FVoxelGridView(const FVoxelGrid& InParentGrid, const FIntVector& InOffset, const FIntVector& InVoxelCount);
+
+	const FVoxelGrid& GetParentGrid() const;
+	FVoxelGrid GetGrid() const;
+
+	FIntVector GetOffset() const;
+	FIntVector GetVectorVoxelCount() const;
+	int32 GetVoxelCount() const;
+
+	bool IsVoxelCoordinateValid(const FIntVector& InCoordinate) const;
+	bool ContainsParentCoordinate(const FIntVector& InParentCoordinate) const;
+	FIntVector GetLocalCoordinate(const FIntVector& InParentCoordinate) const;
+
+	/**
+	 * Maps a local coordinate to the parent's coordinate
+	 * @param InCoordinate The coordinate in the view
+	 * @return The coordinate in the parent grid
+	 */
+	FORCEINLINE FIntVector GetParentCoordinate(const FIntVector& InCoordinate) const
+	{
+		return Offset + InCoordinate;
+	}
+
+	/**
+	 * Maps a local coordinate to the parent's voxel index
+	 * @param InCoordinate The coordinate in the view, must be valid
+	 * @return The voxel index in the parent grid
+	 */
+	FORCEINLINE int32 GetParentIndex(const FIntVector& InCoordinate) const
+	{
+		checkSlow(IsVoxelCoordinateValid(InCoordinate));
+
+		return (Offset.X + InCoordinate.X) + (Offset.Y + InCoordinate.Y) * ParentStrideY + (Offset.Z + InCoordinate.Z) * ParentStrideZ;
+	}
+
+	/**
+	 * Maps a local voxel index to the parent's voxel index
+	 * @param InIndex The voxel index in the view, must be valid
+	 * @return The voxel index in the parent grid
+	 */
+	FORCEINLINE int32 GetParentIndex(const int32 InIndex) const
+	{
+		const int32 Z = InIndex / (VoxelCount.X * VoxelCount.Y);
+		const int32 Y = (InIndex - Z * VoxelCount.X * VoxelCount.Y) / VoxelCount.X;
+		const int32 X = InIndex - Z * VoxelCount.X * VoxelCount.Y - Y * VoxelCount.X;
+
+		return GetParentIndex(FIntVector(X, Y, Z));
+	}
+
+	/**
+	 * Calls a function for every voxel of the view, row by row
+	 * @param Function Called with the local coordinate and the parent's voxel index
+	 */
+	template<typename FunctionType>
+	void ForEachVoxel(FunctionType&& Function) const
+	{
+		for(int32 Z = 0; Z < VoxelCount.Z; Z++)
+		{
+			for(int32 Y = 0; Y < VoxelCount.Y; Y++)
+			{
+				const int32 RowIndex = GetParentIndex(FIntVector(0, Y, Z));
+
+				for(int32 X = 0; X < VoxelCount.X; X++)
+				{
+					Function(FIntVector(X, Y, Z), RowIndex + X);
+				}
+			}
+		}
+	}
+};
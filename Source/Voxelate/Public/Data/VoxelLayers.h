@@ -0,0 +1,66 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelAttribute.h"
+#include "Data/VoxelOccupancy.h"
+
+/**
+ * Occupancy of several layers over the same voxel grid, interleaved as one mask word per voxel
+ * Bit N of a voxel's mask is set when the voxel is occupied in layer N
+ */
+struct VOXELATE_API FVoxelLayers : public TVoxelAttribute<uint16>
+{
+	// Number of layers that fit in a voxel's mask
+	static constexpr int32 MaxLayers = 16;
+
+protected:
+	TArray<FName> LayerNames;
+
+public:
+	FVoxelLayers() = default;
+	FVoxelLayers(const FVoxelGrid& InGrid, const TArray<FName>& InLayerNames);
+
+	int32 NumLayers() const;
+	const TArray<FName>& GetLayerNames() const;
+	int32 FindLayer(const FName InLayerName) const;
+
+	int32 CountOccupied(const int32 InLayer) const;
+	FVoxelOccupancy GetLayer(const int32 InLayer) const;
+
+	/**
+	 * Checks if a voxel is occupied in a layer, the coordinate must be valid
+	 * @param InCoordinate The voxel coordinate
+	 * @param InLayer The layer
+	 * @return true if the voxel is occupied
+	 */
+	FORCEINLINE bool IsOccupied(const FIntVector& InCoordinate, const int32 InLayer) const
+	{
+		checkSlow(InLayer >= 0 && InLayer < LayerNames.Num());
+
+		return ((*this)[InCoordinate] >> InLayer) & 1;
+	}
+};
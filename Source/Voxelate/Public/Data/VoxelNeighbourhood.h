@@ -0,0 +1,124 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelGrid.h"
+#include "Data/VoxelOccupancy.h"
+#include "VoxelNeighbourhood.generated.h"
+
+/**
+ * Which neighbours of a voxel are considered connected to it
+ */
+UENUM()
+enum class EVoxelConnectivity : uint8
+{
+	Face		= 6,
+	Edge		= 18,
+	Vertex		= 26
+};
+
+/**
+ * Neighbour offsets for a voxel grid, precomputed both as coordinate offsets and as index strides
+ * Voxels away from the grid's border are visited with index arithmetic only, no bounds checks
+ *
+ * Neighbourhood masks pack the 3x3x3 block around a voxel into 27 bits,
+ * bit (X + 1) + (Y + 1) * 3 + (Z + 1) * 9 is the voxel at offset (X, Y, Z)
+ */
+struct VOXELATE_API FVoxelNeighbourhood
+{
+	// Bit of the voxel itself in a neighbourhood mask
+	static constexpr uint32 CenterMask = 1u << 13;
+	// Bits of the 6 face neighbours in a neighbourhood mask
+	static constexpr uint32 FaceMask = (1u << 4) | (1u << 10) | (1u << 12) | (1u << 14) | (1u << 16) | (1u << 22);
+	// Bits of the 26 neighbours in a neighbourhood mask
+	static constexpr uint32 VertexMask = ((1u << 27) - 1) & ~CenterMask;
+	// Bits of the 8 corner neighbours in a neighbourhood mask
+	static constexpr uint32 CornerMask = (1u << 0) | (1u << 2) | (1u << 6) | (1u << 8) | (1u << 18) | (1u << 20) | (1u << 24) | (1u << 26);
+	// Bits of the 18 face and edge neighbours in a neighbourhood mask
+	static constexpr uint32 EdgeMask = VertexMask & ~CornerMask;
+
+protected:
+	FIntVector VoxelCount = FIntVector::ZeroValue;
+
+	TArray<FIntVector, TFixedAllocator<26>> Offsets;
+	TArray<int32, TFixedAllocator<26>> IndexOffsets;
+
+public:
+	FVoxelNeighbourhood(const FVoxelGrid& InGrid, const EVoxelConnectivity InConnectivity);
+
+	int32 Num() const;
+	const FIntVector& GetOffset(const int32 InNeighbour) const;
+	int32 GetIndexOffset(const int32 InNeighbour) const;
+
+	static int32 GetMaskBit(const FIntVector& InOffset);
+	static uint32 GetConnectivityMask(const EVoxelConnectivity InConnectivity);
+
+	static void GatherRow(const FVoxelOccupancy& InOccupancy, const int32 Y, const int32 Z, TArray<uint32>& OutMasks,
+		const bool bOutsideIsOccupied = false);
+	static void GatherWord(const FVoxelOccupancy& InOccupancy, const int32 Word, const int32 Y, const int32 Z, uint32* OutMasks,
+		const bool bOutsideIsOccupied = false);
+
+	/**
+	 * Calls a function for every neighbour of a voxel that is inside the grid
+	 * @param InCoordinate The voxel coordinate, must be valid
+	 * @param Function Called with the neighbour's coordinate and index
+	 */
+	template<typename FunctionType>
+	FORCEINLINE void ForEachNeighbour(const FIntVector& InCoordinate, FunctionType&& Function) const
+	{
+		checkSlow(InCoordinate.X >= 0 && InCoordinate.X < VoxelCount.X &&
+			InCoordinate.Y >= 0 && InCoordinate.Y < VoxelCount.Y &&
+			InCoordinate.Z >= 0 && InCoordinate.Z < VoxelCount.Z);
+
+		const int32 Index = InCoordinate.X + InCoordinate.Y * VoxelCount.X + InCoordinate.Z * VoxelCount.X * VoxelCount.Y;
+
+		const bool bIsInterior = InCoordinate.X > 0 && InCoordinate.X < VoxelCount.X - 1 &&
+			InCoordinate.Y > 0 && InCoordinate.Y < VoxelCount.Y - 1 &&
+			InCoordinate.Z > 0 && InCoordinate.Z < VoxelCount.Z - 1;
+
+		if(bIsInterior)
+		{
+			for(int32 Neighbour = 0; Neighbour < Offsets.Num(); Neighbour++)
+			{
+				Function(InCoordinate + Offsets[Neighbour], Index + IndexOffsets[Neighbour]);
+			}
+
+			return;
+		}
+
+		for(int32 Neighbour = 0; Neighbour < Offsets.Num(); Neighbour++)
+		{
+			const FIntVector Coordinate = InCoordinate + Offsets[Neighbour];
+
+			if(Coordinate.X >= 0 && Coordinate.X < VoxelCount.X &&
+				Coordinate.Y >= 0 && Coordinate.Y < VoxelCount.Y &&
+				Coordinate.Z >= 0 && Coordinate.Z < VoxelCount.Z)
+			{
+				Function(Coordinate, Index + IndexOffsets[Neighbour]);
+			}
+		}
+	}
+};
@@ -0,0 +1,147 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelGrid.h"
+#include "VoxelOccupancy.generated.h"
+
+/**
+ * Bit packed occupancy for every voxel of a voxel grid
+ * Each row along X is stored as whole 64 bit words, so 64 voxels along X share a word
+ * The grid is split into cubic chunks of ChunkSize voxels, one word per chunk row
+ * Padding bits past the end of a row are always zero
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelOccupancy
+{
+	GENERATED_BODY()
+
+	// Voxels along each axis of a chunk, matches the number of bits in a word
+	static constexpr int32 ChunkSize = 64;
+
+protected:
+	UPROPERTY()
+	FVoxelGrid Grid;
+
+	UPROPERTY()
+	int32 WordsPerRow = 0;
+
+	UPROPERTY()
+	TArray<uint64> Words;
+
+public:
+	FVoxelOccupancy() = default;
+	FVoxelOccupancy(const FVoxelGrid& InGrid);
+	FVoxelOccupancy(const FVoxelGrid& InGrid, const TArray<bool>& InVoxels);
+	void Init(const FVoxelGrid& InGrid);
+
+	static bool IsGridValid(const FVoxelGrid& InGrid);
+
+	const FVoxelGrid& GetGrid() const;
+	int32 GetWordsPerRow() const;
+	int32 GetNumRows() const;
+
+	TArray<uint64>& GetWords();
+	const TArray<uint64>& GetWords() const;
+
+	int32 CountOccupied() const;
+	int32 CountOccupied(const FVoxelBox& InVoxelBox) const;
+	TArray<bool> ToArray() const;
+
+	FVoxelOccupancy GetSubOccupancy(const FVoxelBox& InVoxelBox) const;
+	void CopyVoxels(const FVoxelOccupancy& InSource, const FIntVector& InSourceMin, const FVoxelBox& InVoxelBox);
+
+	FIntVector GetChunkCount() const;
+	int32 GetNumChunks() const;
+	int32 GetChunkIndex(const FIntVector& InChunkCoordinate) const;
+	FIntVector GetChunkCoordinate(const int32 InChunkIndex) const;
+	void GetChunkVoxelRange(const FIntVector& InChunkCoordinate, FIntVector& OutMin, FIntVector& OutMax) const;
+	FVoxelBox GetChunkBox(const FIntVector& InChunkCoordinate) const;
+	FVoxelBox GetChunkBox(const FVoxelBox& InVoxelBox) const;
+	bool IsChunkEmpty(const FIntVector& InChunkCoordinate) const;
+
+	void GetChunkWords(const FIntVector& InChunkCoordinate, TArray<uint64>& OutWords) const;
+	void SetChunkWords(const FIntVector& InChunkCoordinate, TConstArrayView<uint64> InWords);
+	void CompressChunk(const FIntVector& InChunkCoordinate, const FName InFormat, TArray<uint8>& OutBlock) const;
+	bool UncompressChunk(const FIntVector& InChunkCoordinate, const FName InFormat, TConstArrayView<uint8> InBlock);
+
+	bool LineTraceVoxels(const FVector& InStart, const FVector& InEnd) const;
+
+	bool Serialize(FArchive& Ar);
+	void Serialize(FArchive& Ar, const FName InCompressionFormat);
+
+	friend FArchive& operator<<(FArchive& Ar, FVoxelOccupancy& InOccupancy)
+	{
+		InOccupancy.Serialize(Ar);
+		return Ar;
+	}
+
+	/**
+	 * Gets the index of the first word of a row
+	 * @param Y The row's Y coordinate
+	 * @param Z The row's Z coordinate
+	 * @return The index into the word array
+	 */
+	FORCEINLINE int32 GetRowWordIndex(const int32 Y, const int32 Z) const
+	{
+		return (Y + Z * Grid.GetVectorVoxelCount().Y) * WordsPerRow;
+	}
+
+	/**
+	 * Checks if a voxel is occupied, the coordinate must be valid
+	 * @param InCoordinate The voxel coordinate
+	 * @return true if the voxel is occupied
+	 */
+	FORCEINLINE bool IsOccupied(const FIntVector& InCoordinate) const
+	{
+		checkSlow(Grid.IsVoxelCoordinateValid(InCoordinate));
+
+		return (Words[GetRowWordIndex(InCoordinate.Y, InCoordinate.Z) + (InCoordinate.X >> 6)] >> (InCoordinate.X & 63)) & 1;
+	}
+
+	/**
+	 * Sets or clears the occupancy of a voxel, the coordinate must be valid
+	 * @param InCoordinate The voxel coordinate
+	 * @param bOccupied The new occupancy
+	 */
+	FORCEINLINE void SetOccupied(const FIntVector& InCoordinate, const bool bOccupied)
+	{
+		checkSlow(Grid.IsVoxelCoordinateValid(InCoordinate));
+
+		uint64& Word = Words[GetRowWordIndex(InCoordinate.Y, InCoordinate.Z) + (InCoordinate.X >> 6)];
+		const uint64 Mask = uint64(1) << (InCoordinate.X & 63);
+		Word = bOccupied ? Word | Mask : Word & ~Mask;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FVoxelOccupancy> : public TStructOpsTypeTraitsBase2<FVoxelOccupancy>
+{
+	enum
+	{
+		WithSerializer = true
+	};
+};
\ No newline at end of file
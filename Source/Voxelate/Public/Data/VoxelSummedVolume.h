@@ -0,0 +1,71 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelBox.h"
+#include "Data/VoxelGrid.h"
+#include "Data/VoxelOccupancy.h"
+
+/**
+ * Summed volume table over an occupancy, counts the occupied voxels of any box in 8 lookups per chunk it touches
+ * Every chunk of the occupancy gets its own table of inclusive prefix sums, so a changed chunk is rebuilt on its own
+ * Chunks without any occupied voxel have no table at all
+ */
+struct VOXELATE_API FVoxelSummedVolume
+{
+	// Voxels along each axis of a chunk, matches the occupancy's chunks
+	static constexpr int32 ChunkSize = FVoxelOccupancy::ChunkSize;
+
+protected:
+	FVoxelGrid Grid;
+
+	FIntVector ChunkCount = FIntVector::ZeroValue;
+
+	// Prefix sums of every chunk, padded with a layer of zeros on the low side of each axis
+	TArray<TArray<uint32>> Tables;
+
+public:
+	FVoxelSummedVolume() = default;
+	explicit FVoxelSummedVolume(const FVoxelOccupancy& InOccupancy);
+
+	void Build(const FVoxelOccupancy& InOccupancy);
+	void UpdateChunk(const FVoxelOccupancy& InOccupancy, const FIntVector& InChunkCoordinate);
+	void UpdateVoxels(const FVoxelOccupancy& InOccupancy, const FVoxelBox& InVoxelBox);
+
+	const FVoxelGrid& GetGrid() const;
+	SIZE_T GetAllocatedSize() const;
+
+	int64 CountOccupied(const FVoxelBox& InVoxelBox) const;
+	int64 CountOccupied(const FBox& InBounds) const;
+	bool IsFree(const FVoxelBox& InVoxelBox) const;
+	bool IsFree(const FBox& InBounds) const;
+
+protected:
+	FIntVector GetChunkSize(const FIntVector& InChunkCoordinate) const;
+	int32 GetChunkIndex(const FIntVector& InChunkCoordinate) const;
+	void BuildChunk(const FVoxelOccupancy& InOccupancy, const FIntVector& InChunkCoordinate, TArray<uint32>& OutTable) const;
+	int64 CountChunk(const FIntVector& InChunkCoordinate, const FVoxelBox& InLocalBox) const;
+};
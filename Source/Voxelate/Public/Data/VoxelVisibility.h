@@ -0,0 +1,78 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelVisibility.generated.h"
+
+/**
+ * Potentially visible set between the chunks of a voxel occupancy
+ * Each chunk owns a bitset with one bit per chunk, set if that chunk may be visible from it
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelVisibility
+{
+	GENERATED_BODY()
+
+protected:
+	UPROPERTY()
+	int32 NumChunks = 0;
+
+	UPROPERTY()
+	int32 WordsPerChunk = 0;
+
+	UPROPERTY()
+	TArray<uint64> Bits;
+
+public:
+	FVoxelVisibility() = default;
+	FVoxelVisibility(const int32 InNumChunks);
+	void Init(const int32 InNumChunks);
+
+	int32 GetNumChunks() const;
+
+	bool IsVisible(const int32 InFromChunk, const int32 InToChunk) const;
+	void SetVisible(const int32 InFromChunk, const int32 InToChunk);
+
+	TConstArrayView<uint64> GetVisibleSet(const int32 InFromChunk) const;
+	TArray<int32> GetVisibleChunks(const int32 InFromChunk) const;
+
+	bool Serialize(FArchive& Ar);
+
+	friend FArchive& operator<<(FArchive& Ar, FVoxelVisibility& InVisibility)
+	{
+		InVisibility.Serialize(Ar);
+		return Ar;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FVoxelVisibility> : public TStructOpsTypeTraitsBase2<FVoxelVisibility>
+{
+	enum
+	{
+		WithSerializer = true
+	};
+};
@@ -0,0 +1,93 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelOccupancy.h"
+#include "VoxelAgentBaker.generated.h"
+
+/**
+ * Size and climbing ability of a kind of navigation agent
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelAgentProfile
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FName Name;
+
+	// Radius of the agent, obstacles are grown by it on the horizontal plane
+	UPROPERTY()
+	double Radius = 35.0;
+
+	// Free space the agent needs above the floor
+	UPROPERTY()
+	double Height = 180.0;
+
+	// Steepest walkable slope in degrees, 90 or more disables the slope filter
+	UPROPERTY()
+	double MaxSlope = 45.0;
+
+	// Highest ledge the agent can step onto, obstacles are only grown by the radius above it so stairs and ramps stay walkable
+	UPROPERTY()
+	double MaxStepHeight = 35.0;
+
+public:
+	FVoxelAgentProfile() = default;
+	FVoxelAgentProfile(const FName InName, const double InRadius, const double InHeight, const double InMaxSlope,
+		const double InMaxStepHeight = 35.0);
+};
+
+/**
+ * Bakes a walkable layer per agent profile from a single shared occupancy
+ * A walkable voxel is an empty voxel standing on an occupied one with room for the agent around and above it
+ * Every pass is bitwise over whole rows (64 voxels along X per word) and runs over Z slices in parallel,
+ * profiles are baked in parallel too
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelAgentBaker
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FVoxelAgentProfile> Profiles;
+
+public:
+	FVoxelAgentBaker() = default;
+	FVoxelAgentBaker(const TArray<FVoxelAgentProfile>& InProfiles);
+
+	TArray<FVoxelOccupancy> Bake(const FVoxelOccupancy& InOccupancy) const;
+
+	static FVoxelOccupancy BakeProfile(const FVoxelOccupancy& InOccupancy, const FVoxelAgentProfile& InProfile);
+	static void UpdateProfile(const FVoxelOccupancy& InOccupancy, const FVoxelAgentProfile& InProfile, const FVoxelBox& InVoxelBox,
+		FVoxelOccupancy& InOutWalkable);
+	static FIntVector GetKernelRadius(const FVoxelGrid& InGrid, const FVoxelAgentProfile& InProfile);
+
+	static FVoxelOccupancy Dilate(const FVoxelOccupancy& InOccupancy, const int32 InRadiusX, const int32 InRadiusY);
+	static FVoxelOccupancy GetClearFloor(const FVoxelOccupancy& InOccupancy, const FVoxelOccupancy& InDilated, const int32 InHeight,
+		const int32 InClimb);
+	static void FilterSlope(const FVoxelOccupancy& InOccupancy, const int32 InDistance, const int32 InMaxRise, FVoxelOccupancy& InOutWalkable);
+};
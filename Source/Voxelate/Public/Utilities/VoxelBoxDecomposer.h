@@ -0,0 +1,77 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/OOBBoxProxy.h"
+#include "Data/VoxelBox.h"
+#include "Data/VoxelOccupancy.h"
+#include "PhysicsEngine/BoxElem.h"
+#include "VoxelBoxDecomposer.generated.h"
+
+class UBodySetup;
+
+/**
+ * Covers occupied voxels with a small set of boxes, for cheap proxy collision of complex meshes
+ * Boxes are grown greedily: from the first uncovered voxel in scan order a box is grown one slab at a time along each
+ * axis order, and the largest result is kept. Slabs are checked a word at a time with masked bit counts
+ *
+ * Voxelate the mesh on a grid in its local space to write the boxes back to its body setup
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelBoxDecomposer
+{
+	GENERATED_BODY()
+
+	// Lets boxes grow through voxels other boxes already cover, which usually needs far fewer boxes
+	UPROPERTY()
+	bool bAllowOverlap = true;
+
+	// Boxes with fewer voxels are dropped, removes slivers at the cost of leaving some voxels uncovered
+	UPROPERTY()
+	int32 MinBoxVoxels = 1;
+
+	// Only the largest boxes are kept, 0 keeps every box
+	UPROPERTY()
+	int32 MaxBoxes = 0;
+
+public:
+	FVoxelBoxDecomposer() = default;
+	FVoxelBoxDecomposer(const bool bInAllowOverlap, const int32 InMinBoxVoxels = 1, const int32 InMaxBoxes = 0);
+
+	TArray<FVoxelBox> Decompose(const FVoxelOccupancy& InOccupancy) const;
+	TArray<FVoxelBox> Decompose(const FVoxelOccupancy& InOccupancy, const FVoxelBox& InRegion) const;
+	TArray<TArray<FVoxelBox>> DecomposeComponents(const FVoxelOccupancy& InOccupancy) const;
+
+	static TArray<FOOBBoxProxy> ToOrientedBoxes(const FVoxelGrid& InGrid, const TArray<FVoxelBox>& InBoxes, const FTransform& InTransform);
+	static TArray<FKBoxElem> ToBoxElements(const FVoxelGrid& InGrid, const TArray<FVoxelBox>& InBoxes);
+	static void ApplyToBodySetup(UBodySetup* InOutBodySetup, const FVoxelGrid& InGrid, const TArray<FVoxelBox>& InBoxes,
+		const bool bUseSimpleAsComplex = true);
+
+private:
+	TArray<FVoxelBox> GrowBoxes(const FVoxelOccupancy& InOccupancy, const FVoxelBox& InRegion, const bool bInAllowOverlap) const;
+	void FilterBoxes(TArray<FVoxelBox>& InOutBoxes) const;
+	static TArray<TArray<FVoxelBox>> GroupTouchingBoxes(const TArray<FVoxelBox>& InBoxes);
+};
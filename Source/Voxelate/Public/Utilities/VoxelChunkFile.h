@@ -0,0 +1,77 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelGrid.h"
+#include "Data/VoxelOccupancy.h"
+
+/**
+ * Chunk files hold the chunks of a voxel occupancy as independent blocks, written by FVoxelChunkWriter
+ *
+ * Layout:
+ * - Header: magic, version, grid, compression format, number of chunks
+ * - Chunk blocks as made by FVoxelOccupancy::CompressChunk, in the order they were written
+ * - Chunk table: offset and size of every chunk's block, offset INDEX_NONE for chunks that weren't written
+ * - Footer: offset of the chunk table, magic
+ *
+ * A file doesn't have to hold every chunk, and a file written for a chunk aligned sub grid can be merged into its parent,
+ * which is how distributed voxelation hands results back
+ */
+struct VOXELATE_API FVoxelChunkFile
+{
+	// "VXCK"
+	static constexpr uint32 Magic = 0x4B435856;
+	// Table offset and magic at the end of the file
+	static constexpr int64 FooterSize = sizeof(int64) + sizeof(uint32);
+
+	/**
+	 * Where a chunk's block lives in the file
+	 */
+	struct FEntry
+	{
+		int64 Offset = INDEX_NONE;
+		int32 Size = 0;
+
+		friend FArchive& operator<<(FArchive& Ar, FEntry& InEntry)
+		{
+			Ar << InEntry.Offset;
+			Ar << InEntry.Size;
+			return Ar;
+		}
+	};
+
+	static bool SerializeHeader(FArchive& Ar, FVoxelGrid& InOutGrid, FName& InOutCompressionFormat, int32& InOutNumChunks);
+	static bool ReadTable(FArchive& Ar, FVoxelGrid& OutGrid, FName& OutCompressionFormat, TArray<FEntry>& OutTable);
+	static void WriteTable(FArchive& Ar, TArray<FEntry>& InTable, int64 InTableOffset);
+
+	static bool GetChunkOffset(const FVoxelGrid& InParentGrid, const FVoxelGrid& InGrid, FIntVector& OutChunkOffset);
+
+	static bool ReadChunks(const FString& InFilename, FVoxelOccupancy& InOutOccupancy);
+	static bool Merge(const TArray<FString>& InFilenames, const FVoxelGrid& InGrid, const FString& InFilename);
+
+private:
+	static FIntVector GetChunkCount(const FVoxelGrid& InGrid);
+};
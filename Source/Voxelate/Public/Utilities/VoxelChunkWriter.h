@@ -0,0 +1,74 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelOccupancy.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Tasks/Task.h"
+#include "Utilities/VoxelChunkFile.h"
+
+/**
+ * Streams the chunks of an occupancy to a chunk file while the occupancy is still being filled
+ * Submitted chunks are compressed on worker threads and a single IO stage writes the blocks in submission order,
+ * so saving overlaps with whatever produces the chunks instead of running after it
+ *
+ * A submitted chunk must not be modified until the writer is closed, other chunks can be written to freely
+ * At most MaxChunksInFlight chunks are compressed or waiting on the IO stage at once, WriteChunk blocks when the limit is hit,
+ * which caps the writer's memory at around MaxChunksInFlight * 64 KB
+ */
+class VOXELATE_API FVoxelChunkWriter : public FNoncopyable
+{
+protected:
+	const FVoxelOccupancy& Occupancy;
+
+	FName CompressionFormat;
+	int32 MaxChunksInFlight = 64;
+
+	// Only touched by the IO stage while the file is open, one IO task runs at a time
+	TUniquePtr<IFileHandle> FileHandle;
+	int64 FileOffset = 0;
+	TArray<FVoxelChunkFile::FEntry> ChunkTable;
+	bool bHasError = false;
+
+	// IO tasks still running, oldest first
+	TArray<UE::Tasks::FTask> WritesInFlight;
+
+public:
+	FVoxelChunkWriter(const FVoxelOccupancy& InOccupancy, const FName InCompressionFormat = NAME_Oodle, const int32 InMaxChunksInFlight = 64);
+	~FVoxelChunkWriter();
+
+	bool Open(const FString& InFilename);
+	bool IsOpen() const;
+
+	void WriteChunk(const FIntVector& InChunkCoordinate);
+	void WriteChunks(const FVoxelBox& InChunkBox);
+	void WriteAllChunks();
+
+	bool Close();
+
+protected:
+	void WriteBlock(const int32 InChunkIndex, const TArray<uint8>& InBlock);
+};
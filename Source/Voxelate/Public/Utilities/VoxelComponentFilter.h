@@ -0,0 +1,81 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Templates/SubclassOf.h"
+#include "VoxelComponentFilter.generated.h"
+
+class UPrimitiveComponent;
+
+/**
+ * Decides which primitive components count as navigable geometry
+ * Components are gathered from every level of a world and filtered in parallel into a compact candidate list,
+ * so triggers, UI and effects never reach the rasterizers
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelComponentFilter
+{
+	GENERATED_BODY()
+
+	// Channel the component's collision response is checked against
+	UPROPERTY()
+	TEnumAsByte<ECollisionChannel> CollisionChannel = ECC_Pawn;
+
+	// Weakest response to the channel that still counts, block by default so overlap only volumes are skipped
+	UPROPERTY()
+	TEnumAsByte<ECollisionResponse> MinimumResponse = ECR_Block;
+
+	// Collision profiles that are always skipped
+	UPROPERTY()
+	TArray<FName> IgnoredCollisionProfiles;
+
+	// Skip components that can never affect navigation
+	UPROPERTY()
+	bool bRequireNavigationRelevance = true;
+
+	// Include components with movable mobility, static and stationary components are always included
+	UPROPERTY()
+	bool bIncludeMovable = false;
+
+	// Only components of these classes are included, empty for every class
+	UPROPERTY()
+	TArray<TSubclassOf<UPrimitiveComponent>> IncludedClasses;
+
+	// Components of these classes are always skipped
+	UPROPERTY()
+	TArray<TSubclassOf<UPrimitiveComponent>> ExcludedClasses;
+
+public:
+	FVoxelComponentFilter() = default;
+
+	bool PassesFilter(const UPrimitiveComponent* InComponent) const;
+
+	static TArray<UPrimitiveComponent*> GatherComponents(const UWorld* InWorld);
+
+private:
+	static bool IsAnyClass(const UPrimitiveComponent* InComponent, const TArray<TSubclassOf<UPrimitiveComponent>>& InClasses);
+};
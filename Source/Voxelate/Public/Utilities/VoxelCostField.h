@@ -0,0 +1,138 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelAttribute.h"
+#include "Data/VoxelNeighbourhood.h"
+#include "Data/VoxelOccupancy.h"
+#include "VoxelCostField.generated.h"
+
+/**
+ * Which steps along several axes at once are taken when a step along one of their axes is blocked
+ */
+UENUM()
+enum class EVoxelCornerCutting : uint8
+{
+	// Every step the connectivity allows is taken
+	Allow,
+	// A step along X and Y needs its steps along X and along Y traversable, for walkable layers where steps up and down are diagonal
+	PreventHorizontal,
+	// A step along several axes needs its step along each of them traversable
+	Prevent
+};
+
+/**
+ * Multi source shortest distances over traversable voxels, for influence maps such as threat, flee and scent
+ * The field only covers a region of the grid, usually the chunks around the agents that read it
+ *
+ * Each step into a voxel costs the voxel's step cost, edge and corner steps cost 1.4 and 1.7 times as much,
+ * distances saturate below Unreachable, the corner cutting rule decides which diagonal steps squeeze past blocked voxels
+ * The region is split into blocks, each block runs a dial queue (bucketed Dijkstra) in parallel with the others
+ * and hands the voxels it improves on its neighbours' faces over to them for the next round, until no block changes
+ *
+ * Sources can be added, moved and removed between updates, every voxel remembers the source its distance comes from
+ * so removing a source only clears and refills the voxels it reached
+ * Update is not thread safe, read the field from the thread that updates it or between updates
+ */
+class VOXELATE_API FVoxelCostField : public FNoncopyable
+{
+public:
+	// Distance of voxels no source reaches
+	static constexpr uint16 Unreachable = MAX_uint16;
+	// Step cost of every voxel when no step costs are given, leaves room for the longer diagonal steps
+	static constexpr uint8 DefaultStepCost = 10;
+	// Voxels along each axis of a block
+	static constexpr int32 BlockSize = 16;
+
+protected:
+	// Owner of voxels no source reaches, also caps the number of sources
+	static constexpr uint16 NoSource = MAX_uint16;
+
+	struct FSource
+	{
+		FIntVector Coordinate = FIntVector::ZeroValue;
+		uint16 InitialCost = 0;
+		bool bIsActive = false;
+	};
+
+	// A distance found for a voxel of another block, applied between rounds
+	struct FHandOver
+	{
+		int32 Index = INDEX_NONE;
+		uint16 Cost = 0;
+		uint16 Source = 0;
+	};
+
+	// The region of the parent grid the field covers
+	FVoxelBox Region;
+
+	// Copies of the traversable voxels and step costs inside the region, on the region's grid
+	FVoxelOccupancy Traversable;
+	TArray<uint8> StepCosts;
+
+	FVoxelNeighbourhood Neighbourhood;
+	EVoxelCornerCutting CornerCutting = EVoxelCornerCutting::Allow;
+
+	TVoxelAttribute<uint16> Costs;
+	TArray<uint16> Owners;
+
+	FIntVector BlockCount = FIntVector::ZeroValue;
+	// Voxels whose distance was lowered from outside their block and still have to be spread, per block
+	TArray<TArray<int32>> PendingVoxels;
+
+	TArray<FSource> Sources;
+	TArray<uint16> FreeSources;
+
+	// Changes waiting for the next update, removals keep the coordinate the source had when it was applied
+	TArray<TPair<uint16, FIntVector>> PendingRemovals;
+	TArray<uint16> PendingAdditions;
+	TArray<uint16> PendingFrees;
+
+public:
+	FVoxelCostField(const FVoxelOccupancy& InTraversable, const FVoxelBox& InRegion,
+		const EVoxelConnectivity InConnectivity = EVoxelConnectivity::Face, const TVoxelAttribute<uint8>* InStepCosts = nullptr,
+		const EVoxelCornerCutting InCornerCutting = EVoxelCornerCutting::Allow);
+
+	static FVoxelBox GetRegionAround(const FVoxelOccupancy& InOccupancy, const TArray<FVector>& InLocations, const int32 InChunkRadius);
+
+	const FVoxelBox& GetRegion() const;
+	const TVoxelAttribute<uint16>& GetCosts() const;
+	uint16 GetCost(const FIntVector& InCoordinate) const;
+	uint16 GetCost(const FVector& InLocation) const;
+	bool CanStep(const FIntVector& InLocalCoordinate, const FIntVector& InOffset) const;
+
+	int32 AddSource(const FIntVector& InCoordinate, const uint16 InInitialCost = 0);
+	void MoveSource(const int32 InSource, const FIntVector& InCoordinate, const uint16 InInitialCost = 0);
+	void RemoveSource(const int32 InSource);
+	void Update();
+
+protected:
+	void ClearSource(const uint16 InSource, const FIntVector& InCoordinate);
+	void SeedSource(const uint16 InSource);
+	void SpreadBlock(const FIntVector& InBlockCoordinate, TArray<int32>& InOutSeeds, TArray<FHandOver>& OutHandOvers);
+	int32 GetBlockIndex(const FIntVector& InLocalCoordinate) const;
+	int32 GetStepCost(const FIntVector& InOffset, const int32 InIndex) const;
+};
@@ -0,0 +1,140 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/CapsuleProxy.h"
+#include "Data/OOBBoxProxy.h"
+#include "Data/SphereProxy.h"
+#include "Data/TriangleProxy.h"
+#include "Data/VoxelAttribute.h"
+#include "Data/VoxelChunkStore.h"
+#include "Data/VoxelSummedVolume.h"
+#include "Utilities/VoxelAgentBaker.h"
+#include "Utilities/VoxelExposureBaker.h"
+#include "VoxelEditor.generated.h"
+
+/**
+ * How an edit combines a shape with the occupancy
+ */
+UENUM()
+enum class EVoxelEditOperation : uint8
+{
+	// Occupies every voxel inside the shape
+	Add,
+	// Clears every voxel inside the shape
+	Subtract
+};
+
+/**
+ * What an edit changed
+ */
+struct VOXELATE_API FVoxelEditResult
+{
+	// false if the edit changed no voxel or lost every commit attempt to other writers
+	bool bCommitted = false;
+
+	// The store version the edit was published as
+	int64 Version = 0;
+
+	// The smallest box holding every changed voxel
+	FVoxelBox ChangedBox;
+
+	// The chunks the edit cloned, every other chunk is still shared with the previous version
+	TArray<FIntVector> ChangedChunks;
+};
+
+/**
+ * Boolean edits of shapes into a chunk store, for destructible environments and runtime construction
+ * A voxel is inside a shape when its center is, closed triangle meshes use the even-odd rule along X
+ *
+ * An edit only clones the chunks whose voxels actually change and commits them as a new store version,
+ * then brings the editor's dense copy of the occupancy and every registered derived layer up to date,
+ * each derived layer only over the changed voxels grown by its kernel radius
+ * Versions committed by other writers, undo and redo are picked up the same way by Sync, a chunk at a time
+ *
+ * Edits, Sync and the derived layers are not thread safe, use the editor and read its layers from one thread,
+ * other threads read the store itself
+ */
+class VOXELATE_API FVoxelEditor : public FNoncopyable
+{
+public:
+	// Rebakes a derived layer inside a box from the editor's occupancy, the box is already grown by the layer's kernel radius
+	using FUpdateFunction = TFunction<void(const FVoxelOccupancy& InOccupancy, const FVoxelBox& InVoxelBox)>;
+
+	// Attempts at committing an edit before giving up on a contended store
+	static constexpr int32 MaxCommitAttempts = 8;
+
+protected:
+	struct FDerivedLayer
+	{
+		int32 Handle = INDEX_NONE;
+		FIntVector KernelRadius = FIntVector::ZeroValue;
+		FUpdateFunction Update;
+	};
+
+	FVoxelChunkStore& Store;
+
+	// Dense copy of the store's version Mirrored, what derived layers are baked from
+	FVoxelOccupancy Occupancy;
+	FVoxelChunkStore::FMapPtr Mirrored;
+
+	TArray<FDerivedLayer> DerivedLayers;
+	int32 NextHandle = 0;
+
+public:
+	explicit FVoxelEditor(FVoxelChunkStore& InStore);
+
+	const FVoxelOccupancy& GetOccupancy() const;
+	int64 GetVersion() const;
+
+	int32 AddDerivedLayer(const FIntVector& InKernelRadius, FUpdateFunction&& InUpdate);
+	int32 AddSummedVolume(FVoxelSummedVolume& InOutVolume);
+	int32 AddWalkableLayer(const FVoxelAgentProfile& InProfile, FVoxelOccupancy& InOutWalkable);
+	int32 AddExposureLayer(const FVoxelExposureBaker& InBaker, TVoxelAttribute<uint8>& InOutExposure);
+	bool RemoveDerivedLayer(const int32 InHandle);
+
+	FVoxelEditResult ApplySphere(const FSphereProxy& InSphere, const EVoxelEditOperation InOperation);
+	FVoxelEditResult ApplyCapsule(const FCapsuleProxy& InCapsule, const EVoxelEditOperation InOperation);
+	FVoxelEditResult ApplyBox(const FOOBBoxProxy& InBox, const EVoxelEditOperation InOperation);
+	FVoxelEditResult ApplyMesh(const TArray<FTriangleProxy>& InTriangles, const EVoxelEditOperation InOperation);
+
+	bool Undo();
+	bool Redo();
+	FVoxelBox Sync();
+
+protected:
+	// Gets the voxels of a chunk row inside the shape, bit X - ChunkMin.X for voxel X, only MinX to MaxX need to be filled
+	using FRowFunction = TFunctionRef<uint64(const FIntVector& InChunkMin, const int32 Y, const int32 Z, const int32 MinX, const int32 MaxX)>;
+
+	FVoxelEditResult Apply(const FBox& InBounds, const EVoxelEditOperation InOperation, FRowFunction GetShapeRow);
+	FVoxelEditResult ApplyPoints(const FBox& InBounds, const EVoxelEditOperation InOperation, TFunctionRef<bool(const FVector&)> IsInside);
+	void EditChunks(FVoxelChunkMap& InOutEdit, const FVoxelBox& InVoxelBox, const EVoxelEditOperation InOperation, FRowFunction GetShapeRow,
+		FVoxelEditResult& OutResult) const;
+
+	FVoxelBox SyncTo(const FVoxelChunkStore::FMapPtr& InVersion, const FVoxelEditResult* InEdit);
+	void UpdateDerivedLayers(const FVoxelBox& InChangedBox);
+	FVector GetVoxelCenter(const FIntVector& InCoordinate) const;
+};
@@ -0,0 +1,54 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelAttribute.h"
+#include "Data/VoxelOccupancy.h"
+#include "VoxelExporter.generated.h"
+
+/**
+ * Writes voxel occupancy to file formats used by tools outside the engine
+ * Every exporter streams straight from the occupancy's words, nothing is expanded to one value per voxel in memory
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelExporter
+{
+	GENERATED_BODY()
+
+	// Largest model MagicaVoxel supports along each axis
+	static constexpr int32 VoxModelSize = 256;
+
+public:
+	static bool ExportRaw(const FVoxelOccupancy& InOccupancy, const FString& InFilename);
+	static bool ExportVox(const FVoxelOccupancy& InOccupancy, const FString& InFilename, const TVoxelAttribute<uint8>* InColorIndices = nullptr);
+
+private:
+	static FString GetRawHeader(const FVoxelOccupancy& InOccupancy);
+	static int32 CountVoxModel(const FVoxelOccupancy& InOccupancy, const FVoxelBox& InModelBox);
+	static void WriteVoxModel(FArchive& Ar, const FVoxelOccupancy& InOccupancy, const FVoxelBox& InModelBox, const int32 InNumVoxels,
+		const TVoxelAttribute<uint8>* InColorIndices);
+	static void WriteVoxSceneGraph(FArchive& Ar, const TArray<FVoxelBox>& InModelBoxes);
+};
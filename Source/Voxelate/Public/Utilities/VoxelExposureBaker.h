@@ -0,0 +1,62 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelAttribute.h"
+#include "Data/VoxelOccupancy.h"
+#include "VoxelExposureBaker.generated.h"
+
+/**
+ * Bakes how exposed the air next to geometry is, for audio occlusion and lighting heuristics
+ * Surface voxels are empty voxels with at least one occupied face neighbour
+ * Their exposure is the fraction of short rays over the hemisphere facing away from the geometry that escape
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelExposureBaker
+{
+	GENERATED_BODY()
+
+	// Number of directions spread over the whole sphere, roughly half of them are used per voxel
+	UPROPERTY()
+	int32 NumDirections = 64;
+
+	// Length of each ray in voxels, a ray that travels this far unblocked counts as open air
+	UPROPERTY()
+	double RayLength = 8.0;
+
+public:
+	FVoxelExposureBaker() = default;
+	FVoxelExposureBaker(const int32 InNumDirections, const double InRayLength);
+
+	TVoxelAttribute<uint8> Bake(const FVoxelOccupancy& InOccupancy) const;
+	void Update(const FVoxelOccupancy& InOccupancy, const FVoxelBox& InVoxelBox, TVoxelAttribute<uint8>& InOutExposure) const;
+	int32 GetKernelRadius() const;
+
+private:
+	TArray<FVector> GetDirections() const;
+	uint8 GetExposure(const FVoxelOccupancy& InOccupancy, const FIntVector& InCoordinate, const uint32 InNeighbourhoodMask,
+		const TArray<FVector>& InDirections) const;
+};
@@ -0,0 +1,49 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelOccupancy.h"
+#include "VoxelFloodFill.generated.h"
+
+/**
+ * Finds the empty voxels reachable from a set of seeds, moving through face neighbours only
+ * Works a whole word (64 voxels along X) at a time, chunks are filled in parallel rounds
+ * where each round only touches chunks on the frontier of the previous one
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelFloodFill
+{
+	GENERATED_BODY()
+
+public:
+	static FVoxelOccupancy GetReachable(const FVoxelOccupancy& InOccupancy, const TArray<FIntVector>& InSeeds);
+	static FVoxelOccupancy GetReachable(const FVoxelOccupancy& InOccupancy, const TArray<FVector>& InSeedLocations);
+
+private:
+	static bool FillChunk(const FVoxelOccupancy& InOccupancy, FVoxelOccupancy& Reachable, const FIntVector& InChunkCoordinate);
+	static void GatherChunkSeeds(const FVoxelOccupancy& InOccupancy, const FVoxelOccupancy& Reachable, const FIntVector& InChunkCoordinate,
+		const TArray<uint8>& InChangedChunks, TArray<TPair<int32, uint64>>& OutSeeds);
+};
@@ -0,0 +1,149 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelAttribute.h"
+#include "Data/VoxelOccupancy.h"
+#include "VoxelFlowField.generated.h"
+
+class FVoxelCostField;
+
+/**
+ * Which directions a flow field steers along
+ */
+UENUM()
+enum class EVoxelFlowDirections : uint8
+{
+	// The 8 compass directions, for agents walking on a walkable layer, steps up and down are left to the agent's movement
+	Planar8,
+	// The 26 neighbour directions, for agents flying through empty voxels
+	Spatial26
+};
+
+/**
+ * Steering directions towards a single goal for every traversable voxel of a region
+ * The integration field is the step cost distance to the goal, spread as a wavefront by FVoxelCostField,
+ * every voxel then points at its cheapest neighbour it can step to, chunks are resolved in parallel
+ * Directions are stored as neighbourhood mask bits, see FVoxelNeighbourhood, so an agent steers with a single lookup
+ *
+ * Only the chunks the goal can be reached from are stored, 3 bytes per voxel or 768 KB for a whole chunk,
+ * a thin walkable layer usually only reaches one or two chunks of each column
+ * Building also holds 4 bytes per voxel of the whole region for the wavefront
+ */
+class VOXELATE_API FVoxelFlowField : public FNoncopyable
+{
+public:
+	// Direction of voxels with nowhere to go, the goal itself and voxels the goal can't be reached from
+	static constexpr uint8 NoDirection = 13;
+
+protected:
+	// A chunk of the region, both arrays are empty when the goal can't be reached from any of its voxels
+	struct FChunk
+	{
+		TArray<uint16> Integration;
+		TArray<uint8> Directions;
+	};
+
+	FIntVector Goal = FIntVector::ZeroValue;
+	FVoxelBox Region;
+
+	// The region's own grid, chunks are counted from the region's first voxel
+	FVoxelGrid Grid;
+	FIntVector ChunkCount = FIntVector::ZeroValue;
+	TArray<FChunk> Chunks;
+
+public:
+	FVoxelFlowField(const FVoxelOccupancy& InTraversable, const FIntVector& InGoal, const FVoxelBox& InRegion,
+		const EVoxelFlowDirections InDirections, const TVoxelAttribute<uint8>* InStepCosts = nullptr);
+
+	const FIntVector& GetGoal() const;
+	const FVoxelBox& GetRegion() const;
+	SIZE_T GetAllocatedSize() const;
+
+	uint16 GetCost(const FIntVector& InCoordinate) const;
+	uint8 GetDirectionBit(const FIntVector& InCoordinate) const;
+	FVector GetDirection(const FVector& InLocation) const;
+
+	static FIntVector GetDirectionOffset(const uint8 InDirectionBit);
+
+protected:
+	void ResolveChunk(const FVoxelCostField& InCostField, const int32 InChunkIndex, const bool bIsPlanar, TConstArrayView<FIntVector> InOffsets);
+	FVoxelBox GetChunkBox(const int32 InChunkIndex) const;
+	bool FindVoxel(const FIntVector& InCoordinate, int32& OutChunkIndex, int32& OutIndex) const;
+};
+
+/**
+ * Flow fields shared by every agent heading to the same goal, built on first use and kept for the most recently used goals
+ * Fields are immutable once built, agents hold on to a field and read it from any thread
+ * GetField is thread safe, fields for different goals may be built at the same time
+ *
+ * A field covers the cube of chunks within ChunkRadius of its goal's chunk, the defaults keep at most 8 fields
+ * of 27 chunks each, about 21 MB per field when the goal can be reached from every chunk, see FVoxelFlowField
+ *
+ * The cache doesn't see edits of the traversable voxels, call Invalidate with the changed voxels,
+ * e.g. from a derived layer registered with FVoxelEditor
+ */
+class VOXELATE_API FVoxelFlowFieldCache : public FNoncopyable
+{
+public:
+	using FFieldPtr = TSharedPtr<const FVoxelFlowField, ESPMode::ThreadSafe>;
+
+protected:
+	struct FEntry
+	{
+		FFieldPtr Field;
+		uint64 LastUsed = 0;
+	};
+
+	const FVoxelOccupancy& Traversable;
+	const TVoxelAttribute<uint8>* StepCosts = nullptr;
+
+	EVoxelFlowDirections Directions = EVoxelFlowDirections::Planar8;
+	// Chunks around the goal's chunk a field covers, INDEX_NONE covers the whole grid
+	int32 ChunkRadius = 1;
+	int32 MaxFields = 8;
+
+	mutable FCriticalSection Lock;
+	TMap<FIntVector, FEntry> Fields;
+	uint64 UseCount = 0;
+	// Bumped by every invalidation, a field whose build overlapped one may have read stale voxels and isn't kept
+	uint64 Generation = 0;
+
+public:
+	FVoxelFlowFieldCache(const FVoxelOccupancy& InTraversable, const EVoxelFlowDirections InDirections, const int32 InChunkRadius = 1,
+		const int32 InMaxFields = 8, const TVoxelAttribute<uint8>* InStepCosts = nullptr);
+
+	FFieldPtr GetField(const FIntVector& InGoal);
+	FFieldPtr GetField(const FVector& InGoalLocation);
+
+	void Invalidate(const FVoxelBox& InChangedBox);
+	void Empty();
+	int32 Num() const;
+
+protected:
+	FVoxelBox GetRegion(const FIntVector& InGoal) const;
+	void Trim();
+};
@@ -0,0 +1,83 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/CapsuleProxy.h"
+#include "Data/OOBBoxProxy.h"
+#include "Data/VoxelSummedVolume.h"
+#include "VoxelPlacement.generated.h"
+
+/**
+ * Finds the nearest place a shape fits, for spawning and teleport fix ups
+ * Candidate centers are voxel centers visited in growing shells around the seed voxel,
+ * each candidate is checked in constant time against the summed volume table of the shape's axis aligned bounds
+ * The search stops as soon as no later shell can beat the best placement found so far
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelPlacement
+{
+	GENERATED_BODY()
+
+public:
+	static bool FindNearestFree(const FVoxelSummedVolume& InVolume, const FVector& InSeedLocation, const FVector& InExtent,
+		const int32 InMaxRadius, FVector& OutLocation, const bool bRequireSupport = false);
+	static bool FindNearestFree(const FVoxelSummedVolume& InVolume, const FOOBBoxProxy& InBox,
+		const int32 InMaxRadius, FVector& OutLocation, const bool bRequireSupport = false);
+	static bool FindNearestFree(const FVoxelSummedVolume& InVolume, const FCapsuleProxy& InCapsule,
+		const int32 InMaxRadius, FVector& OutLocation, const bool bRequireSupport = false);
+
+	static FVector GetExtent(const FOOBBoxProxy& InBox);
+	static FVector GetExtent(const FCapsuleProxy& InCapsule);
+
+private:
+	static FIntVector GetHalfSize(const FVoxelGrid& InGrid, const FVector& InExtent);
+	static bool Fits(const FVoxelSummedVolume& InVolume, const FIntVector& InCoordinate, const FIntVector& InHalfSize, const bool bRequireSupport);
+
+	/**
+	 * Calls a function for every coordinate at exactly a Chebyshev distance from a center
+	 * @param InCenter The center coordinate
+	 * @param InRadius The distance, 0 visits only the center
+	 * @param Function Called with each coordinate
+	 */
+	template<typename FunctionType>
+	static void ForEachShellCoordinate(const FIntVector& InCenter, const int32 InRadius, FunctionType&& Function)
+	{
+		for(int32 Z = -InRadius; Z <= InRadius; Z++)
+		{
+			for(int32 Y = -InRadius; Y <= InRadius; Y++)
+			{
+				// Inner rows only touch the shell at both ends
+				const bool bFullRow = FMath::Abs(Z) == InRadius || FMath::Abs(Y) == InRadius;
+				const int32 Step = bFullRow ? 1 : FMath::Max(2 * InRadius, 1);
+
+				for(int32 X = -InRadius; X <= InRadius; X += Step)
+				{
+					Function(InCenter + FIntVector(X, Y, Z));
+				}
+			}
+		}
+	}
+};
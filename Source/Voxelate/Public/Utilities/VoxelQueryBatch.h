@@ -0,0 +1,80 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelBox.h"
+#include "Data/VoxelChunkStore.h"
+#include "Data/VoxelGrid.h"
+#include "Data/VoxelOccupancy.h"
+#include "Data/VoxelSummedVolume.h"
+
+/**
+ * Collects many small point and box occupancy queries and answers them all at once
+ * Requests are sorted by the Morton code of their first voxel, so requests in the same chunk are answered together,
+ * then answered in parallel batches, each result goes to its request's own slot
+ *
+ * Typical use is one batch per frame: add every agent's queries, Execute, read the results, Reset
+ * Executing on a chunk store pins one epoch for the whole batch, so a concurrent edit can't free chunks mid batch
+ */
+class VOXELATE_API FVoxelQueryBatch
+{
+public:
+	// Requests answered by a single parallel task
+	static constexpr int32 BatchSize = 256;
+
+protected:
+	FVoxelGrid Grid;
+
+	// The voxels of each request, a point is a single voxel box
+	TArray<FVoxelBox> Boxes;
+	TArray<uint64> Keys;
+	TArray<int32> Counts;
+
+public:
+	FVoxelQueryBatch() = default;
+	explicit FVoxelQueryBatch(const FVoxelGrid& InGrid);
+
+	void Reset();
+	void Reserve(const int32 InNumRequests);
+	int32 Num() const;
+
+	int32 AddPoint(const FIntVector& InCoordinate);
+	int32 AddPoint(const FVector& InLocation);
+	int32 AddBox(const FVoxelBox& InVoxelBox);
+	int32 AddBox(const FBox& InBounds);
+
+	void Execute(const FVoxelOccupancy& InOccupancy, const FVoxelSummedVolume* InVolume = nullptr);
+	void Execute(const FVoxelChunkStore& InStore);
+
+	int32 GetCount(const int32 InRequest) const;
+	bool IsOccupied(const int32 InRequest) const;
+	const TArray<int32>& GetCounts() const;
+
+protected:
+	void ExecuteRequests(TFunctionRef<int32(const FVoxelBox&)> CountBox);
+
+	static uint64 GetMortonKey(const FIntVector& InCoordinate);
+};
@@ -0,0 +1,103 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelAttribute.h"
+#include "Data/VoxelOccupancy.h"
+#include "VoxelSurfaceExtractor.generated.h"
+
+/**
+ * How the surface is placed inside each cell
+ */
+UENUM()
+enum class EVoxelSurfaceMethod : uint8
+{
+	// One vertex per crossed cell edge, smooth but rounds off sharp features
+	MarchingCubes,
+	// One vertex per crossed cell placed by a QEF over the edge crossings, keeps corners and creases
+	DualContouring
+};
+
+/**
+ * The surface of a single chunk, vertices are shared between the chunk's triangles
+ * Triangles are wound so (B - A) ^ (C - A) points out of the solid
+ */
+struct VOXELATE_API FVoxelSurfaceMesh
+{
+	FIntVector ChunkCoordinate = FIntVector::ZeroValue;
+
+	// Vertex positions in world space, vertices on a chunk border are bitwise equal to the neighbouring chunk's
+	TArray<FVector> Positions;
+	TArray<FVector3f> Normals;
+	TArray<uint32> Indices;
+
+	bool IsEmpty() const;
+	int32 NumTriangles() const;
+	bool GetCompactIndices(TArray<uint16>& OutIndices) const;
+};
+
+/**
+ * Extracts a smooth surface from occupancy or coverage values
+ * Values are sampled at voxel centers and cells span eight neighbouring centers, voxels outside the grid count as empty
+ * so surfaces are closed at the grid's border
+ *
+ * Every chunk is extracted on its own and in parallel. A chunk owns the cells starting in it and samples a margin of
+ * its neighbours, so shared border vertices come out identical and chunk meshes join without seams.
+ * A change to the values affects the meshes of the chunks within KernelRadius voxels of it
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelSurfaceExtractor
+{
+	GENERATED_BODY()
+
+	// Voxels a value change can reach into neighbouring meshes, cells plus the gradient and dual contouring margins
+	static constexpr int32 KernelRadius = 2;
+
+	UPROPERTY()
+	EVoxelSurfaceMethod Method = EVoxelSurfaceMethod::MarchingCubes;
+
+	// Values at or above this are inside, must be above 0 so the outside of the grid is empty
+	UPROPERTY()
+	float IsoValue = 0.5f;
+
+	// Dual contouring drops QEF eigenvalues below this fraction of the largest, higher pulls vertices to the cell's mass point
+	UPROPERTY()
+	float SingularThreshold = 0.1f;
+
+public:
+	FVoxelSurfaceExtractor() = default;
+	FVoxelSurfaceExtractor(const EVoxelSurfaceMethod InMethod, const float InIsoValue = 0.5f);
+
+	TArray<FVoxelSurfaceMesh> Extract(const FVoxelOccupancy& InOccupancy) const;
+	TArray<FVoxelSurfaceMesh> Extract(const TVoxelAttribute<float>& InCoverage) const;
+
+	FVoxelSurfaceMesh ExtractChunk(const FVoxelOccupancy& InOccupancy, const FIntVector& InChunkCoordinate) const;
+	FVoxelSurfaceMesh ExtractChunk(const TVoxelAttribute<float>& InCoverage, const FIntVector& InChunkCoordinate) const;
+
+protected:
+	TArray<FVoxelSurfaceMesh> ExtractChunks(const FVoxelGrid& InGrid, TFunctionRef<float(const FIntVector&)> Sample) const;
+	FVoxelSurfaceMesh ExtractChunk(const FVoxelGrid& InGrid, const FIntVector& InChunkCoordinate, TFunctionRef<float(const FIntVector&)> Sample) const;
+};
@@ -0,0 +1,63 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/VoxelOccupancy.h"
+#include "Data/VoxelVisibility.h"
+#include "VoxelVisibilityBaker.generated.h"
+
+/**
+ * Precomputes chunk to chunk visibility from voxel occupancy
+ * Rays are cast between empty voxels of each pair of chunks through the occupancy, no physics traces involved
+ * The result is conservative for neighbouring chunks and sampled for everything else
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelVisibilityBaker
+{
+	GENERATED_BODY()
+
+	// Rays cast between a pair of chunks before they are considered hidden from each other
+	UPROPERTY()
+	int32 RaysPerChunkPair = 32;
+
+	// Chunks further apart than this (in chunks, any axis) are never visible, 0 for no limit
+	UPROPERTY()
+	int32 MaxChunkDistance = 0;
+
+	// Seed used to pick the ray end points
+	UPROPERTY()
+	int32 Seed = 0;
+
+public:
+	FVoxelVisibilityBaker() = default;
+	FVoxelVisibilityBaker(const int32 InRaysPerChunkPair, const int32 InMaxChunkDistance = 0);
+
+	FVoxelVisibility Bake(const FVoxelOccupancy& InOccupancy) const;
+
+private:
+	TArray<FVector> GetChunkSamples(const FVoxelOccupancy& InOccupancy, const int32 InChunkIndex) const;
+	bool IsChunkPairVisible(const FVoxelOccupancy& InOccupancy, const TArray<FVector>& InSamplesA, const TArray<FVector>& InSamplesB) const;
+};
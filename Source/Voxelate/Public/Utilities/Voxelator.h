@@ -31,15 +31,103 @@
 #include "Data/SphereProxy.h"
 #include "Data/TriangleProxy.h"
 #include "Data/VoxelGrid.h"
+#include "Data/VoxelLayers.h"
+#include "Data/VoxelOccupancy.h"
 #include "PhysicsEngine/BoxElem.h"
 #include "PhysicsEngine/ConvexElem.h"
+#include "Utilities/VoxelComponentFilter.h"
 #include "Voxelator.generated.h"
 
+class UBodySetup;
+class ULandscapeHeightfieldCollisionComponent;
+class UStaticMesh;
+
+/**
+ * Kind of collision shape gathered for rasterization
+ */
+enum class EVoxelatorShape : uint8
+{
+	Box,
+	Sphere,
+	Capsule,
+	Triangle,
+	Landscape
+};
+
+/**
+ * A named occupancy layer and the filter deciding which components it holds
+ */
+USTRUCT()
+struct VOXELATE_API FVoxelatorLayer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FName Name;
+
+	UPROPERTY()
+	FVoxelComponentFilter Filter;
+
+public:
+	FVoxelatorLayer() = default;
+	FVoxelatorLayer(const FName InName, const FVoxelComponentFilter& InFilter);
+};
+
+/**
+ * Heights of a landscape sampled once per voxel column, so rasterizing on worker threads never queries the landscape
+ * Columns are addressed by lattice coordinates, so the shapes must be rasterized into a grid on the lattice they were gathered for
+ */
+struct VOXELATE_API FVoxelatorHeightfield
+{
+	const ALandscapeProxy* Landscape = nullptr;
+
+	// Lattice coordinates of the first column
+	FIntPoint LatticeMin = FIntPoint::ZeroValue;
+
+	// Number of columns along X and Y
+	FIntPoint Size = FIntPoint::ZeroValue;
+
+	// Height of every column laid out X then Y, lowest float where the landscape has no height
+	TArray<float> Heights;
+};
+
+/**
+ * World space collision shapes of the candidate components, ready to be rasterized
+ * Every shape has an entry holding its kind, its index into the matching array, its world bounds
+ * and the mask of layers its component belongs to
+ */
+struct VOXELATE_API FVoxelatorShapes
+{
+	struct FEntry
+	{
+		EVoxelatorShape Shape = EVoxelatorShape::Box;
+		int32 Index = INDEX_NONE;
+		FBox Bounds = FBox(ForceInit);
+		uint16 LayerMask = 1;
+	};
+
+	TArray<FOOBBoxProxy> Boxes;
+	TArray<FSphereProxy> Spheres;
+	TArray<FCapsuleProxy> Capsules;
+	TArray<FTriangleProxy> Triangles;
+	TArray<FVoxelatorHeightfield> Landscapes;
+
+	TArray<FEntry> Entries;
+
+	void AddBox(const FOOBBoxProxy& InBox);
+	void AddSphere(const FSphereProxy& InSphere);
+	void AddCapsule(const FCapsuleProxy& InCapsule);
+	void AddTriangle(const FTriangleProxy& InTriangle);
+	void AddLandscape(const ALandscapeProxy* InLandscape, const FBox& InBounds);
+	void Append(const FVoxelatorShapes& Other);
+	void SampleLandscapes(const FVoxelGrid& InVoxelGrid);
+};
+
 /**
- * TODO: Implement functionality to voxelate the world based on navigable geometry
- * TODO: Implement multithreaded batching
+ * Voxelates the navigable geometry of a world
+ * Candidate components are picked by the filter, their collision is gathered into world space shapes,
+ * then every chunk of the occupancy is rasterized in parallel from the shapes overlapping it
  * TODO: Implement a way to efficiently visualize the voxelated results - debug draw too expensive
- * TODO: Figure out the best way to store the voxelated results? Here? Some other object? Sparse Voxel Tree?
  */
 USTRUCT()
 struct VOXELATE_API FVoxelator
@@ -48,20 +136,39 @@ struct VOXELATE_API FVoxelator
 
 	UPROPERTY()
 	TObjectPtr<UWorld> World = nullptr;
+
+	// Number of tasks parallel work is split into, 0 for as many as the task graph likes
+	UPROPERTY()
+	int32 NumWorkers = 0;
+
+	// Decides which components are voxelated
+	UPROPERTY()
+	FVoxelComponentFilter Filter;
 	
 public:
 	FVoxelator(UWorld* InWorld);
+	FVoxelator(UWorld* InWorld, const int32 InNumWorkers);
+	FVoxelator(UWorld* InWorld, const int32 InNumWorkers, const FVoxelComponentFilter& InFilter);
 	
 	TArray<bool> VoxelateNavigableGeometry(const FVoxelGrid& InVoxelGrid);
+	FVoxelOccupancy Voxelate(const FVoxelGrid& InVoxelGrid);
+	FVoxelLayers VoxelateLayers(const FVoxelGrid& InVoxelGrid, const TArray<FVoxelatorLayer>& InLayers);
+
+	FVoxelatorShapes GatherShapes(const FVoxelGrid& InVoxelGrid) const;
+	FVoxelatorShapes GatherShapes(const FVoxelGrid& InVoxelGrid, const TArray<FVoxelatorLayer>& InLayers) const;
+	void Rasterize(const FVoxelatorShapes& InShapes, FVoxelOccupancy& OutOccupancy) const;
+	void Rasterize(const FVoxelatorShapes& InShapes, FVoxelLayers& OutLayers) const;
 
 private:
-	void ProcessPrimitiveComponent(UPrimitiveComponent* InPrimitiveComponent, const FVoxelGrid& InVoxelGrid);
+	void ProcessPrimitiveComponent(UPrimitiveComponent* InPrimitiveComponent, FVoxelatorShapes& OutShapes) const;
+	void ProcessBodySetup(const UBodySetup& BodySetup, const FTransform& InstanceTransform, FVoxelatorShapes& OutShapes) const;
+	void ProcessStaticMesh(const UStaticMesh& StaticMesh, TConstArrayView<FTransform> InstanceTransforms, FVoxelatorShapes& OutShapes) const;
 
-	void ProcessLandscape(ULandscapeHeightfieldCollisionComponent& LandscapeComponent, const FVoxelGrid& LocalVoxelGrid, const FTransform& InstanceTransform);
+	void ProcessLandscape(const ULandscapeHeightfieldCollisionComponent& LandscapeComponent, FVoxelatorShapes& OutShapes) const;
 	
-	void ProcessCollisionBox(const FKBoxElem& BoxElement, const FVoxelGrid& LocalVoxelGrid, const FTransform& InstanceTransform);
-	void ProcessCollisionSphere(const FKSphereElem& SphereElement, const FVoxelGrid& LocalVoxelGrid, const FTransform& InstanceTransform);
-	void ProcessCollisionCapsule(const FKSphylElem& CapsuleElement, const FVoxelGrid& LocalVoxelGrid, const FTransform& InstanceTransform);
-	void ProcessCollisionConvex(const FKConvexElem& ConvexElement, const FVoxelGrid& LocalVoxelGrid, const FTransform& InstanceTransform);
+	void ProcessCollisionBox(const FKBoxElem& BoxElement, const FTransform& InstanceTransform, FVoxelatorShapes& OutShapes) const;
+	void ProcessCollisionSphere(const FKSphereElem& SphereElement, const FTransform& InstanceTransform, FVoxelatorShapes& OutShapes) const;
+	void ProcessCollisionCapsule(const FKSphylElem& CapsuleElement, const FTransform& InstanceTransform, FVoxelatorShapes& OutShapes) const;
+	void ProcessCollisionConvex(const FKConvexElem& ConvexElement, const FTransform& InstanceTransform, FVoxelatorShapes& OutShapes) const;
 };
 
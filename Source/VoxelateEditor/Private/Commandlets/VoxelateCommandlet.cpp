@@ -0,0 +1,541 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Commandlets/VoxelateCommandlet.h"
+
+#include "Engine/Level.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "Utilities/VoxelChunkFile.h"
+#include "Utilities/VoxelChunkWriter.h"
+#include "Utilities/Voxelator.h"
+
+#include "WorldPartition/WorldPartition.h"
+#include "WorldPartition/LoaderAdapter/LoaderAdapterShape.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVoxelateCommandlet, Log, All);
+
+UVoxelateCommandlet::UVoxelateCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+	ShowErrorCount = true;
+}
+
+/**
+ * Runs the commandlet, see the class comment for the parameters
+ * @param Params The commandlet's command line
+ * @return 0 if every map was voxelated and written, 1 otherwise
+ */
+int32 UVoxelateCommandlet::Main(const FString& Params)
+{
+	FSettings Settings;
+
+	if(!ParseSettings(Params, Settings))
+	{
+		UE_LOG(LogVoxelateCommandlet, Error, TEXT("Usage: -run=Voxelate -Maps=/Game/A+/Game/B -VoxelSize=<Size> [-Output=<Directory>] "
+			"[-Bounds=MinX,MinY,MinZ,MaxX,MaxY,MaxZ] [-Lattice=OriginX,OriginY,OriginZ,CountX,CountY,CountZ] "
+			"[-Workers=<N>] [-Processes=<N>] [-Compression=Oodle|Zlib|None]"));
+		return 1;
+	}
+
+	UE_LOG(LogVoxelateCommandlet, Display, TEXT("Voxelating %d maps at %.2f with %d processes and %d workers into %s"),
+		Settings.MapNames.Num(), Settings.VoxelSize.X, Settings.NumProcesses, Settings.NumWorkers, *Settings.OutputDirectory);
+
+	TArray<FMapResult> Results;
+
+	for(const FString& MapName : Settings.MapNames)
+	{
+		Results.Add(Settings.NumProcesses > 1 ? VoxelateDistributed(MapName, Settings) : VoxelateLocal(MapName, Settings));
+	}
+
+	LogSummary(Results);
+
+	return Results.ContainsByPredicate([](const FMapResult& Result) { return !Result.bSucceeded; }) ? 1 : 0;
+}
+
+/**
+ * Parses the command line
+ * @param Params The commandlet's command line
+ * @param OutSettings The settings
+ * @return false if a required parameter is missing or a parameter is malformed
+ */
+bool UVoxelateCommandlet::ParseSettings(const FString& Params, FSettings& OutSettings)
+{
+	auto ParseSixValues = [&Params](const TCHAR* InMatch, double OutValues[6])
+	{
+		FString Param;
+
+		if(!FParse::Value(*Params, InMatch, Param, false))
+		{
+			return false;
+		}
+
+		TArray<FString> Values;
+		Param.ParseIntoArray(Values, TEXT(","));
+
+		for(int32 Index = 0; Index < 6; Index++)
+		{
+			OutValues[Index] = Values.IsValidIndex(Index) ? FCString::Atod(*Values[Index]) : 0.0;
+		}
+
+		return Values.Num() == 6;
+	};
+
+	FString MapsParam;
+	double VoxelSize = 0.0;
+
+	if(!FParse::Value(*Params, TEXT("Maps="), MapsParam, false) || !FParse::Value(*Params, TEXT("VoxelSize="), VoxelSize) || VoxelSize <= 0.0)
+	{
+		return false;
+	}
+
+	MapsParam.ParseIntoArray(OutSettings.MapNames, TEXT("+"));
+	OutSettings.VoxelSize = FVector(VoxelSize);
+
+	double Values[6];
+
+	if(FCString::Stristr(*Params, TEXT("-Bounds=")))
+	{
+		if(!ParseSixValues(TEXT("Bounds="), Values))
+		{
+			return false;
+		}
+
+		OutSettings.Bounds = FBox(FVector(Values[0], Values[1], Values[2]), FVector(Values[3], Values[4], Values[5]));
+	}
+
+	if(FCString::Stristr(*Params, TEXT("-Lattice=")))
+	{
+		if(!ParseSixValues(TEXT("Lattice="), Values))
+		{
+			return false;
+		}
+
+		OutSettings.bHasLattice = true;
+		OutSettings.LatticeOrigin = FIntVector(FMath::RoundToInt(Values[0]), FMath::RoundToInt(Values[1]), FMath::RoundToInt(Values[2]));
+		OutSettings.LatticeCount = FIntVector(FMath::RoundToInt(Values[3]), FMath::RoundToInt(Values[4]), FMath::RoundToInt(Values[5]));
+	}
+
+	OutSettings.OutputDirectory = FPaths::ProjectSavedDir() / TEXT("Voxelate");
+	FParse::Value(*Params, TEXT("Output="), OutSettings.OutputDirectory);
+	OutSettings.OutputDirectory = FPaths::ConvertRelativePathToFull(OutSettings.OutputDirectory);
+
+	FParse::Value(*Params, TEXT("Workers="), OutSettings.NumWorkers);
+	FParse::Value(*Params, TEXT("Processes="), OutSettings.NumProcesses);
+	OutSettings.NumWorkers = FMath::Max(OutSettings.NumWorkers, 0);
+	OutSettings.NumProcesses = FMath::Max(OutSettings.NumProcesses, 1);
+
+	OutSettings.CompressionName = TEXT("Oodle");
+	FParse::Value(*Params, TEXT("Compression="), OutSettings.CompressionName);
+
+	return OutSettings.MapNames.Num() > 0;
+}
+
+/**
+ * Voxelates a map in this process and writes its chunk file
+ * @param InMapName The map's package name
+ * @param InSettings The settings
+ * @return What happened
+ */
+UVoxelateCommandlet::FMapResult UVoxelateCommandlet::VoxelateLocal(const FString& InMapName, const FSettings& InSettings)
+{
+	FMapResult Result;
+	Result.MapName = InMapName;
+
+	double StartTime = FPlatformTime::Seconds();
+
+	const FBox Region = InSettings.bHasLattice ?
+		FVoxelGrid(InSettings.VoxelSize, InSettings.LatticeOrigin, InSettings.LatticeCount).GetBounds() : InSettings.Bounds;
+
+	UWorld* World = LoadWorld(InMapName, Region, true);
+
+	if(!World)
+	{
+		UE_LOG(LogVoxelateCommandlet, Error, TEXT("Couldn't load map %s"), *InMapName);
+		return Result;
+	}
+
+	FVoxelGrid Grid;
+
+	if(!GetGrid(InMapName, InSettings, World, Grid))
+	{
+		UnloadWorld(World);
+		return Result;
+	}
+
+	Result.LoadSeconds = FPlatformTime::Seconds() - StartTime;
+	StartTime = FPlatformTime::Seconds();
+
+	const FVoxelOccupancy Occupancy = FVoxelator(World, InSettings.NumWorkers).Voxelate(Grid);
+
+	Result.VoxelateSeconds = FPlatformTime::Seconds() - StartTime;
+	Result.NumVoxels = int64(Grid.GetVectorVoxelCount().X) * Grid.GetVectorVoxelCount().Y * Grid.GetVectorVoxelCount().Z;
+	Result.NumOccupied = Occupancy.CountOccupied();
+	Result.NumChunks = Occupancy.GetNumChunks();
+
+	UnloadWorld(World);
+
+	StartTime = FPlatformTime::Seconds();
+
+	const FString Filename = GetOutputFilename(InMapName, InSettings);
+	const FName CompressionFormat = InSettings.CompressionName.Equals(TEXT("None"), ESearchCase::IgnoreCase) ? NAME_None : FName(*InSettings.CompressionName);
+	FVoxelChunkWriter Writer(Occupancy, CompressionFormat);
+
+	if(Writer.Open(Filename))
+	{
+		Writer.WriteAllChunks();
+		Result.bSucceeded = Writer.Close();
+	}
+
+	Result.WriteSeconds = FPlatformTime::Seconds() - StartTime;
+	Result.FileSize = IFileManager::Get().FileSize(*Filename);
+
+	if(!Result.bSucceeded)
+	{
+		UE_LOG(LogVoxelateCommandlet, Error, TEXT("Couldn't write %s"), *Filename);
+	}
+
+	return Result;
+}
+
+/**
+ * Splits a map's grid into chunk ranges along its longest axis, voxelates each range in its own worker process
+ * and merges the workers' chunk files into the map's chunk file
+ * @param InMapName The map's package name
+ * @param InSettings The settings
+ * @return What happened, occupied voxels aren't counted
+ */
+UVoxelateCommandlet::FMapResult UVoxelateCommandlet::VoxelateDistributed(const FString& InMapName, const FSettings& InSettings)
+{
+	FMapResult Result;
+	Result.MapName = InMapName;
+	Result.NumOccupied = INDEX_NONE;
+
+	double StartTime = FPlatformTime::Seconds();
+
+	// The map only has to be loaded here if the grid comes from its bounds, its actors are left to the workers
+	FVoxelGrid Grid;
+	UWorld* World = InSettings.bHasLattice || InSettings.Bounds.IsValid ? nullptr : LoadWorld(InMapName, FBox(ForceInit), false);
+	const bool bHasGrid = GetGrid(InMapName, InSettings, World, Grid);
+
+	if(World)
+	{
+		UnloadWorld(World);
+	}
+
+	if(!bHasGrid)
+	{
+		return Result;
+	}
+
+	Result.LoadSeconds = FPlatformTime::Seconds() - StartTime;
+	StartTime = FPlatformTime::Seconds();
+
+	const FIntVector Count = Grid.GetVectorVoxelCount();
+	const FIntVector ChunkCount(
+		FMath::DivideAndRoundUp(Count.X, FVoxelOccupancy::ChunkSize),
+		FMath::DivideAndRoundUp(Count.Y, FVoxelOccupancy::ChunkSize),
+		FMath::DivideAndRoundUp(Count.Z, FVoxelOccupancy::ChunkSize));
+	const int32 Axis = ChunkCount.X >= ChunkCount.Y ? (ChunkCount.X >= ChunkCount.Z ? 0 : 2) : (ChunkCount.Y >= ChunkCount.Z ? 1 : 2);
+	const int32 NumParts = FMath::Min(InSettings.NumProcesses, ChunkCount[Axis]);
+	const int32 NumWorkers = InSettings.NumWorkers > 0 ? InSettings.NumWorkers : FMath::Max(FPlatformMisc::NumberOfCoresIncludingHyperthreads() / NumParts, 1);
+
+	const FString ShortName = FPackageName::GetShortName(InMapName);
+	const FString PartsDirectory = InSettings.OutputDirectory / TEXT("Parts") / ShortName;
+	const FString ProjectArgument = FPaths::IsProjectFilePathSet() ?
+		FString::Printf(TEXT("\"%s\" "), *FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath())) : FString();
+
+	TArray<FString> PartFilenames;
+	TArray<FProcHandle> Processes;
+	bool bSpawnedAll = true;
+
+	for(int32 Part = 0; Part < NumParts; Part++)
+	{
+		// Ranges start on chunk boundaries, so each worker's chunks are exactly the coordinator's chunks
+		FIntVector Offset = FIntVector::ZeroValue;
+		FIntVector PartCount = Count;
+		Offset[Axis] = ChunkCount[Axis] * Part / NumParts * FVoxelOccupancy::ChunkSize;
+		PartCount[Axis] = FMath::Min(ChunkCount[Axis] * (Part + 1) / NumParts * FVoxelOccupancy::ChunkSize, Count[Axis]) - Offset[Axis];
+
+		const FVoxelGrid PartGrid = Grid.GetSubGrid(Offset, PartCount);
+		const FIntVector PartOrigin = PartGrid.GetLatticeOrigin();
+		const FString PartDirectory = PartsDirectory / FString::Printf(TEXT("Part%d"), Part);
+
+		const FString Arguments = ProjectArgument + FString::Printf(
+			TEXT("-run=Voxelate -Maps=%s -VoxelSize=%.17g -Lattice=%d,%d,%d,%d,%d,%d -Output=\"%s\" -Workers=%d -Compression=%s -nullrhi -unattended -nopause -nosplash"),
+			*InMapName, InSettings.VoxelSize.X, PartOrigin.X, PartOrigin.Y, PartOrigin.Z, PartCount.X, PartCount.Y, PartCount.Z,
+			*PartDirectory, NumWorkers, *InSettings.CompressionName);
+
+		FProcHandle Process = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Arguments, false, true, true, nullptr, 0, nullptr, nullptr);
+
+		if(!Process.IsValid())
+		{
+			UE_LOG(LogVoxelateCommandlet, Error, TEXT("Couldn't start worker %d for %s"), Part, *InMapName);
+			bSpawnedAll = false;
+			break;
+		}
+
+		UE_LOG(LogVoxelateCommandlet, Display, TEXT("Started worker %d for %s on %s"), Part, *ShortName, *PartGrid.GetVoxelBox().ToString());
+
+		Processes.Add(Process);
+		PartFilenames.Add(PartDirectory / ShortName + TEXT(".vxc"));
+	}
+
+	bool bWorkersSucceeded = bSpawnedAll;
+
+	for(int32 Part = 0; Part < Processes.Num(); Part++)
+	{
+		if(!bSpawnedAll)
+		{
+			FPlatformProcess::TerminateProc(Processes[Part], true);
+		}
+
+		FPlatformProcess::WaitForProc(Processes[Part]);
+
+		int32 ReturnCode = 0;
+
+		if(!FPlatformProcess::GetProcReturnCode(Processes[Part], &ReturnCode) || ReturnCode != 0)
+		{
+			UE_LOG(LogVoxelateCommandlet, Error, TEXT("Worker %d for %s failed with %d"), Part, *ShortName, ReturnCode);
+			bWorkersSucceeded = false;
+		}
+
+		FPlatformProcess::CloseProc(Processes[Part]);
+	}
+
+	Result.VoxelateSeconds = FPlatformTime::Seconds() - StartTime;
+	Result.NumVoxels = int64(Count.X) * Count.Y * Count.Z;
+	Result.NumChunks = ChunkCount.X * ChunkCount.Y * ChunkCount.Z;
+
+	StartTime = FPlatformTime::Seconds();
+
+	const FString Filename = GetOutputFilename(InMapName, InSettings);
+	Result.bSucceeded = bWorkersSucceeded && FVoxelChunkFile::Merge(PartFilenames, Grid, Filename);
+
+	IFileManager::Get().DeleteDirectory(*PartsDirectory, false, true);
+
+	Result.WriteSeconds = FPlatformTime::Seconds() - StartTime;
+	Result.FileSize = IFileManager::Get().FileSize(*Filename);
+
+	if(bWorkersSucceeded && !Result.bSucceeded)
+	{
+		UE_LOG(LogVoxelateCommandlet, Error, TEXT("Couldn't merge the chunk files of %s into %s"), *ShortName, *Filename);
+	}
+
+	return Result;
+}
+
+/**
+ * Gets the grid to voxelate a map with, from -Lattice, -Bounds or the world's bounds in that order
+ * @param InMapName The map's package name
+ * @param InSettings The settings
+ * @param InWorld The loaded map, only needed without -Lattice or -Bounds
+ * @param OutGrid The grid
+ * @return false if there are no bounds to build the grid from
+ */
+bool UVoxelateCommandlet::GetGrid(const FString& InMapName, const FSettings& InSettings, UWorld* InWorld, FVoxelGrid& OutGrid)
+{
+	if(InSettings.bHasLattice)
+	{
+		OutGrid.Init(InSettings.VoxelSize, InSettings.LatticeOrigin, InSettings.LatticeCount);
+		return true;
+	}
+
+	const FBox Bounds = InSettings.Bounds.IsValid ? InSettings.Bounds : (InWorld ? GetWorldBounds(InWorld) : FBox(ForceInit));
+
+	if(!Bounds.IsValid)
+	{
+		UE_LOG(LogVoxelateCommandlet, Error, TEXT("Map %s has no bounds, pass -Bounds or -Lattice"), *InMapName);
+		return false;
+	}
+
+	OutGrid.Init(InSettings.VoxelSize, Bounds);
+
+	return true;
+}
+
+/**
+ * Gets the chunk file a map is written to
+ * @param InMapName The map's package name
+ * @param InSettings The settings
+ * @return The chunk file
+ */
+FString UVoxelateCommandlet::GetOutputFilename(const FString& InMapName, const FSettings& InSettings)
+{
+	return InSettings.OutputDirectory / FPackageName::GetShortName(InMapName) + TEXT(".vxc");
+}
+
+/**
+ * Loads a map with every streaming level and registers its components
+ * World partition maps load the actors inside the region, or inside the world's bounds without one,
+ * the same bounds GetGrid falls back to
+ * @param InMapName The map's package name
+ * @param InRegion The world bounds that will be voxelated, invalid if unknown
+ * @param bLoadActors Load the world partition actors, only the always loaded actors are loaded otherwise
+ * @return The world, rooted until it's unloaded, or nullptr if the map couldn't be loaded
+ */
+UWorld* UVoxelateCommandlet::LoadWorld(const FString& InMapName, const FBox& InRegion, const bool bLoadActors)
+{
+	UPackage* Package = LoadPackage(nullptr, *InMapName, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+
+	if(!World)
+	{
+		return nullptr;
+	}
+
+	World->AddToRoot();
+
+	if(!World->bIsWorldInitialized)
+	{
+		World->WorldType = EWorldType::Editor;
+		World->InitWorld(UWorld::InitializationValues()
+			.AllowAudioPlayback(false)
+			.CreateAISystem(false)
+			.CreateNavigation(false)
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(false));
+	}
+
+	for(ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+	{
+		if(StreamingLevel)
+		{
+			StreamingLevel->SetShouldBeLoaded(true);
+			StreamingLevel->SetShouldBeVisible(true);
+		}
+	}
+
+	World->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+	World->UpdateWorldComponents(true, false);
+
+	if(bLoadActors && World->IsPartitionedWorld())
+	{
+		// Without bounds nothing is loaded and GetGrid fails, rather than voxelating only the always loaded actors
+		const FBox LoadRegion = InRegion.IsValid ? InRegion : GetWorldBounds(World);
+
+		if(LoadRegion.IsValid)
+		{
+			RegionLoader = new FLoaderAdapterShape(World, LoadRegion, TEXT("Voxelate"));
+			RegionLoader->Load();
+		}
+	}
+
+	return World;
+}
+
+/**
+ * Releases a world loaded by LoadWorld
+ * @param InWorld The world
+ */
+void UVoxelateCommandlet::UnloadWorld(UWorld* InWorld)
+{
+	if(RegionLoader)
+	{
+		RegionLoader->Unload();
+		delete RegionLoader;
+		RegionLoader = nullptr;
+	}
+
+	InWorld->CleanupWorld();
+	InWorld->RemoveFromRoot();
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+/**
+ * Gets the bounds of a world, from its world partition if it has one or every loaded level otherwise
+ * @param InWorld The world
+ * @return The bounds, invalid if there are none
+ */
+FBox UVoxelateCommandlet::GetWorldBounds(UWorld* InWorld)
+{
+	if(const UWorldPartition* WorldPartition = InWorld->GetWorldPartition())
+	{
+		return WorldPartition->GetEditorWorldBounds();
+	}
+
+	FBox Bounds(ForceInit);
+
+	for(const ULevel* Level : InWorld->GetLevels())
+	{
+		if(Level)
+		{
+			const FBox LevelBounds = ALevelBounds::CalculateLevelBounds(Level);
+
+			if(LevelBounds.IsValid)
+			{
+				Bounds += LevelBounds;
+			}
+		}
+	}
+
+	return Bounds;
+}
+/**
+ * Logs a line per map and the totals
+ * @param InResults The result of every map
+ */
+void UVoxelateCommandlet::LogSummary(const TArray<FMapResult>& InResults)
+{
+	FMapResult Total;
+	int32 NumSucceeded = 0;
+
+	UE_LOG(LogVoxelateCommandlet, Display, TEXT("%-40s %14s %14s %8s %10s %10s %10s %10s"),
+		TEXT("Map"), TEXT("Voxels"), TEXT("Occupied"), TEXT("Chunks"), TEXT("Load s"), TEXT("Voxelate s"), TEXT("Write s"), TEXT("MB"));
+
+	for(const FMapResult& Result : InResults)
+	{
+		// Maps voxelated by worker processes don't know their occupied count
+		const FString Occupied = Result.NumOccupied == INDEX_NONE ? TEXT("-") : FString::Printf(TEXT("%lld"), Result.NumOccupied);
+
+		UE_LOG(LogVoxelateCommandlet, Display, TEXT("%-40s %14lld %14s %8d %10.2f %10.2f %10.2f %10.2f%s"),
+			*FPackageName::GetShortName(Result.MapName), Result.NumVoxels, *Occupied, Result.NumChunks,
+			Result.LoadSeconds, Result.VoxelateSeconds, Result.WriteSeconds, FMath::Max<int64>(Result.FileSize, 0) / (1024.0 * 1024.0),
+			Result.bSucceeded ? TEXT("") : TEXT(" FAILED"));
+
+		NumSucceeded += Result.bSucceeded ? 1 : 0;
+		Total.NumVoxels += Result.NumVoxels;
+		Total.NumOccupied += FMath::Max<int64>(Result.NumOccupied, 0);
+		Total.NumChunks += Result.NumChunks;
+		Total.FileSize += FMath::Max<int64>(Result.FileSize, 0);
+		Total.LoadSeconds += Result.LoadSeconds;
+		Total.VoxelateSeconds += Result.VoxelateSeconds;
+		Total.WriteSeconds += Result.WriteSeconds;
+	}
+
+	UE_LOG(LogVoxelateCommandlet, Display, TEXT("%-40s %14lld %14lld %8d %10.2f %10.2f %10.2f %10.2f"),
+		*FString::Printf(TEXT("Total (%d/%d succeeded)"), NumSucceeded, InResults.Num()), Total.NumVoxels, Total.NumOccupied, Total.NumChunks,
+		Total.LoadSeconds, Total.VoxelateSeconds, Total.WriteSeconds, Total.FileSize / (1024.0 * 1024.0));
+}
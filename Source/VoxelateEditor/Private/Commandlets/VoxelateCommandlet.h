@@ -0,0 +1,110 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "Data/VoxelGrid.h"
+#include "VoxelateCommandlet.generated.h"
+
+class FLoaderAdapterShape;
+
+/**
+ * Voxelates a list of maps headless and writes a chunk file per map
+ *
+ * UnrealEditor-Cmd <Project> -run=Voxelate -Maps=/Game/Maps/A+/Game/Maps/B -VoxelSize=50 -nullrhi -unattended
+ *		[-Output=<Directory>] Where the chunk files go, defaults to Saved/Voxelate
+ *		[-Bounds=MinX,MinY,MinZ,MaxX,MaxY,MaxZ] World bounds to voxelate, defaults to each map's level bounds
+ *		[-Lattice=OriginX,OriginY,OriginZ,CountX,CountY,CountZ] Exact grid on the voxel lattice, overrides -Bounds
+ *		[-Workers=<N>] Number of tasks parallel work is split into per process, defaults to the task graph's choice
+ *		[-Processes=<N>] Splits each grid into N chunk ranges voxelated by N worker processes, defaults to 1
+ *		[-Compression=Oodle|Zlib|None] How chunks are compressed, defaults to Oodle
+ *
+ * With -Processes the commandlet is the coordinator: each worker is this commandlet run on a single chunk range with -Lattice,
+ * writing its own chunk file, and the coordinator merges the files. Chunk files are the only thing shared,
+ * so workers don't have to run on this machine as long as the files come back
+ */
+UCLASS()
+class UVoxelateCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+	/**
+	 * Settings parsed from the command line
+	 */
+	struct FSettings
+	{
+		TArray<FString> MapNames;
+		FVector VoxelSize = FVector::ZeroVector;
+		FBox Bounds = FBox(ForceInit);
+		bool bHasLattice = false;
+		FIntVector LatticeOrigin = FIntVector::ZeroValue;
+		FIntVector LatticeCount = FIntVector::ZeroValue;
+		FString OutputDirectory;
+		int32 NumWorkers = 0;
+		int32 NumProcesses = 1;
+		FString CompressionName;
+	};
+
+	/**
+	 * What happened to a single map
+	 */
+	struct FMapResult
+	{
+		FString MapName;
+		bool bSucceeded = false;
+		int64 NumVoxels = 0;
+		// INDEX_NONE when the map was voxelated by worker processes
+		int64 NumOccupied = 0;
+		int32 NumChunks = 0;
+		int64 FileSize = 0;
+		double LoadSeconds = 0.0;
+		double VoxelateSeconds = 0.0;
+		double WriteSeconds = 0.0;
+	};
+
+	// Keeps the actors of a world partition map inside the grid loaded
+	FLoaderAdapterShape* RegionLoader = nullptr;
+
+public:
+	UVoxelateCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	static bool ParseSettings(const FString& Params, FSettings& OutSettings);
+
+	FMapResult VoxelateLocal(const FString& InMapName, const FSettings& InSettings);
+	FMapResult VoxelateDistributed(const FString& InMapName, const FSettings& InSettings);
+
+	bool GetGrid(const FString& InMapName, const FSettings& InSettings, UWorld* InWorld, FVoxelGrid& OutGrid);
+	static FString GetOutputFilename(const FString& InMapName, const FSettings& InSettings);
+
+	UWorld* LoadWorld(const FString& InMapName, const FBox& InRegion, const bool bLoadActors);
+	void UnloadWorld(UWorld* InWorld);
+	static FBox GetWorldBounds(UWorld* InWorld);
+
+	static void LogSummary(const TArray<FMapResult>& InResults);
+};
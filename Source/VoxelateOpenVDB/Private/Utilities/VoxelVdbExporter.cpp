@@ -0,0 +1,104 @@
+﻿/**
+ * MIT License
+ *
+ * Copyright (c) 2024 Ryan Sweeney
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "Utilities/VoxelVdbExporter.h"
+
+THIRD_PARTY_INCLUDES_START
+#pragma push_macro("check")
+#undef check
+#include <openvdb/openvdb.h>
+#pragma pop_macro("check")
+THIRD_PARTY_INCLUDES_END
+
+/**
+ * Exports the occupancy as an OpenVDB bool grid named "occupancy"
+ * Index coordinates are the grid's lattice coordinates and the transform maps them to world space
+ * The sparse tree is built chunk by chunk and pruned before writing, empty chunks are skipped
+ * @param InOccupancy The occupancy to export
+ * @param InFilename The file to write, usually .vdb
+ * @return false if the file couldn't be written
+ */
+bool FVoxelVdbExporter::ExportVdb(const FVoxelOccupancy& InOccupancy, const FString& InFilename)
+{
+	try
+	{
+		openvdb::initialize();
+
+		const FVector VoxelSize = InOccupancy.GetGrid().GetVoxelSize();
+		const FIntVector LatticeOrigin = InOccupancy.GetGrid().GetLatticeOrigin();
+
+		const openvdb::BoolGrid::Ptr VdbGrid = openvdb::BoolGrid::create(false);
+		VdbGrid->setName("occupancy");
+
+		// VDB puts voxel centres on whole index coordinates, the lattice puts voxel corners there
+		const openvdb::math::Transform::Ptr Transform = openvdb::math::Transform::createLinearTransform();
+		Transform->preScale(openvdb::Vec3d(VoxelSize.X, VoxelSize.Y, VoxelSize.Z));
+		Transform->postTranslate(openvdb::Vec3d(VoxelSize.X, VoxelSize.Y, VoxelSize.Z) * 0.5);
+		VdbGrid->setTransform(Transform);
+
+		openvdb::BoolGrid::Accessor Accessor = VdbGrid->getAccessor();
+		const TArray<uint64>& Words = InOccupancy.GetWords();
+
+		for(int32 ChunkIndex = 0; ChunkIndex < InOccupancy.GetNumChunks(); ChunkIndex++)
+		{
+			const FIntVector ChunkCoordinate = InOccupancy.GetChunkCoordinate(ChunkIndex);
+
+			if(InOccupancy.IsChunkEmpty(ChunkCoordinate))
+			{
+				continue;
+			}
+
+			const FVoxelBox ChunkBox = InOccupancy.GetChunkBox(ChunkCoordinate);
+
+			for(int32 Z = ChunkBox.Min.Z; Z < ChunkBox.Max.Z; Z++)
+			{
+				for(int32 Y = ChunkBox.Min.Y; Y < ChunkBox.Max.Y; Y++)
+				{
+					for(uint64 Word = Words[InOccupancy.GetRowWordIndex(Y, Z) + ChunkCoordinate.X]; Word != 0; Word &= Word - 1)
+					{
+						const int32 X = ChunkBox.Min.X + FMath::CountTrailingZeros64(Word);
+						Accessor.setValueOn(openvdb::Coord(LatticeOrigin.X + X, LatticeOrigin.Y + Y, LatticeOrigin.Z + Z), true);
+					}
+				}
+			}
+		}
+
+		// Full chunks collapse to tiles
+		VdbGrid->tree().prune();
+
+		openvdb::GridCPtrVec Grids;
+		Grids.push_back(VdbGrid);
+
+		openvdb::io::File File(TCHAR_TO_UTF8(*InFilename));
+		File.write(Grids);
+		File.close();
+	}
+	catch(const std::exception&)
+	{
+		return false;
+	}
+
+	return true;
+}
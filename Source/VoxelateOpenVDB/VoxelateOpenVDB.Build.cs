@@ -0,0 +1,31 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class VoxelateOpenVDB : ModuleRules
+{
+	public VoxelateOpenVDB(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"Voxelate",
+			}
+			);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"OpenVDB",
+			}
+			);
+
+		// OpenVDB relies on both, which is why it lives in its own module
+		bUseRTTI = true;
+		bEnableExceptions = true;
+	}
+}